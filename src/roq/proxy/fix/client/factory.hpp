@@ -2,10 +2,6 @@
 
 #pragma once
 
-#include <memory>
-
-#include "roq/proxy/fix/shared.hpp"
-
 #include "roq/proxy/fix/client/session.hpp"
 
 namespace roq {
@@ -13,8 +9,10 @@ namespace proxy {
 namespace fix {
 namespace client {
 
+// note! sessions are pooled, the factory only attaches a new connection
+
 struct Factory {
-  virtual std::unique_ptr<Session> create(Session::Handler &, uint64_t session_id, Shared &) = 0;
+  virtual void open(Session &, uint64_t session_id) = 0;
 };
 
 }  // namespace client
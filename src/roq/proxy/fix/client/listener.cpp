@@ -38,9 +38,9 @@ void Listener::operator()(io::net::tcp::Connection::Factory &factory) {
     explicit Bridge(io::net::tcp::Connection::Factory &factory) : factory_{factory} {}
 
    protected:
-    std::unique_ptr<Session> create(Session::Handler &handler, uint64_t session_id, Shared &shared) override {
+    void open(Session &session, uint64_t session_id) override {
       log::info("Connected (session_id={})"sv, session_id);
-      return std::make_unique<Session>(handler, session_id, factory_, shared);
+      session.open(session_id, factory_);
     }
 
    private:
@@ -55,9 +55,9 @@ void Listener::operator()(io::net::tcp::Connection::Factory &factory, io::Networ
         : factory_{factory}, network_address_{network_address} {}
 
    protected:
-    std::unique_ptr<Session> create(Session::Handler &handler, uint64_t session_id, Shared &shared) override {
+    void open(Session &session, uint64_t session_id) override {
       log::info("Connected (session_id={}, peer={})"sv, session_id, network_address_.to_string_2());
-      return std::make_unique<Session>(handler, session_id, factory_, shared);
+      session.open(session_id, factory_);
     }
 
    private:
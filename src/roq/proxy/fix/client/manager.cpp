@@ -11,16 +11,21 @@ namespace proxy {
 namespace fix {
 namespace client {
 
-// === CONSTANTS ===
-
-namespace {
-auto const GARBAGE_COLLECTION_FREQUENCY = 1s;
-}
-
 // === IMPLEMENTATION ===
 
 Manager::Manager(Session::Handler &handler, Settings const &settings, io::Context &context, Shared &shared)
     : handler_{handler}, fix_listener_{*this, settings, context}, shared_{shared} {
+  auto size = settings.client.session_pool_size;
+  slots_.reserve(size);
+  free_slots_.reserve(size);
+  for (size_t i = 0; i < size; ++i) {
+    auto slot = Slot{
+        .session = std::make_unique<Session>(handler_, shared_),
+    };
+    slots_.emplace_back(std::move(slot));
+  }
+  for (auto i = size; i > 0; --i)
+    free_slots_.emplace_back(static_cast<uint32_t>(i - 1));
 }
 
 void Manager::operator()(Event<Start> const &) {
@@ -31,26 +36,59 @@ void Manager::operator()(Event<Stop> const &event) {
 }
 
 void Manager::operator()(Event<Timer> const &event) {
-  dispatch(event);
-  remove_zombies(event.value.now);
+  // note! only sessions with an expired deadline
+  shared_.session_timers(event.value.now, [&](auto session_id) {
+    find(session_id, [&](auto &session) { session(event); });
+  });
+  remove_zombies();
 }
 
 // fix::Listener::Handler
 
 void Manager::operator()(Factory &factory) {
-  auto session_id = ++shared_.next_session_id;
+  shared_.clock.update();
+  remove_zombies();  // note! return zombies to the pool before allocating
+  auto index = allocate();
+  auto &slot = slots_[index];
+  auto session_id = (static_cast<uint64_t>(slot.generation) << 32) | index;
   log::info("Adding session_id={}..."sv, session_id);
-  auto session = factory.create(handler_, session_id, shared_);
-  sessions_.try_emplace(session_id, std::move(session));
+  slot.used = true;
+  factory.open(*slot.session, session_id);
 }
 
 // utilities
 
-void Manager::remove_zombies(std::chrono::nanoseconds now) {
-  if (now < next_garbage_collection_)
-    return;
-  next_garbage_collection_ = now + GARBAGE_COLLECTION_FREQUENCY;
-  shared_.session_cleanup([&](auto session_id) { sessions_.erase(session_id); });
+// note! zombies are released as soon as we're no longer on their call stack, i.e. the next timer or accept callback
+void Manager::remove_zombies() {
+  shared_.session_cleanup([&](auto session_id) { release(session_id); });
+}
+
+uint32_t Manager::allocate() {
+  if (!std::empty(free_slots_)) {
+    auto index = free_slots_.back();
+    free_slots_.pop_back();
+    return index;
+  }
+  // note! pool exhausted, grow
+  auto index = static_cast<uint32_t>(std::size(slots_));
+  log::warn("Growing session pool (size={})"sv, index + 1);
+  auto slot = Slot{
+      .session = std::make_unique<Session>(handler_, shared_),
+  };
+  slots_.emplace_back(std::move(slot));
+  return index;
+}
+
+void Manager::release(uint64_t session_id) {
+  auto index = static_cast<uint32_t>(session_id);
+  assert(index < std::size(slots_));
+  auto &slot = slots_[index];
+  assert(slot.used);
+  assert(slot.generation == static_cast<uint32_t>(session_id >> 32));
+  (*slot.session).release();
+  slot.used = false;
+  ++slot.generation;
+  free_slots_.emplace_back(index);
 }
 
 }  // namespace client
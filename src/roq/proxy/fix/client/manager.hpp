@@ -4,6 +4,7 @@
 
 #include <chrono>
 #include <memory>
+#include <vector>
 
 #include "roq/start.hpp"
 #include "roq/stop.hpp"
@@ -33,22 +34,28 @@ struct Manager final : public Listener::Handler {
   void operator()(Event<Timer> const &);
 
   void dispatch(auto &value) {
-    for (auto &[_, item] : sessions_)
-      (*item)(value);
+    for (auto &item : slots_)
+      if (item.used)
+        (*item.session)(value);
   }
 
   template <typename Callback>
   void get_all_sessions(Callback callback) {
-    for (auto &[_, session] : sessions_)
-      callback(*session);
+    for (auto &item : slots_)
+      if (item.used)
+        callback(*item.session);
   }
 
+  // note! session_id is a handle: generation (high 32 bits) and slot index (low 32 bits)
   template <typename Callback>
   bool find(uint64_t session_id, Callback callback) {
-    auto iter = sessions_.find(session_id);
-    if (iter == std::end(sessions_))
+    auto index = static_cast<uint32_t>(session_id);
+    if (index >= std::size(slots_))
       return false;
-    callback(*(*iter).second);
+    auto &item = slots_[index];
+    if (!item.used || item.generation != static_cast<uint32_t>(session_id >> 32))
+      return false;
+    callback(*item.session);
     return true;
   }
 
@@ -58,14 +65,22 @@ struct Manager final : public Listener::Handler {
 
   // utilities
 
-  void remove_zombies(std::chrono::nanoseconds now);
+  void remove_zombies();
+
+  uint32_t allocate();
+  void release(uint64_t session_id);
 
  private:
   Session::Handler &handler_;
   Listener fix_listener_;
   Shared &shared_;
-  utils::unordered_map<uint64_t, std::unique_ptr<Session>> sessions_;
-  std::chrono::nanoseconds next_garbage_collection_ = {};
+  struct Slot final {
+    std::unique_ptr<Session> session;  // note! pooled
+    uint32_t generation = 1;  // note! session_id is never zero
+    bool used = {};
+  };
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> free_slots_;
 };
 
 }  // namespace client
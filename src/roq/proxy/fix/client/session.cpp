@@ -2,6 +2,9 @@
 
 #include "roq/proxy/fix/client/session.hpp"
 
+#include <array>
+#include <type_traits>
+
 #include <nameof.hpp>
 
 #include "roq/logging.hpp"
@@ -9,6 +12,7 @@
 #include "roq/exceptions.hpp"
 
 #include "roq/utils/chrono.hpp"  // hh_mm_ss
+#include "roq/utils/traits.hpp"
 #include "roq/utils/update.hpp"
 
 #include "roq/utils/debug/fix/message.hpp"
@@ -43,28 +47,75 @@ auto const ERROR_INVALID_ORIG_CL_ORD_ID = "INVALID_ORIG_CL_ORD_ID"sv;
 auto const ERROR_INVALID_LOGON_ENCRYPT_METHOD = "INVALID_LOGON_ENCRYPT_METHOD"sv;
 auto const ERROR_INVALID_LOGON_HEART_BT_INT = "INVALID_LOGON_HEART_BT_INT"sv;
 auto const ERROR_INVALID_LOGON_RESET_SEQ_NUM_FLAG = "INVALID_LOGON_RESET_SEQ_NUM_FLAG"sv;
+auto const ERROR_THROTTLED = "THROTTLED"sv;
+auto const ERROR_ACCOUNT_NOT_AUTHORIZED = "ACCOUNT_NOT_AUTHORIZED"sv;
 }  // namespace
 
 // === HELPERS ===
 
 namespace {
-auto create_logon_timeout(auto &settings) {
-  auto now = clock::get_system();
-  return now + settings.client.logon_timeout;
+auto create_logon_timeout(auto &shared) {
+  auto now = shared.clock.get_system();
+  return now + shared.settings.client.logon_timeout;
 }
 
 auto validate_req_id(auto &req_id) {
   static auto const web_safe = true;
   return utils::codec::Base64::is_valid(req_id, web_safe);
 }
+
+// note! requests routed upstream on behalf of the strategy (see add_party_ids)
+template <typename T>
+constexpr bool is_routed_with_party_ids() {
+  return std::is_same_v<T, codec::fix::OrderStatusRequest> || std::is_same_v<T, codec::fix::NewOrderSingle> ||
+         std::is_same_v<T, codec::fix::OrderCancelReplaceRequest> || std::is_same_v<T, codec::fix::OrderCancelRequest> ||
+         std::is_same_v<T, codec::fix::OrderMassStatusRequest> || std::is_same_v<T, codec::fix::OrderMassCancelRequest> ||
+         std::is_same_v<T, codec::fix::RequestForPositions> || std::is_same_v<T, codec::fix::TradeCaptureReportRequest>;
+}
+
+template <typename T>
+auto get_priority(tools::Outbox const &outbox, T const &value) {
+  if constexpr (utils::is_specialization<T, tools::Lazy>::value) {
+    return tools::Outbox::get_priority(T::value_type::MSG_TYPE);
+  } else {
+    return outbox.get_priority(value);
+  }
+}
 }  // namespace
 
 // === IMPLEMENTATION ===
 
-Session::Session(Handler &handler, uint64_t session_id, io::net::tcp::Connection::Factory &factory, Shared &shared)
-    : handler_{handler}, session_id_{session_id}, connection_{factory.create(*this)}, shared_{shared},
-      logon_timeout_{create_logon_timeout(shared_.settings)}, decode_buffer_(shared.settings.client.decode_buffer_size),
-      encode_buffer_(shared.settings.client.encode_buffer_size) {
+Session::Session(Handler &handler, Shared &shared) : handler_{handler}, shared_{shared} {
+}
+
+void Session::open(uint64_t session_id, io::net::tcp::Connection::Factory &factory) {
+  assert(state_ == State::ZOMBIE);
+  assert(!connection_);
+  session_id_ = session_id;
+  connection_ = factory.create(*this);
+  logon_timeout_ = create_logon_timeout(shared_);
+  (*this)(State::WAITING_LOGON);
+  schedule(logon_timeout_);
+}
+
+void Session::release() {
+  assert(state_ == State::ZOMBIE);
+  connection_.reset();
+  buffer_.drain(std::size(buffer_.data()));
+  logon_timeout_ = {};
+  outbound_ = {};
+  inbound_ = {};
+  comp_id_.clear();
+  comp_ids_.clear();
+  username_.clear();
+  user_response_timeout_ = {};
+  party_id_.clear();
+  party_ = {};
+  next_heartbeat_ = {};
+  waiting_for_heartbeat_ = {};
+  last_receive_ = {};
+  timer_ = {};
+  outbox_.clear();
 }
 
 void Session::operator()(Event<Stop> const &) {
@@ -77,6 +128,8 @@ void Session::operator()(Event<Timer> const &event) {
       if (logon_timeout_ < event.value.now) {
         log::warn("Closing connection (reason: client did not send a logon message)"sv);
         close();
+      } else {
+        schedule(logon_timeout_);
       }
       break;
     case WAITING_CREATE_ROUTE: {
@@ -86,28 +139,38 @@ void Session::operator()(Event<Timer> const &event) {
             .text = ERROR_USER_RESPONSE_TIMEOUT,
         };
         send_and_close<2>(logout);
+      } else {
+        schedule(user_response_timeout_);
       }
       break;
     }
-    case READY:
-      if (next_heartbeat_ < event.value.now) {
-        next_heartbeat_ = event.value.now + shared_.settings.client.heartbeat_freq;
-        if (waiting_for_heartbeat_) {
-          log::warn("Closing connection (reason: client did not send heartbeat)"sv);
-          auto logout = codec::fix::Logout{
-              .text = ERROR_MISSING_HEARTBEAT,
-          };
-          send_and_close<2>(logout);
-        } else {
-          auto test_req_id = fmt::format("{}"sv, event.value.now);  // XXX TODO something else
-          auto test_request = codec::fix::TestRequest{
-              .test_req_id = test_req_id,
-          };
-          send<4>(test_request);
-          waiting_for_heartbeat_ = true;
-        }
+    case READY: {
+      auto heartbeat_freq = shared_.settings.client.heartbeat_freq;
+      if (event.value.now < next_heartbeat_) {
+        // nothing
+      } else if (event.value.now < (last_receive_ + heartbeat_freq)) {
+        // note! no need to test a client which has recently sent us something
+        waiting_for_heartbeat_ = false;
+        next_heartbeat_ = last_receive_ + heartbeat_freq;
+      } else if (waiting_for_heartbeat_) {
+        log::warn("Closing connection (reason: client did not send heartbeat)"sv);
+        auto logout = codec::fix::Logout{
+            .text = ERROR_MISSING_HEARTBEAT,
+        };
+        send_and_close<2>(logout);
+        break;
+      } else {
+        next_heartbeat_ = event.value.now + heartbeat_freq;
+        auto test_req_id = fmt::format("{}"sv, event.value.now);  // XXX TODO something else
+        auto test_request = codec::fix::TestRequest{
+            .test_req_id = test_req_id,
+        };
+        send<4>(test_request);
+        waiting_for_heartbeat_ = true;
       }
+      schedule(next_heartbeat_);
       break;
+    }
     case WAITING_REMOVE_ROUTE: {
       assert(user_response_timeout_.count());
       if (user_response_timeout_ < event.value.now) {
@@ -116,6 +179,8 @@ void Session::operator()(Event<Timer> const &event) {
         };
         send_and_close<2>(logout);
         // XXX HANS release route
+      } else {
+        schedule(user_response_timeout_);
       }
       break;
     }
@@ -155,6 +220,8 @@ void Session::operator()(Trace<codec::fix::UserResponse> const &event) {
           log::debug("logon={}"sv, response);
           send<2>(response);
           (*this)(State::READY);
+          next_heartbeat_ = shared_.clock.get_system() + shared_.settings.client.heartbeat_freq;
+          schedule(next_heartbeat_);
           break;
         }
         default:
@@ -216,16 +283,38 @@ void Session::operator()(Trace<codec::fix::MarketDataRequestReject> const &event
     send<2>(market_data_request_reject);
 }
 
-void Session::operator()(Trace<codec::fix::MarketDataSnapshotFullRefresh> const &event) {
+void Session::operator()(
+    Trace<tools::Lazy<codec::fix::MarketDataSnapshotFullRefresh>> const &event, std::string_view const &md_req_id) {
   auto &[trace_info, market_data_snapshot_full_refresh] = event;
-  if (ready())
-    send<2>(market_data_snapshot_full_refresh);
+  if (!ready())
+    return;
+  if (shared_.settings.client.passthrough_market_data) {
+    std::array<tools::Splice::Replacement, 1> const replacements{{
+        {262, md_req_id},  // MDReqID
+    }};
+    send<2>(market_data_snapshot_full_refresh, market_data_snapshot_full_refresh.raw(), replacements);
+  } else {
+    auto market_data_snapshot_full_refresh_2 = market_data_snapshot_full_refresh.get();
+    market_data_snapshot_full_refresh_2.md_req_id = md_req_id;
+    send<2>(market_data_snapshot_full_refresh_2);
+  }
 }
 
-void Session::operator()(Trace<codec::fix::MarketDataIncrementalRefresh> const &event) {
+void Session::operator()(
+    Trace<tools::Lazy<codec::fix::MarketDataIncrementalRefresh>> const &event, std::string_view const &md_req_id) {
   auto &[trace_info, market_data_incremental_refresh] = event;
-  if (ready())
-    send<2>(market_data_incremental_refresh);
+  if (!ready())
+    return;
+  if (shared_.settings.client.passthrough_market_data) {
+    std::array<tools::Splice::Replacement, 1> const replacements{{
+        {262, md_req_id},  // MDReqID
+    }};
+    send<2>(market_data_incremental_refresh, market_data_incremental_refresh.raw(), replacements);
+  } else {
+    auto market_data_incremental_refresh_2 = market_data_incremental_refresh.get();
+    market_data_incremental_refresh_2.md_req_id = md_req_id;
+    send<2>(market_data_incremental_refresh_2);
+  }
 }
 
 void Session::operator()(Trace<codec::fix::OrderCancelReject> const &event) {
@@ -246,6 +335,22 @@ void Session::operator()(Trace<codec::fix::ExecutionReport> const &event) {
     send<2>(execution_report);
 }
 
+void Session::operator()(Trace<codec::fix::ExecutionReport> const &event, std::span<std::byte const> const &message) {
+  auto &[trace_info, execution_report] = event;
+  if (!ready())
+    return;
+  if (!shared_.settings.client.passthrough_execution_reports || std::empty(message)) {
+    send<2>(execution_report);
+    return;
+  }
+  // note! only the fields rewritten by the controller
+  std::array<tools::Splice::Replacement, 2> const replacements{{
+      {11, execution_report.cl_ord_id},
+      {41, execution_report.orig_cl_ord_id},
+  }};
+  send<2>(execution_report, message, replacements);
+}
+
 void Session::operator()(Trace<codec::fix::RequestForPositionsAck> const &event) {
   auto &[trace_info, request_for_positions_ack] = event;
   if (ready())
@@ -310,7 +415,9 @@ void Session::operator()(io::net::tcp::Connection::Read const &) {
   if (state_ == State::ZOMBIE)
     return;
   buffer_.append(*connection_);
+  last_receive_ = shared_.clock.update();  // note! sampled once for everything dispatched from here
   auto buffer = buffer_.data();
+  shared_.batch_begin();
   try {
     size_t total_bytes = 0;
     auto parser = [&](auto &message) {
@@ -326,6 +433,7 @@ void Session::operator()(io::net::tcp::Connection::Read const &) {
       auto bytes = roq::fix::Reader<FIX_VERSION>::dispatch(buffer, parser, logger);
       if (bytes == 0)
         break;
+      shared_.capture(tools::Capture::Direction::CLIENT_INBOUND, session_id_, buffer.subspan(0, bytes));
       if (shared_.settings.test.fix_debug) {
         auto message = buffer.subspan(0, bytes);
         log::info<0>("[session_id={}]: {}"sv, session_id_, utils::debug::fix::Message{message});
@@ -350,6 +458,10 @@ void Session::operator()(io::net::tcp::Connection::Read const &) {
     auto e = std::current_exception();
     log::fatal(R"(Unhandled exception: type="{}")"sv, typeid(e).name());
   }
+  // note! messages held for this (or any other) session are sent when the batch ends
+  auto flush = Flush{};
+  Trace event{trace_info, flush};
+  handler_(event, session_id_);
 }
 
 void Session::operator()(io::net::tcp::Connection::Disconnected const &) {
@@ -376,13 +488,21 @@ void Session::make_zombie() {
       return;
   }
   (*this)(State::ZOMBIE);
+  shared_.session_timers.remove(timer_);
+  timer_ = {};
   shared_.session_remove(session_id_);
 }
 
+void Session::schedule(std::chrono::nanoseconds deadline) {
+  shared_.session_timers.remove(timer_);
+  timer_ = shared_.session_timers.add(shared_.clock.get_system(), deadline, uint64_t{session_id_});
+}
+
 template <std::size_t level, typename T>
 void Session::send_and_close(T const &event) {
   assert(state_ != State::ZOMBIE);
-  auto sending_time = clock::get_realtime();
+  flush();  // note! held messages must be sent before the connection is closed
+  auto sending_time = shared_.clock.get_realtime();
   send<level>(event, sending_time);
   close();
 }
@@ -398,7 +518,7 @@ void Session::send(T const &event) {
   };
   assert(can_send());
 #endif
-  auto sending_time = clock::get_realtime();
+  auto sending_time = shared_.clock.get_realtime();
   send<level>(event, sending_time);
 }
 
@@ -406,16 +526,92 @@ template <std::size_t level, typename T>
 void Session::send(T const &event, std::chrono::nanoseconds sending_time) {
   log::info<level>("send (=> client): {}={}"sv, nameof::nameof_short_type<T>(), event);
   assert(!std::empty(comp_id_));
+  if (std::empty(comp_ids_)) [[unlikely]]
+    comp_ids_ = tools::Splice::create_comp_ids(shared_.settings.client.comp_id, comp_id_);
+  auto priority = get_priority(outbox_, event);
+  auto held = can_hold(priority);
+  // note! the session header is written by reframe (pre-serialized comp ids and cached sending time)
   auto header = roq::fix::Header{
       .version = FIX_VERSION,
       .msg_type = T::MSG_TYPE,
-      .sender_comp_id = shared_.settings.client.comp_id,
-      .target_comp_id = comp_id_,
-      .msg_seq_num = ++outbound_.msg_seq_num,  // note!
-      .sending_time = sending_time,
+      .sender_comp_id = {},
+      .target_comp_id = {},
+      .msg_seq_num = {},
+      .sending_time = {},
+  };
+  auto buffer = std::span{shared_.encode_buffer};
+  auto encoded = event.encode(header, buffer.subspan(tools::Splice::HEADROOM));
+  if (held) {
+    hold(priority, encoded, event);  // note! framed when flushed
+    return;
+  }
+  auto header_2 = tools::Splice::Header{
+      .comp_ids = comp_ids_,
+      .msg_seq_num = ++outbound_.msg_seq_num,
+      .sending_time = shared_.sending_time(sending_time),
   };
-  auto message = event.encode(header, encode_buffer_);
+  auto message = tools::Splice::reframe(buffer, encoded, header_2);
   (*connection_).send(message);
+  shared_.capture(tools::Capture::Direction::CLIENT_OUTBOUND, session_id_, message);
+}
+
+template <std::size_t level, typename T>
+void Session::send(
+    T const &event,
+    std::span<std::byte const> const &message,
+    std::span<tools::Splice::Replacement const> const &replacements) {
+  log::info<level>("send (=> client): {}={}"sv, nameof::nameof_short_type<T>(), event);
+  assert(!std::empty(comp_id_));
+  if (std::empty(comp_ids_)) [[unlikely]]
+    comp_ids_ = tools::Splice::create_comp_ids(shared_.settings.client.comp_id, comp_id_);
+  auto priority = get_priority(outbox_, event);
+  auto held = can_hold(priority);
+  auto header = tools::Splice::Header{
+      .comp_ids = comp_ids_,
+      .msg_seq_num = held ? 0 : ++outbound_.msg_seq_num,  // note! held messages are re-sequenced when flushed
+      .sending_time = shared_.sending_time(shared_.clock.get_realtime()),
+  };
+  auto message_2 = tools::Splice::encode(shared_.encode_buffer, message, header, replacements);
+  if (held) {
+    hold(priority, message_2, event);
+    return;
+  }
+  (*connection_).send(message_2);
+  shared_.capture(tools::Capture::Direction::CLIENT_OUTBOUND, session_id_, message_2);
+}
+
+bool Session::can_hold(tools::Outbox::Priority priority) const {
+  return shared_.settings.client.priority_outbox && shared_.batch() && tools::Outbox::hold(priority);
+}
+
+template <typename T>
+void Session::hold(tools::Outbox::Priority priority, std::span<std::byte const> const &message, T const &value) {
+  if (outbox_.empty())
+    shared_.session_flush(session_id_);
+  outbox_.push(priority, message, value);
+}
+
+void Session::flush() {
+  if (outbox_.empty())
+    return;
+  if (state_ == State::ZOMBIE) {
+    outbox_.clear();
+    return;
+  }
+  if (std::empty(comp_ids_)) [[unlikely]]
+    comp_ids_ = tools::Splice::create_comp_ids(shared_.settings.client.comp_id, comp_id_);
+  auto sending_time = shared_.sending_time(shared_.clock.get_realtime());
+  // note! only the session header is rewritten (in-place)
+  outbox_.flush([&](auto &buffer, auto &message) {
+    auto header = tools::Splice::Header{
+        .comp_ids = comp_ids_,
+        .msg_seq_num = ++outbound_.msg_seq_num,
+        .sending_time = sending_time,
+    };
+    auto message_2 = tools::Splice::reframe(buffer, message, header);
+    (*connection_).send(message_2);
+    shared_.capture(tools::Capture::Direction::CLIENT_OUTBOUND, session_id_, message_2);
+  });
 }
 
 void Session::check(roq::fix::Header const &header) {
@@ -475,40 +671,40 @@ void Session::parse(Trace<roq::fix::Message> const &event) {
       dispatch<codec::fix::SecurityListRequest>(event);
       break;
     case SECURITY_DEFINITION_REQUEST:
-      dispatch<codec::fix::SecurityDefinitionRequest>(event, decode_buffer_);
+      dispatch<codec::fix::SecurityDefinitionRequest>(event, shared_.decode_buffer);
       break;
     case SECURITY_STATUS_REQUEST:
-      dispatch<codec::fix::SecurityStatusRequest>(event, decode_buffer_);
+      dispatch<codec::fix::SecurityStatusRequest>(event, shared_.decode_buffer);
       break;
     case MARKET_DATA_REQUEST:
-      dispatch<codec::fix::MarketDataRequest>(event, decode_buffer_);
+      dispatch<codec::fix::MarketDataRequest>(event, shared_.decode_buffer);
       break;
       // - order management
     case ORDER_STATUS_REQUEST:
-      dispatch<codec::fix::OrderStatusRequest>(event, decode_buffer_);
+      dispatch<codec::fix::OrderStatusRequest>(event, shared_.decode_buffer);
       break;
     case ORDER_MASS_STATUS_REQUEST:
-      dispatch<codec::fix::OrderMassStatusRequest>(event, decode_buffer_);
+      dispatch<codec::fix::OrderMassStatusRequest>(event, shared_.decode_buffer);
       break;
     case NEW_ORDER_SINGLE:
-      dispatch<codec::fix::NewOrderSingle>(event, decode_buffer_);
+      dispatch<codec::fix::NewOrderSingle>(event, shared_.decode_buffer);
       break;
     case ORDER_CANCEL_REQUEST:
-      dispatch<codec::fix::OrderCancelRequest>(event, decode_buffer_);
+      dispatch<codec::fix::OrderCancelRequest>(event, shared_.decode_buffer);
       break;
     case ORDER_CANCEL_REPLACE_REQUEST:
-      dispatch<codec::fix::OrderCancelReplaceRequest>(event, decode_buffer_);
+      dispatch<codec::fix::OrderCancelReplaceRequest>(event, shared_.decode_buffer);
       break;
     case ORDER_MASS_CANCEL_REQUEST:
-      dispatch<codec::fix::OrderMassCancelRequest>(event, decode_buffer_);
+      dispatch<codec::fix::OrderMassCancelRequest>(event, shared_.decode_buffer);
       break;
       // - position management
     case REQUEST_FOR_POSITIONS:
-      dispatch<codec::fix::RequestForPositions>(event, decode_buffer_);
+      dispatch<codec::fix::RequestForPositions>(event, shared_.decode_buffer);
       break;
       // - trade capture
     case TRADE_CAPTURE_REPORT_REQUEST:
-      dispatch<codec::fix::TradeCaptureReportRequest>(event, decode_buffer_);
+      dispatch<codec::fix::TradeCaptureReportRequest>(event, shared_.decode_buffer);
       break;
     default:
       log::warn("Unexpected: msg_type={}"sv, message.header.msg_type);
@@ -526,6 +722,10 @@ void Session::dispatch(Trace<roq::fix::Message> const &event, Args &&...args) {
   auto &[trace_info, message] = event;
   auto value = T::create(message, std::forward<Args>(args)...);
   log::info<1>("session_id={}, {}={}"sv, session_id_, nameof::nameof_short_type<T>(), value);
+  // note! attached in-place, the request can then be forwarded without a copy
+  if constexpr (is_routed_with_party_ids<T>())
+    if (std::empty(value.no_party_ids) && !std::empty(party_id_))
+      value.no_party_ids = {&party_, 1};
   Trace event_2{trace_info, value};
   (*this)(event_2, message.header);
 }
@@ -647,6 +847,11 @@ void Session::operator()(Trace<codec::fix::Logon> const &event, roq::fix::Header
       auto success = [&](auto strategy_id) {
         username_ = logon.username;
         party_id_ = fmt::format("{}"sv, strategy_id);
+        party_ = {
+            .party_id = party_id_,
+            .party_id_source = roq::fix::PartyIDSource::PROPRIETARY_CUSTOM_CODE,
+            .party_role = roq::fix::PartyRole::CLIENT_ID,
+        };
         try {
           auto user_request_id = shared_.create_request_id();
           auto user_request = codec::fix::UserRequest{
@@ -656,11 +861,13 @@ void Session::operator()(Trace<codec::fix::Logon> const &event, roq::fix::Header
               .password = {},
               .new_password = {},
           };
-          Trace event_2{trace_info, user_request};
-          handler_(event_2, session_id_);
           (*this)(State::WAITING_CREATE_ROUTE);
-          auto now = clock::get_system();
+          auto now = shared_.clock.get_system();
           user_response_timeout_ = now + shared_.settings.server.request_timeout;
+          schedule(user_response_timeout_);
+          // note! *after* state change, the response may be delivered before this call returns
+          Trace event_2{trace_info, user_request};
+          handler_(event_2, session_id_);
         } catch (NotReady &e) {
           send_reject_and_close(header, roq::fix::SessionRejectReason::OTHER, e.what());
         }
@@ -703,11 +910,13 @@ void Session::operator()(Trace<codec::fix::Logout> const &event, roq::fix::Heade
           .password = {},
           .new_password = {},
       };
-      Trace event_2{trace_info, user_request};
-      handler_(event_2, session_id_);
       (*this)(State::WAITING_REMOVE_ROUTE);
-      auto now = clock::get_system();
+      auto now = shared_.clock.get_system();
       user_response_timeout_ = now + shared_.settings.server.request_timeout;
+      schedule(user_response_timeout_);
+      // note! *after* state change, the response may be delivered before this call returns
+      Trace event_2{trace_info, user_request};
+      handler_(event_2, session_id_);
       break;
     }
     case WAITING_REMOVE_ROUTE:
@@ -741,6 +950,8 @@ void Session::operator()(Trace<codec::fix::SecurityListRequest> const &event, ro
             header, security_list_request.security_req_id, roq::fix::BusinessRejectReason::OTHER, ERROR_INVALID_REQ_ID);
         return;
       }
+      if (is_throttled(Shared::MessageClass::REQUESTS, header, security_list_request.security_req_id))
+        return;
       handler_(event, session_id_);
       break;
     }
@@ -769,6 +980,8 @@ void Session::operator()(Trace<codec::fix::SecurityDefinitionRequest> const &eve
             ERROR_INVALID_REQ_ID);
         return;
       }
+      if (is_throttled(Shared::MessageClass::REQUESTS, header, security_definition_request.security_req_id))
+        return;
       handler_(event, session_id_);
       break;
     }
@@ -797,6 +1010,8 @@ void Session::operator()(Trace<codec::fix::SecurityStatusRequest> const &event,
             ERROR_INVALID_REQ_ID);
         return;
       }
+      if (is_throttled(Shared::MessageClass::REQUESTS, header, security_status_request.security_status_req_id))
+        return;
       handler_(event, session_id_);
       break;
     }
@@ -822,6 +1037,8 @@ void Session::operator()(Trace<codec::fix::MarketDataRequest> const &event, roq:
             header, market_data_request.md_req_id, roq::fix::BusinessRejectReason::OTHER, ERROR_INVALID_MD_REQ_ID);
         return;
       }
+      if (is_throttled(Shared::MessageClass::REQUESTS, header, market_data_request.md_req_id))
+        return;
       handler_(event, session_id_);
       break;
     }
@@ -850,6 +1067,10 @@ void Session::operator()(Trace<codec::fix::OrderStatusRequest> const &event, roq
             ERROR_INVALID_REQ_ID);
         return;
       }
+      if (is_throttled(Shared::MessageClass::REQUESTS, header, order_status_request.cl_ord_id))
+        return;
+      if (!check_account(header, order_status_request.cl_ord_id, order_status_request.account))
+        return;
       if (add_party_ids(event, [&](auto &event_2) { handler_(event_2, session_id_); })) {
       } else {
         auto &[trace_info, order_status_request] = event;
@@ -883,6 +1104,10 @@ void Session::operator()(Trace<codec::fix::OrderMassStatusRequest> const &event,
             ERROR_INVALID_REQ_ID);
         return;
       }
+      if (is_throttled(Shared::MessageClass::REQUESTS, header, order_mass_status_request.mass_status_req_id))
+        return;
+      if (!check_account(header, order_mass_status_request.mass_status_req_id, order_mass_status_request.account))
+        return;
       if (add_party_ids(event, [&](auto &event_2) { handler_(event_2, session_id_); })) {
       } else {
         send_business_message_reject(
@@ -915,6 +1140,10 @@ void Session::operator()(Trace<codec::fix::NewOrderSingle> const &event, roq::fi
             header, new_order_single.cl_ord_id, roq::fix::BusinessRejectReason::OTHER, ERROR_INVALID_CL_ORD_ID);
         return;
       }
+      if (is_throttled(Shared::MessageClass::ORDERS, header, new_order_single.cl_ord_id))
+        return;
+      if (!check_account(header, new_order_single.cl_ord_id, new_order_single.account))
+        return;
       if (add_party_ids(event, [&](auto &event_2) { handler_(event_2, session_id_); })) {
       } else {
         send_business_message_reject(
@@ -952,6 +1181,10 @@ void Session::operator()(Trace<codec::fix::OrderCancelRequest> const &event, roq
             ERROR_INVALID_ORIG_CL_ORD_ID);
         return;
       }
+      if (is_throttled(Shared::MessageClass::CANCELS, header, order_cancel_request.cl_ord_id))
+        return;
+      if (!check_account(header, order_cancel_request.cl_ord_id, order_cancel_request.account))
+        return;
       if (add_party_ids(event, [&](auto &event_2) { handler_(event_2, session_id_); })) {
       } else {
         auto &[trace_info, order_cancel_request] = event;
@@ -994,6 +1227,10 @@ void Session::operator()(Trace<codec::fix::OrderCancelReplaceRequest> const &eve
             ERROR_INVALID_ORIG_CL_ORD_ID);
         return;
       }
+      if (is_throttled(Shared::MessageClass::ORDERS, header, order_cancel_replace_request.cl_ord_id))
+        return;
+      if (!check_account(header, order_cancel_replace_request.cl_ord_id, order_cancel_replace_request.account))
+        return;
       if (add_party_ids(event, [&](auto &event_2) { handler_(event_2, session_id_); })) {
       } else {
         auto &[trace_info, order_cancel_replace_request] = event;
@@ -1031,6 +1268,10 @@ void Session::operator()(Trace<codec::fix::OrderMassCancelRequest> const &event,
             ERROR_INVALID_CL_ORD_ID);
         return;
       }
+      if (is_throttled(Shared::MessageClass::CANCELS, header, order_mass_cancel_request.cl_ord_id))
+        return;
+      if (!check_account(header, order_mass_cancel_request.cl_ord_id, order_mass_cancel_request.account))
+        return;
       if (add_party_ids(event, [&](auto &event_2) { handler_(event_2, session_id_); })) {
       } else {
         send_business_message_reject(
@@ -1063,6 +1304,10 @@ void Session::operator()(Trace<codec::fix::RequestForPositions> const &event, ro
             header, request_for_positions.pos_req_id, roq::fix::BusinessRejectReason::OTHER, ERROR_INVALID_REQ_ID);
         return;
       }
+      if (is_throttled(Shared::MessageClass::REQUESTS, header, request_for_positions.pos_req_id))
+        return;
+      if (!check_account(header, request_for_positions.pos_req_id, request_for_positions.account))
+        return;
       if (add_party_ids(event, [&](auto &event_2) { handler_(event_2, session_id_); })) {
       } else {
         auto &[trace_info, request_for_positions] = event;
@@ -1099,6 +1344,10 @@ void Session::operator()(Trace<codec::fix::TradeCaptureReportRequest> const &eve
             ERROR_INVALID_REQ_ID);
         return;
       }
+      if (is_throttled(Shared::MessageClass::REQUESTS, header, trade_capture_report_request.trade_request_id))
+        return;
+      if (!check_account(header, trade_capture_report_request.trade_request_id, trade_capture_report_request.account))
+        return;
       if (add_party_ids(event, [&](auto &event_2) { handler_(event_2, session_id_); })) {
       } else {
         auto &[trace_info, trade_capture_report_request] = event;
@@ -1149,23 +1398,33 @@ void Session::send_business_message_reject(
   send<2>(response);
 }
 
+// note! rejected before reaching the controller, the shared upstream session never sees the request
+bool Session::is_throttled(
+    Shared::MessageClass message_class, roq::fix::Header const &header, std::string_view const &ref_id) {
+  if (!shared_.is_throttled(username_, message_class))
+    return false;
+  send_business_message_reject(header, ref_id, roq::fix::BusinessRejectReason::OTHER, ERROR_THROTTLED);
+  return true;
+}
+
+bool Session::check_account(
+    roq::fix::Header const &header, std::string_view const &ref_id, std::string_view const &account) {
+  if (shared_.is_entitled(username_, account))
+    return true;
+  send_business_message_reject(
+      header, ref_id, roq::fix::BusinessRejectReason::NOT_AUTHORIZED, ERROR_ACCOUNT_NOT_AUTHORIZED);
+  return false;
+}
+
 template <typename T, typename Callback>
 bool Session::add_party_ids(Trace<T> const &event, Callback callback) const {
   assert(!std::empty(party_id_));
   auto &[trace_info, value] = event;
-  if (std::empty(value.no_party_ids)) {
-    auto party = codec::fix::Party{
-        .party_id = party_id_,
-        .party_id_source = roq::fix::PartyIDSource::PROPRIETARY_CUSTOM_CODE,
-        .party_role = roq::fix::PartyRole::CLIENT_ID,
-    };
-    auto value_2 = value;
-    value_2.no_party_ids = {&party, 1};
-    Trace event_2{trace_info, value_2};
-    callback(event_2);
-    return true;
-  }
-  return false;
+  // note! party ids have already been attached by dispatch, anything else was supplied by the client
+  if (std::data(value.no_party_ids) != &party_)
+    return false;
+  callback(event);
+  return true;
 }
 
 }  // namespace client
@@ -3,8 +3,8 @@
 #pragma once
 
 #include <memory>
+#include <span>
 #include <string>
-#include <vector>
 
 #include "roq/event.hpp"
 #include "roq/stop.hpp"
@@ -53,6 +53,10 @@
 
 #include "roq/proxy/fix/shared.hpp"
 
+#include "roq/proxy/fix/tools/lazy.hpp"
+#include "roq/proxy/fix/tools/outbox.hpp"
+#include "roq/proxy/fix/tools/splice.hpp"
+
 namespace roq {
 namespace proxy {
 namespace fix {
@@ -60,8 +64,10 @@ namespace client {
 
 struct Session final : public io::net::tcp::Connection::Handler {
   struct Disconnected final {};
+  struct Flush final {};  // note! an inbound batch has been processed (held messages can now be sent)
   struct Handler {
     virtual void operator()(Trace<Disconnected> const &, uint64_t session_id) = 0;
+    virtual void operator()(Trace<Flush> const &, uint64_t session_id) = 0;
     // user
     virtual void operator()(Trace<codec::fix::UserRequest> const &, uint64_t session_id) = 0;
     // security
@@ -83,12 +89,22 @@ struct Session final : public io::net::tcp::Connection::Handler {
     virtual void operator()(Trace<codec::fix::TradeCaptureReportRequest> const &, uint64_t session_id) = 0;
   };
 
-  Session(Handler &, uint64_t session_id, io::net::tcp::Connection::Factory &, Shared &);
+  Session(Handler &, Shared &);
+
+  Session(Session &&) = delete;
+  Session(Session const &) = delete;
+
+  // note! sessions are pooled and re-used
+  void open(uint64_t session_id, io::net::tcp::Connection::Factory &);
+  void release();
 
   bool ready() const;
 
   void force_disconnect();
 
+  // note! sends held messages (see tools::Outbox)
+  void flush();
+
   void operator()(Event<Stop> const &);
   void operator()(Event<Timer> const &);
 
@@ -101,12 +117,13 @@ struct Session final : public io::net::tcp::Connection::Handler {
   void operator()(Trace<codec::fix::SecurityStatus> const &);
   // market data
   void operator()(Trace<codec::fix::MarketDataRequestReject> const &);
-  void operator()(Trace<codec::fix::MarketDataSnapshotFullRefresh> const &);
-  void operator()(Trace<codec::fix::MarketDataIncrementalRefresh> const &);
+  void operator()(Trace<tools::Lazy<codec::fix::MarketDataSnapshotFullRefresh>> const &, std::string_view const &md_req_id);
+  void operator()(Trace<tools::Lazy<codec::fix::MarketDataIncrementalRefresh>> const &, std::string_view const &md_req_id);
   // orders
   void operator()(Trace<codec::fix::OrderCancelReject> const &);
   void operator()(Trace<codec::fix::OrderMassCancelReport> const &);
   void operator()(Trace<codec::fix::ExecutionReport> const &);
+  void operator()(Trace<codec::fix::ExecutionReport> const &, std::span<std::byte const> const &message);
   // positions
   void operator()(Trace<codec::fix::RequestForPositionsAck> const &);
   void operator()(Trace<codec::fix::PositionReport> const &);
@@ -138,6 +155,8 @@ struct Session final : public io::net::tcp::Connection::Handler {
 
   void make_zombie();
 
+  void schedule(std::chrono::nanoseconds deadline);
+
   // - send
   template <std::size_t level, typename T>
   void send_and_close(T const &);
@@ -145,6 +164,12 @@ struct Session final : public io::net::tcp::Connection::Handler {
   void send(T const &);
   template <std::size_t level, typename T>
   void send(T const &, std::chrono::nanoseconds sending_time);
+  template <std::size_t level, typename T>
+  void send(T const &, std::span<std::byte const> const &message, std::span<tools::Splice::Replacement const> const &);
+
+  bool can_hold(tools::Outbox::Priority) const;
+  template <typename T>
+  void hold(tools::Outbox::Priority, std::span<std::byte const> const &message, T const &);
 
   // - receive
   void check(roq::fix::Header const &);
@@ -188,17 +213,20 @@ struct Session final : public io::net::tcp::Connection::Handler {
       roq::fix::BusinessRejectReason,
       std::string_view const &text);
 
+  bool is_throttled(Shared::MessageClass, roq::fix::Header const &, std::string_view const &ref_id);
+  bool check_account(roq::fix::Header const &, std::string_view const &ref_id, std::string_view const &account);
+
   template <typename T, typename Callback>
   bool add_party_ids(Trace<T> const &, Callback) const;
 
  private:
   Handler &handler_;
-  uint64_t const session_id_;
+  uint64_t session_id_ = {};
   std::unique_ptr<io::net::tcp::Connection> connection_;
   Shared &shared_;
   io::Buffer buffer_;
-  std::chrono::nanoseconds const logon_timeout_;
-  State state_ = {};
+  std::chrono::nanoseconds logon_timeout_ = {};
+  State state_ = State::ZOMBIE;  // note! until opened
   struct {
     uint64_t msg_seq_num = {};
   } outbound_;
@@ -206,14 +234,16 @@ struct Session final : public io::net::tcp::Connection::Handler {
     uint64_t msg_seq_num = {};
   } inbound_;
   std::string comp_id_;
+  std::string comp_ids_;  // note! pre-serialized session header, see tools::Splice
   std::string username_;
   std::chrono::nanoseconds user_response_timeout_ = {};
   std::string party_id_;
+  codec::fix::Party party_;  // note! references party_id_, attached in-place to requests routed upstream
   std::chrono::nanoseconds next_heartbeat_ = {};
   bool waiting_for_heartbeat_ = {};
-  // buffer
-  std::vector<std::byte> decode_buffer_;
-  std::vector<std::byte> encode_buffer_;
+  std::chrono::nanoseconds last_receive_ = {};
+  uint64_t timer_ = {};
+  tools::Outbox outbox_;
 };
 
 }  // namespace client
@@ -69,6 +69,40 @@ R parse_symbols(auto &node) {
   return result;
 }
 
+auto parse_throttle(auto &node) {
+  if (!node.is_table())
+    log::fatal("Unexpected: throttle must be a table"sv);
+  auto table = *node.as_table();
+  Throttle result;
+  for (auto [key, value] : table) {
+    if (key == "rate"sv) {
+      result.rate = *value.template value<uint32_t>();
+    } else if (key == "burst"sv) {
+      result.burst = *value.template value<uint32_t>();
+    } else {
+      log::fatal(R"(Unexpected: throttle key="{}")"sv, key.str());
+    }
+  }
+  return result;
+}
+
+void parse_throttles(auto &node, auto &result) {
+  if (!node.is_table())
+    log::fatal("Unexpected: user throttle must be a table"sv);
+  auto table = *node.as_table();
+  for (auto [key, value] : table) {
+    if (key == "orders"sv) {
+      result.orders = parse_throttle(value);
+    } else if (key == "cancels"sv) {
+      result.cancels = parse_throttle(value);
+    } else if (key == "requests"sv) {
+      result.requests = parse_throttle(value);
+    } else {
+      log::fatal(R"(Unexpected: user throttle key="{}")"sv, key.str());
+    }
+  }
+}
+
 auto parse_user(auto &node) {
   auto table = *node.as_table();
   User result;
@@ -80,9 +114,19 @@ auto parse_user(auto &node) {
     } else if (key == "password"sv) {
       result.password = *value.template value<std::string>();
     } else if (key == "accounts"sv) {
-      // XXX TODO
+      if (value.is_value()) {
+        result.accounts.emplace_back(*value.template value<std::string>());
+      } else if (value.is_array()) {
+        auto &arr = *value.as_array();
+        for (auto &node_2 : arr)
+          result.accounts.emplace_back(*node_2.template value<std::string>());
+      } else {
+        log::fatal(R"(Unexpected: user key="{}" must be a string or an array)"sv, key.str());
+      }
     } else if (key == "strategy_id"sv) {
       result.strategy_id = *value.template value<uint32_t>();
+    } else if (key == "throttle"sv) {
+      parse_throttles(value, result.throttle);
     } else {
       log::fatal(R"(Unexpected: user key="{}")"sv, key.str());
     }
@@ -115,6 +159,51 @@ R parse_users(auto &node) {
   }
   return result;
 }
+
+auto parse_account(auto &name, auto &node) {
+  auto table = *node.as_table();
+  Account result{
+      .name = std::string{name},
+  };
+  for (auto [key, value] : table) {
+    if (key == "max_order_qty"sv) {
+      result.max_order_qty = *value.template value<double>();
+    } else if (key == "max_notional"sv) {
+      result.max_notional = *value.template value<double>();
+    } else if (key == "max_open_orders"sv) {
+      result.max_open_orders = *value.template value<uint32_t>();
+    } else if (key == "price_band"sv) {
+      result.price_band = *value.template value<double>();
+    } else {
+      log::fatal(R"(Unexpected: account key="{}")"sv, key.str());
+    }
+  }
+  return result;
+}
+
+// note! optional
+template <typename R>
+R parse_accounts(auto &node) {
+  using result_type = std::remove_cvref<R>::type;
+  result_type result;
+  auto parse_helper = [&](auto &node) {
+    if (node.is_table()) {
+      auto &table = *node.as_table();
+      for (auto [key, value] : table) {
+        if (value.is_table()) {
+          auto account = parse_account(key.str(), value);
+          result.emplace(key, std::move(account));
+        } else {
+          log::fatal(R"(Unexpected: "accounts.{}" must be a table)"sv, key.str());
+        }
+      }
+    } else {
+      log::fatal(R"(Unexpected: "accounts" must be a table)"sv);
+    }
+  };
+  find_and_remove(node, "accounts"sv, parse_helper);
+  return result;
+}
 }  // namespace
 
 // === IMPLEMENTATION ===
@@ -130,7 +219,8 @@ Config Config::parse_text(std::string_view const &text) {
 }
 
 Config::Config(auto &node)
-    : symbols{parse_symbols<decltype(symbols)>(node)}, users{parse_users<decltype(users)>(node)} {
+    : symbols{parse_symbols<decltype(symbols)>(node)}, users{parse_users<decltype(users)>(node)},
+      accounts{parse_accounts<decltype(accounts)>(node)} {
   check_empty(node);
 }
 
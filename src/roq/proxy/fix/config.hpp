@@ -8,6 +8,7 @@
 
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "roq/utils/container.hpp"
 
@@ -15,12 +16,32 @@ namespace roq {
 namespace proxy {
 namespace fix {
 
+// note! messages per second, zero means unlimited
+struct Throttle final {
+  uint32_t rate = {};
+  uint32_t burst = {};  // note! defaults to rate
+};
+
 struct User final {
   std::string component;
   std::string username;
   std::string password;
-  std::string accounts;  // XXX TODO
+  std::vector<std::string> accounts;
   uint32_t strategy_id = {};
+  struct {
+    Throttle orders;    // new order single, order cancel replace request
+    Throttle cancels;   // order cancel request, order mass cancel request
+    Throttle requests;  // everything else
+  } throttle;
+};
+
+// note! risk limits, zero means unlimited
+struct Account final {
+  std::string name;
+  double max_order_qty = {};
+  double max_notional = {};
+  uint32_t max_open_orders = {};
+  double price_band = {};  // note! fraction of last traded price
 };
 
 struct Config final {
@@ -29,6 +50,7 @@ struct Config final {
 
   utils::unordered_set<std::string> const symbols;
   utils::unordered_map<std::string, User> const users;
+  utils::unordered_map<std::string, Account> const accounts;
 
  protected:
   explicit Config(auto &node);
@@ -38,6 +60,22 @@ struct Config final {
 }  // namespace proxy
 }  // namespace roq
 
+template <>
+struct fmt::formatter<roq::proxy::fix::Throttle> {
+  constexpr auto parse(format_parse_context &context) { return std::begin(context); }
+  auto format(roq::proxy::fix::Throttle const &value, format_context &context) const {
+    using namespace std::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(rate={}, )"
+        R"(burst={})"
+        R"(}})"sv,
+        value.rate,
+        value.burst);
+  }
+};
+
 template <>
 struct fmt::formatter<roq::proxy::fix::User> {
   constexpr auto parse(format_parse_context &context) { return std::begin(context); }
@@ -49,14 +87,44 @@ struct fmt::formatter<roq::proxy::fix::User> {
         R"(component="{}", )"
         R"(username="{}", )"
         R"(password="{}", )"
-        R"(accounts="{}", )"
-        R"(strategy_id={})"
+        R"(accounts=[{}], )"
+        R"(strategy_id={}, )"
+        R"(throttle={{)"
+        R"(orders={}, )"
+        R"(cancels={}, )"
+        R"(requests={})"
+        R"(}})"
         R"(}})"sv,
         value.component,
         value.username,
         value.password,
-        value.accounts,
-        value.strategy_id);
+        fmt::join(value.accounts, ", "sv),
+        value.strategy_id,
+        value.throttle.orders,
+        value.throttle.cancels,
+        value.throttle.requests);
+  }
+};
+
+template <>
+struct fmt::formatter<roq::proxy::fix::Account> {
+  constexpr auto parse(format_parse_context &context) { return std::begin(context); }
+  auto format(roq::proxy::fix::Account const &value, format_context &context) const {
+    using namespace std::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(name="{}", )"
+        R"(max_order_qty={}, )"
+        R"(max_notional={}, )"
+        R"(max_open_orders={}, )"
+        R"(price_band={})"
+        R"(}})"sv,
+        value.name,
+        value.max_order_qty,
+        value.max_notional,
+        value.max_open_orders,
+        value.price_band);
   }
 };
 
@@ -69,9 +137,11 @@ struct fmt::formatter<roq::proxy::fix::Config> {
         context.out(),
         R"({{)"
         R"(symbols=[{}], )"
-        R"(users=[{}])"
+        R"(users=[{}], )"
+        R"(accounts=[{}])"
         R"(}})"sv,
         fmt::join(value.symbols, ", "sv),
-        fmt::join(std::ranges::views::transform(value.users, [](auto &item) { return item.second; }), ","sv));
+        fmt::join(std::ranges::views::transform(value.users, [](auto &item) { return item.second; }), ","sv),
+        fmt::join(std::ranges::views::transform(value.accounts, [](auto &item) { return item.second; }), ","sv));
   }
 };
@@ -2,6 +2,11 @@
 
 #include "roq/proxy/fix/controller.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <type_traits>
+
 #include "roq/event.hpp"
 #include "roq/timer.hpp"
 
@@ -24,6 +29,13 @@ namespace fix {
 namespace {
 auto const TIMER_FREQUENCY = 100ms;
 
+auto const TIMEOUT_RESOLUTION = 10ms;
+
+auto const TAG_MD_REQ_ID = uint32_t{262};
+
+auto const UNDEFINED_STRATEGY_ID = std::numeric_limits<uint32_t>::max();
+auto const MAX_DIRECT_STRATEGY_ID = uint32_t{65535};  // note! larger strategy ids use a hash map
+
 auto const ORDER_ID_NONE = "NONE"sv;
 
 auto const ERROR_VALIDATION = "VALIDATION"sv;
@@ -37,11 +49,25 @@ auto const ERROR_DUPLICATED_POS_REQ_ID = "DUPLICATED_POS_REQ_ID"sv;
 auto const ERROR_UNKNOWN_POS_REQ_ID = "UNKNOWN_POS_REQ_ID"sv;
 auto const ERROR_DUPLICATE_TRADE_REQUEST_ID = "DUPLICATE_TRADE_REQUEST_ID"sv;
 auto const ERROR_UNKNOWN_TRADE_REQUEST_ID = "UNKNOWN_TRADE_REQUEST_ID"sv;
+auto const ERROR_REQUEST_TIMEOUT = "REQUEST_TIMEOUT"sv;
+auto const ERROR_NOT_READY = "NOT_READY"sv;
+auto const ERROR_DISCONNECTED = "DISCONNECTED"sv;
+auto const ERROR_POSITIONS_INVALIDATED = "POSITIONS_INVALIDATED"sv;
 }  // namespace
 
 // === HELPERS ===
 
 namespace {
+// note! client_id is the strategy_id formatted as a decimal number
+auto get_strategy_id(std::string_view const &client_id) -> uint32_t {
+  auto result = uint32_t{};
+  auto last = std::data(client_id) + std::size(client_id);
+  auto [ptr, ec] = std::from_chars(std::data(client_id), last, result);
+  if (std::empty(client_id) || ec != std::errc{} || ptr != last)
+    return UNDEFINED_STRATEGY_ID;
+  return result;
+}
+
 auto create_auth_session(auto &handler, auto &settings, auto &context) -> std::unique_ptr<auth::Session> {
   if (std::empty(settings.auth.uri))
     return {};
@@ -49,12 +75,22 @@ auto create_auth_session(auto &handler, auto &settings, auto &context) -> std::u
   return std::make_unique<auth::Session>(handler, settings, context, uri);
 }
 
-auto create_server_session(auto &handler, auto &settings, auto &context, auto &connections) {
-  if (std::size(connections) != 1)
-    log::fatal("Unexpected: only supporting a single upstream fix-bridge"sv);
+// note! connections: order entry, (optional) market data
+auto create_server_session(auto &handler, auto &shared, auto &context, auto &connections) {
+  if (std::empty(connections) || std::size(connections) > 2)
+    log::fatal("Unexpected: only supporting a single upstream fix-bridge (optionally with a market data session)"sv);
   auto &connection = connections[0];
   auto uri = io::web::URI{connection};
-  return server::Session{handler, settings, context, uri};
+  return server::Session{handler, shared, context, uri, server::Session::Type::ORDER_ENTRY};
+}
+
+auto create_market_data_session(auto &handler, auto &shared, auto &context, auto &connections)
+    -> std::unique_ptr<server::Session> {
+  if (std::size(connections) < 2)
+    return {};
+  auto &connection = connections[1];
+  auto uri = io::web::URI{connection};
+  return std::make_unique<server::Session>(handler, shared, context, uri, server::Session::Type::MARKET_DATA);
 }
 
 template <typename T>
@@ -113,6 +149,32 @@ auto get_subscription_request_type(auto &event) {
     result = roq::fix::SubscriptionRequestType::SNAPSHOT;
   return result;
 }
+
+template <typename Callback>
+void create_position_report(
+    auto &account,
+    auto &position,
+    std::string_view const &pos_req_id,
+    std::string_view const &pos_maint_rpt_id,
+    uint32_t total_num_pos_reports,
+    bool unsolicited_indicator,
+    Callback callback) {
+  auto item = codec::fix::Position{};
+  item.pos_type = position.pos_type;
+  item.long_qty = position.long_qty;
+  item.short_qty = position.short_qty;
+  auto position_report = codec::fix::PositionReport{};
+  position_report.pos_maint_rpt_id = pos_maint_rpt_id;
+  position_report.pos_req_id = pos_req_id;
+  position_report.total_num_pos_reports = total_num_pos_reports;
+  position_report.unsolicited_indicator = unsolicited_indicator;
+  position_report.pos_req_result = roq::fix::PosReqResult::VALID;
+  position_report.account = account;
+  position_report.symbol = position.symbol;
+  position_report.security_exchange = position.security_exchange;
+  position_report.no_positions = {&item, 1};
+  callback(position_report);
+}
 }  // namespace
 
 // === IMPLEMENTATION ===
@@ -126,8 +188,9 @@ Controller::Controller(
       interrupt_{context.create_signal(*this, io::sys::Signal::Type::INTERRUPT)},
       timer_{context.create_timer(*this, TIMER_FREQUENCY)}, shared_{settings, config},
       auth_session_{create_auth_session(*this, settings, context)},
-      server_session_{create_server_session(*this, settings, context, connections)},
-      client_manager_{*this, settings, context, shared_} {
+      server_session_{create_server_session(*this, shared_, context, connections)},
+      market_data_session_{create_market_data_session(*this, shared_, context, connections)},
+      client_manager_{*this, settings, context, shared_}, risk_{config}, timeouts_{TIMEOUT_RESOLUTION} {
 }
 
 void Controller::run() {
@@ -151,10 +214,23 @@ void Controller::operator()(io::sys::Signal::Event const &event) {
 // io::sys::Timer::Handler
 
 void Controller::operator()(io::sys::Timer::Event const &event) {
+  shared_.clock.calibrate();
+  shared_.refresh_capture(event.now);
   auto timer = Timer{
       .now = event.now,
   };
   dispatch(timer);
+  timeouts_(event.now, [&](auto &timeout) {
+    auto &mapping = *timeout.mapping;
+    auto route_ptr = mapping.find(timeout.req_id);
+    if (route_ptr == nullptr)
+      return;
+    auto &route = *route_ptr;
+    route.timeout = {};  // note! already released by the timer wheel
+    log::warn(R"(Request timeout: req_id(server)="{}", ref_msg_type={})"sv, timeout.req_id, timeout.ref_msg_type);
+    request_timeout(timeout, route);
+    remove_req_id(mapping, timeout.req_id);
+  });
 }
 
 // auth::Session::Handler
@@ -169,26 +245,54 @@ void Controller::operator()(auth::Session::Remove const &remove) {
 
 // server::Session::Handler
 
-void Controller::operator()(Trace<server::Session::Ready> const &) {
-  ready_ = true;
+void Controller::operator()(Trace<server::Session::Ready> const &event) {
+  switch (event.value.type) {
+    using enum server::Session::Type;
+    case ORDER_ENTRY:
+      ready_ = true;
+      break;
+    case MARKET_DATA:
+      market_data_ready_ = true;
+      break;
+  }
+}
+
+void Controller::operator()(Trace<server::Session::Disconnected> const &event) {
+  switch (event.value.type) {
+    using enum server::Session::Type;
+    case ORDER_ENTRY:
+      ready_ = false;
+      client_manager_.get_all_sessions([&](auto &session) { session.force_disconnect(); });
+      // note! must be refreshed from the fix-bridge
+      positions_.clear([&](auto &account, auto &request_id) {
+        reject_position_subscription(event.trace_info, account, request_id, ERROR_DISCONNECTED);
+      });
+      risk_.clear();       // note! acks for open order requests will never arrive
+      // XXX FIXME clear cl_ord_id_ ???
+      break;
+    case MARKET_DATA:
+      // note! order entry is not affected, clients must subscribe again
+      market_data_ready_ = false;
+      reject_market_data_subscriptions(event.trace_info);
+      break;
+  }
 }
 
-void Controller::operator()(Trace<server::Session::Disconnected> const &) {
-  ready_ = false;
-  client_manager_.get_all_sessions([&](auto &session) { session.force_disconnect(); });
-  // XXX FIXME clear cl_ord_id_ ???
+void Controller::operator()(Trace<server::Session::Flush> const &) {
+  flush();
 }
 
 void Controller::operator()(Trace<codec::fix::BusinessMessageReject> const &event) {
   auto dispatch = [&](auto &mapping) {
-    auto iter = mapping.server_to_client.find(event.value.business_reject_ref_id);
-    if (iter != std::end(mapping.server_to_client)) {
-      auto &[session_id, req_id, keep_alive] = (*iter).second;
+    auto route_ptr = mapping.find(event.value.business_reject_ref_id);
+    if (route_ptr != nullptr) {
+      auto &route = *route_ptr;
+      remove_timeout(route);
       auto business_message_reject = event.value;
       // XXX FIXME what about ref_seq_num ???
-      business_message_reject.business_reject_ref_id = req_id;
+      business_message_reject.business_reject_ref_id = route.req_id;
       Trace event_2{event.trace_info, business_message_reject};
-      dispatch_to_client(event_2, session_id);
+      dispatch_to_client(event_2, route.session_id);
       // XXX FIXME what about keep_alive ???
     }
   };
@@ -295,9 +399,15 @@ void Controller::operator()(Trace<codec::fix::BusinessMessageReject> const &even
       break;
     case EMAIL:
       break;
-    case NEW_ORDER_SINGLE:
+    case NEW_ORDER_SINGLE: {
+      // note! the order was never created
+      auto &cl_ord_id = event.value.business_reject_ref_id;
       dispatch(subscriptions_.cl_ord_id);
+      risk_.remove(cl_ord_id);
+      remove_origin(cl_ord_id);
+      remove_req_id(subscriptions_.cl_ord_id, cl_ord_id);
       return;  // note!
+    }
     case NEW_ORDER_LIST:
       break;
     case ORDER_CANCEL_REQUEST:
@@ -415,7 +525,7 @@ void Controller::operator()(Trace<codec::fix::UserResponse> const &event) {
               user_add(user_response.username, session_id);
               break;
             case NOT_LOGGED_IN:
-              user_remove(user_response.username, session.ready());
+              user_remove(user_response.username, session_id, session.ready());
               break;
             default:
               log::warn("Unexpected: user_response={}"sv, user_response);
@@ -426,7 +536,7 @@ void Controller::operator()(Trace<codec::fix::UserResponse> const &event) {
         })) {
     } else {
       // note! clean up whatever the response
-      user_remove(user_response.username, false);
+      user_remove(user_response.username, session_id, false);
     }
   } else {
     log::fatal("Unexpected"sv);
@@ -513,16 +623,15 @@ void Controller::operator()(Trace<codec::fix::MarketDataRequestReject> const &ev
   }
 }
 
-void Controller::operator()(Trace<codec::fix::MarketDataSnapshotFullRefresh> const &event) {
+void Controller::operator()(Trace<tools::Lazy<codec::fix::MarketDataSnapshotFullRefresh>> const &event) {
   auto remove = true;
   auto dispatch = [&](auto session_id, auto &req_id, auto keep_alive) {
     remove = !keep_alive;
-    auto market_data_snapshot_full_refresh = event.value;
-    market_data_snapshot_full_refresh.md_req_id = req_id;
-    Trace event_2{event.trace_info, market_data_snapshot_full_refresh};
-    dispatch_to_client(event_2, session_id);
+    dispatch_to_client(event, session_id, req_id);  // note! client session rewrites md_req_id
   };
-  auto req_id = event.value.md_req_id;
+  if (risk_.requires_market_data())
+    risk_(event.value.raw());
+  auto req_id = event.value.find(TAG_MD_REQ_ID);
   auto &mapping = subscriptions_.md_req_id;
   if (find_req_id(mapping, req_id, dispatch)) {
     if (remove)
@@ -533,14 +642,13 @@ void Controller::operator()(Trace<codec::fix::MarketDataSnapshotFullRefresh> con
   }
 }
 
-void Controller::operator()(Trace<codec::fix::MarketDataIncrementalRefresh> const &event) {
+void Controller::operator()(Trace<tools::Lazy<codec::fix::MarketDataIncrementalRefresh>> const &event) {
   auto dispatch = [&](auto session_id, auto &req_id, [[maybe_unused]] auto keep_alive) {
-    auto market_data_incremental_refresh = event.value;
-    market_data_incremental_refresh.md_req_id = req_id;
-    Trace event_2{event.trace_info, market_data_incremental_refresh};
-    dispatch_to_client(event_2, session_id);
+    dispatch_to_client(event, session_id, req_id);  // note! client session rewrites md_req_id
   };
-  auto req_id = event.value.md_req_id;
+  if (risk_.requires_market_data())
+    risk_(event.value.raw());
+  auto req_id = event.value.find(TAG_MD_REQ_ID);
   auto &mapping = subscriptions_.md_req_id;
   find_req_id(mapping, req_id, dispatch);
   // note! delivery failure is valid (an unsubscribe request could already have removed md_req_id)
@@ -560,6 +668,7 @@ void Controller::operator()(Trace<codec::fix::OrderCancelReject> const &event) {
   find_req_id(mapping, req_id, dispatch);
   if (!remove_req_id(mapping, req_id))
     log::warn(R"(Internal error: cl_ord_id="{}")"sv, req_id);
+  remove_origin(req_id);
 }
 
 void Controller::operator()(Trace<codec::fix::OrderMassCancelReport> const &event) {
@@ -576,7 +685,7 @@ void Controller::operator()(Trace<codec::fix::OrderMassCancelReport> const &even
     log::warn(R"(Internal error: cl_ord_id="{}")"sv, req_id);
 }
 
-void Controller::operator()(Trace<codec::fix::ExecutionReport> const &event) {
+void Controller::operator()(Trace<codec::fix::ExecutionReport> const &event, std::span<std::byte const> const &message) {
   auto execution_report = event.value;
   auto cl_ord_id = execution_report.cl_ord_id;
   auto orig_cl_ord_id = execution_report.orig_cl_ord_id;
@@ -642,25 +751,45 @@ void Controller::operator()(Trace<codec::fix::ExecutionReport> const &event) {
       auto dispatch = [&](auto session_id, [[maybe_unused]] auto &req_id, [[maybe_unused]] auto keep_alive) {
         assert(execution_report.cl_ord_id == req_id);
         Trace event_2{event.trace_info, execution_report};
-        dispatch_to_client(event_2, session_id);
+        dispatch_to_client(event_2, session_id, message);
       };
       if (find_req_id(mapping, req_id, dispatch)) {
       } else {
         log::warn(R"(Internal error: req_id="{}")"sv, req_id);  // note! created by another proxy?
       }
+      if (execution_report.ord_status == roq::fix::OrdStatus::REJECTED)
+        risk_.remove(cl_ord_id);
+      remove_origin(cl_ord_id);
     } else {
       log::debug(R"(SUCCESS req_id="{}")"sv, req_id);
       auto done = is_order_complete(execution_report.ord_status);
       if (done) {
         remove_cl_ord_id(cl_ord_id);
+        risk_.remove(cl_ord_id);
+        risk_.remove(orig_cl_ord_id);
       } else {
         if (pending)
           ensure_cl_ord_id(cl_ord_id, execution_report.ord_status);
       }
-      if (!pending && !std::empty(orig_cl_ord_id))
+      if (!pending && !std::empty(orig_cl_ord_id)) {
         remove_cl_ord_id(orig_cl_ord_id);
+        risk_.replace(orig_cl_ord_id, cl_ord_id);
+      }
+      positions_(
+          execution_report,
+          [&](auto &account, auto &position) { publish_position(event.trace_info, account, position); },
+          [&](auto &account, auto &request_id) {
+            reject_position_subscription(event.trace_info, account, request_id, ERROR_POSITIONS_INVALIDATED);
+          });
       Trace event_2{event.trace_info, execution_report};
-      broadcast(event_2, client_id);
+      broadcast(event_2, client_id, cl_ord_id, message);
+      // note! *after* the execution report has been routed
+      if (done) {
+        remove_origin(cl_ord_id);
+        remove_origin(orig_cl_ord_id);
+      } else if (!pending) {
+        remove_origin(orig_cl_ord_id);
+      }
     }
     if (!pending)
       remove_req_id(mapping, req_id);  // note! relaxed
@@ -668,64 +797,69 @@ void Controller::operator()(Trace<codec::fix::ExecutionReport> const &event) {
 }
 
 void Controller::operator()(Trace<codec::fix::RequestForPositionsAck> const &event) {
-  auto remove = true;
-  auto dispatch = [&](auto session_id, auto &req_id, [[maybe_unused]] auto keep_alive) {
-    auto failure = event.value.pos_req_result != roq::fix::PosReqResult::VALID ||
-                   event.value.pos_req_status == roq::fix::PosReqStatus::REJECTED;
-    if (failure) {
-      remove = true;
-      total_num_pos_reports_ = {};
-    } else {
-      remove = event.value.total_num_pos_reports == 0;  // must await all reports before removing
-      total_num_pos_reports_ = event.value.total_num_pos_reports;
-      log::warn("Awaiting {} position reports..."sv, total_num_pos_reports_);
-    }
-    auto position_report = event.value;
-    position_report.pos_req_id = req_id;
-    Trace event_2{event.trace_info, position_report};
-    dispatch_to_client(event_2, session_id);
-  };
-  auto req_id = event.value.pos_req_id;
+  auto &request_for_positions_ack = event.value;
+  auto req_id = request_for_positions_ack.pos_req_id;
   auto &mapping = subscriptions_.pos_req_id;
-  if (find_req_id(mapping, req_id, dispatch)) {
-    if (remove) {
-      log::info(R"(DEBUG removing pos_req_id="{}")"sv, req_id);
-      if (!remove_req_id(mapping, req_id))
-        log::warn(R"(Internal error: pos_req_id="{}")"sv, req_id);
-    }
-  } else {
+  auto route_ptr = mapping.find(req_id);
+  if (route_ptr == nullptr) {
     log::warn(R"(Internal error: pos_req_id="{}")"sv, req_id);
+    return;
+  }
+  auto &route = *route_ptr;
+  remove_timeout(route);
+  auto failure = request_for_positions_ack.pos_req_result != roq::fix::PosReqResult::VALID ||
+                 request_for_positions_ack.pos_req_status == roq::fix::PosReqStatus::REJECTED;
+  if (failure) {
+    route.remaining = {};
+  } else {
+    route.remaining = request_for_positions_ack.total_num_pos_reports;
+    log::debug(R"(Awaiting {} position report(s) for pos_req_id="{}")"sv, route.remaining, req_id);
+    positions_.begin_snapshot(request_for_positions_ack.account, request_for_positions_ack.total_num_pos_reports);
+  }
+  auto remove = failure || (!route.remaining && !route.keep_alive);  // note! must await all reports before removing
+  auto request_for_positions_ack_2 = request_for_positions_ack;
+  request_for_positions_ack_2.pos_req_id = route.req_id;
+  Trace event_2{event.trace_info, request_for_positions_ack_2};
+  dispatch_to_client(event_2, route.session_id);
+  if (remove) {
+    log::info(R"(DEBUG removing pos_req_id="{}")"sv, req_id);
+    if (!remove_req_id(mapping, req_id))
+      log::warn(R"(Internal error: pos_req_id="{}")"sv, req_id);
   }
 }
 
 void Controller::operator()(Trace<codec::fix::PositionReport> const &event) {
-  if (total_num_pos_reports_)
-    --total_num_pos_reports_;
-  if (!total_num_pos_reports_)
-    log::warn("... last position report!"sv);
-  auto remove = false;
-  auto dispatch = [&](auto session_id, auto &req_id, auto keep_alive) {
-    auto failure = event.value.pos_req_result != roq::fix::PosReqResult::VALID;
-    if (failure) {
-      remove = true;
-    } else if (!total_num_pos_reports_) {
-      remove = !keep_alive;
-    }
-    auto position_report = event.value;
-    position_report.pos_req_id = req_id;
-    Trace event_2{event.trace_info, position_report};
-    dispatch_to_client(event_2, session_id);
-  };
-  auto req_id = event.value.pos_req_id;
+  positions_(event.value, [&](auto &account, auto &position) {
+    publish_position(event.trace_info, account, position);
+  });
+  auto &position_report = event.value;
+  auto req_id = position_report.pos_req_id;
   auto &mapping = subscriptions_.pos_req_id;
-  if (find_req_id(mapping, req_id, dispatch)) {
-    log::info("DEBUG remove={}"sv, remove);
-    if (remove)
-      if (!remove_req_id(mapping, req_id))
-        log::warn(R"(Internal error: pos_req_id="{}")"sv, req_id);
-  } else {
+  auto route_ptr = mapping.find(req_id);
+  if (route_ptr == nullptr) {
     log::warn(R"(Internal error: pos_req_id="{}")"sv, req_id);
+    return;
   }
+  auto &route = *route_ptr;
+  remove_timeout(route);
+  auto failure = position_report.pos_req_result != roq::fix::PosReqResult::VALID;
+  auto remove = false;
+  if (failure) {
+    remove = true;
+  } else if (route.remaining) {
+    --route.remaining;
+    if (!route.remaining) {
+      log::debug(R"(Last position report for pos_req_id="{}")"sv, req_id);
+      remove = !route.keep_alive;
+    }
+  }
+  auto position_report_2 = position_report;
+  position_report_2.pos_req_id = route.req_id;
+  Trace event_2{event.trace_info, position_report_2};
+  dispatch_to_client(event_2, route.session_id);
+  if (remove)
+    if (!remove_req_id(mapping, req_id))
+      log::warn(R"(Internal error: pos_req_id="{}")"sv, req_id);
 }
 
 void Controller::operator()(Trace<codec::fix::TradeCaptureReportRequestAck> const &event) {
@@ -773,9 +907,13 @@ void Controller::operator()(Trace<codec::fix::TradeCaptureReport> const &event)
 
 // client::Session::Handler
 
+void Controller::operator()(Trace<client::Session::Flush> const &, uint64_t) {
+  flush();
+}
+
 void Controller::operator()(Trace<client::Session::Disconnected> const &event, uint64_t session_id) {
   auto unsubscribe_market_data = [&](auto &req_id) {
-    if (!ready())
+    if (!market_data_ready())
       return;
     auto market_data_request = codec::fix::MarketDataRequest{
         .md_req_id = req_id,
@@ -790,7 +928,7 @@ void Controller::operator()(Trace<client::Session::Disconnected> const &event, u
         .custom_value = {},
     };
     Trace event_2{event.trace_info, market_data_request};
-    dispatch_to_server(event_2);
+    dispatch_to_market_data(event_2);
   };
   clear_req_ids(subscriptions_.security_req_id, session_id);         // note! subscriptions not yet supported
   clear_req_ids(subscriptions_.security_status_req_id, session_id);  // note! subscriptions not yet supported
@@ -798,15 +936,17 @@ void Controller::operator()(Trace<client::Session::Disconnected> const &event, u
   clear_req_ids(subscriptions_.md_req_id, session_id, unsubscribe_market_data);
   clear_req_ids(subscriptions_.ord_status_req_id, session_id);
   clear_req_ids(subscriptions_.mass_status_req_id, session_id);
-  clear_req_ids(subscriptions_.pos_req_id, session_id);        // note! subscriptions not yet supported
+  clear_req_ids(subscriptions_.pos_req_id, session_id, [&](auto &req_id) { positions_.unsubscribe(req_id); });
   clear_req_ids(subscriptions_.trade_request_id, session_id);  // note! subscriptions not yet supported
   clear_req_ids(subscriptions_.cl_ord_id, session_id);
   clear_req_ids(subscriptions_.mass_cancel_cl_ord_id, session_id);
   // user
   auto iter_2 = subscriptions_.user.session_to_client.find(session_id);
   if (iter_2 != std::end(subscriptions_.user.session_to_client)) {
-    auto &username_2 = (*iter_2).second;
-    if (ready()) {
+    auto username_2 = (*iter_2).second;  // note! copy
+    // note! the user remains logged on with the fix-bridge while other sessions are using it
+    auto last = std::size(user_find(username_2)) <= 1;
+    if (ready() && last) {
       auto user_request_id = shared_.create_request_id();
       auto user_request = codec::fix::UserRequest{
           .user_request_id = user_request_id,
@@ -825,9 +965,7 @@ void Controller::operator()(Trace<client::Session::Disconnected> const &event, u
     //   we can't send ==> fix-bridge is disconnected so it doesn't matter
     //   we get a response => fix-bridge was connected and we expect it to do the right thing
     // therefore: release immediately to allow the client to reconnect
-    log::debug(R"(USER REMOVE client_id="{}" <==> session_id={})"sv, username_2, session_id);
-    subscriptions_.user.client_to_session.erase((*iter_2).second);
-    subscriptions_.user.session_to_client.erase(iter_2);
+    user_remove(username_2, session_id, false);
   } else {
     log::debug("no user associated with session_id={}"sv, session_id);
   }
@@ -840,8 +978,20 @@ void Controller::operator()(Trace<codec::fix::UserRequest> const &event, uint64_
     case LOG_ON_USER:
       if (user_is_locked(user_request.username))
         throw NotReady{"locked"sv};
+      if (!std::empty(user_find(user_request.username))) {
+        // note! already logged on with the fix-bridge
+        user_add(user_request.username, session_id);
+        user_respond(event.trace_info, user_request, session_id, roq::fix::UserStatus::LOGGED_IN);
+        return;
+      }
       break;
     case LOG_OFF_USER:
+      if (std::size(user_find(user_request.username)) > 1) {
+        // note! other sessions are still using the user
+        user_remove(user_request.username, session_id, true);
+        user_respond(event.trace_info, user_request, session_id, roq::fix::UserStatus::NOT_LOGGED_IN);
+        return;
+      }
       break;
     default:
       log::fatal("Unexpected: user_request={}"sv, user_request);
@@ -877,9 +1027,8 @@ void Controller::operator()(Trace<codec::fix::SecurityListRequest> const &event,
     return;
   }
   auto &mapping = subscriptions_.security_req_id;
-  auto &client_to_server = mapping.client_to_server[session_id];
-  auto iter = client_to_server.find(req_id);
-  auto exists = iter != std::end(client_to_server);
+  auto existing = std::string{mapping.find(session_id, req_id)};  // note! req_id(server)
+  auto exists = !std::empty(existing);
   auto subscription_request_type = get_subscription_request_type(event);
   auto dispatch = [&](auto keep_alive) {
     auto request_id = shared_.create_request_id();
@@ -895,8 +1044,8 @@ void Controller::operator()(Trace<codec::fix::SecurityListRequest> const &event,
       assert(
           subscription_request_type == roq::fix::SubscriptionRequestType::SNAPSHOT ||
           subscription_request_type == roq::fix::SubscriptionRequestType::SNAPSHOT_UPDATES);
-      client_to_server.emplace(req_id, request_id);
-      mapping.server_to_client.try_emplace(request_id, session_id, req_id, keep_alive);
+      add_req_id(mapping, req_id, request_id, session_id, keep_alive);
+      add_timeout(mapping, request_id, event.value);
     }
   };
   switch (subscription_request_type) {
@@ -953,9 +1102,8 @@ void Controller::operator()(Trace<codec::fix::SecurityDefinitionRequest> const &
     return;
   }
   auto &mapping = subscriptions_.security_req_id;
-  auto &client_to_server = mapping.client_to_server[session_id];
-  auto iter = client_to_server.find(req_id);
-  auto exists = iter != std::end(client_to_server);
+  auto existing = std::string{mapping.find(session_id, req_id)};  // note! req_id(server)
+  auto exists = !std::empty(existing);
   auto subscription_request_type = get_subscription_request_type(event);
   auto dispatch = [&](auto keep_alive) {
     auto request_id = shared_.create_request_id();
@@ -971,8 +1119,8 @@ void Controller::operator()(Trace<codec::fix::SecurityDefinitionRequest> const &
       assert(
           subscription_request_type == roq::fix::SubscriptionRequestType::SNAPSHOT ||
           subscription_request_type == roq::fix::SubscriptionRequestType::SNAPSHOT_UPDATES);
-      client_to_server.emplace(req_id, request_id);
-      mapping.server_to_client.try_emplace(request_id, session_id, req_id, keep_alive);
+      add_req_id(mapping, req_id, request_id, session_id, keep_alive);
+      add_timeout(mapping, request_id, event.value);
     }
   };
   switch (subscription_request_type) {
@@ -1026,9 +1174,8 @@ void Controller::operator()(Trace<codec::fix::SecurityStatusRequest> const &even
     return;
   }
   auto &mapping = subscriptions_.security_status_req_id;
-  auto &client_to_server = mapping.client_to_server[session_id];
-  auto iter = client_to_server.find(req_id);
-  auto exists = iter != std::end(client_to_server);
+  auto existing = std::string{mapping.find(session_id, req_id)};  // note! req_id(server)
+  auto exists = !std::empty(existing);
   auto subscription_request_type = get_subscription_request_type(event);
   auto dispatch = [&](auto keep_alive) {
     auto request_id = shared_.create_request_id();
@@ -1044,8 +1191,8 @@ void Controller::operator()(Trace<codec::fix::SecurityStatusRequest> const &even
       assert(
           subscription_request_type == roq::fix::SubscriptionRequestType::SNAPSHOT ||
           subscription_request_type == roq::fix::SubscriptionRequestType::SNAPSHOT_UPDATES);
-      client_to_server.emplace(req_id, request_id);
-      mapping.server_to_client.try_emplace(request_id, session_id, req_id, keep_alive);
+      add_req_id(mapping, req_id, request_id, session_id, keep_alive);
+      add_timeout(mapping, request_id, event.value);
     }
   };
   switch (subscription_request_type) {
@@ -1096,16 +1243,21 @@ void Controller::operator()(Trace<codec::fix::MarketDataRequest> const &event, u
         ERROR_VALIDATION);
     return;
   }
+  if (!market_data_ready()) {
+    reject(
+        roq::fix::MDReqRejReason::UNSUPPORTED_SCOPE,  // XXX FIXME what to use ???
+        ERROR_NOT_READY);
+    return;
+  }
   auto &mapping = subscriptions_.md_req_id;
-  auto &client_to_server = mapping.client_to_server[session_id];
-  auto iter = client_to_server.find(req_id);
-  auto exists = iter != std::end(client_to_server);
+  auto existing = std::string{mapping.find(session_id, req_id)};  // note! req_id(server)
+  auto exists = !std::empty(existing);
   auto dispatch = [&](auto keep_alive) {
     auto request_id = shared_.create_request_id();
     auto market_data_request_2 = market_data_request;
     market_data_request_2.md_req_id = request_id;
     Trace event_2{event.trace_info, market_data_request_2};
-    dispatch_to_server(event_2);
+    dispatch_to_market_data(event_2);
     // note! *after* request has been sent
     if (exists) {
       assert(market_data_request.subscription_request_type == roq::fix::SubscriptionRequestType::UNSUBSCRIBE);
@@ -1114,8 +1266,8 @@ void Controller::operator()(Trace<codec::fix::MarketDataRequest> const &event, u
       assert(
           market_data_request.subscription_request_type == roq::fix::SubscriptionRequestType::SNAPSHOT ||
           market_data_request.subscription_request_type == roq::fix::SubscriptionRequestType::SNAPSHOT_UPDATES);
-      client_to_server.emplace(req_id, request_id);
-      mapping.server_to_client.try_emplace(request_id, session_id, req_id, keep_alive);
+      add_req_id(mapping, req_id, request_id, session_id, keep_alive);
+      add_timeout(mapping, request_id, event.value);
     }
   };
   switch (market_data_request.subscription_request_type) {
@@ -1201,26 +1353,19 @@ void Controller::operator()(Trace<codec::fix::OrderStatusRequest> const &event,
   }
   auto req_id = order_status_request.ord_status_req_id;
   auto &mapping = subscriptions_.ord_status_req_id;
-  auto &client_to_server = mapping.client_to_server[session_id];
-  if (!std::empty(req_id)) {  // note! optional
-    auto iter = client_to_server.find(req_id);
-    if (iter != std::end(client_to_server)) {
-      reject(roq::fix::OrdRejReason::OTHER, ERROR_DUPLICATE_ORD_STATUS_REQ_ID);
-      return;
-    }
-  }
   auto client_id = get_client_from_parties(order_status_request);
-  auto request_id = create_request_id(client_id, req_id);
+  // note! req_id is optional (and can't be shared by all sessions of the strategy)
+  auto request_id = std::empty(req_id) ? shared_.create_request_id() : create_request_id(client_id, req_id);
   auto cl_ord_id = create_request_id(client_id, order_status_request.cl_ord_id);
   auto order_status_request_2 = order_status_request;
   order_status_request_2.ord_status_req_id = request_id;
   order_status_request_2.cl_ord_id = cl_ord_id;
   Trace event_2{event.trace_info, order_status_request_2};
-  dispatch_to_server(event_2);
-  // note! *after* request has been sent
-  if (!std::empty(req_id))  // note! optional
-    client_to_server.emplace(req_id, request_id);
-  mapping.server_to_client.try_emplace(request_id, session_id, req_id, false);
+  if (!dispatch_to_server(event_2, mapping, req_id, request_id, session_id, false)) {
+    reject(roq::fix::OrdRejReason::OTHER, ERROR_DUPLICATE_ORD_STATUS_REQ_ID);
+    return;
+  }
+  add_timeout(mapping, request_id, event.value);
 }
 
 void Controller::operator()(Trace<codec::fix::NewOrderSingle> const &event, uint64_t session_id) {
@@ -1275,20 +1420,28 @@ void Controller::operator()(Trace<codec::fix::NewOrderSingle> const &event, uint
   }
   auto req_id = new_order_single.cl_ord_id;
   auto &mapping = subscriptions_.cl_ord_id;
-  auto &client_to_server = mapping.client_to_server[session_id];
   auto client_id = get_client_from_parties(new_order_single);
-  auto iter = client_to_server.find(req_id);
-  if (iter != std::end(client_to_server)) {
+  // note! cl_ord_id(server) is shared by all sessions of the strategy
+  auto request_id = create_request_id(client_id, new_order_single.cl_ord_id);
+  if (mapping.find(request_id) != nullptr) {
     reject(roq::fix::OrdRejReason::OTHER, ERROR_DUPLICATE_CL_ORD_ID);
     return;
   }
-  auto request_id = create_request_id(client_id, new_order_single.cl_ord_id);
+  auto account_id = risk_.find(new_order_single.account);
+  auto error = risk_.check(account_id, new_order_single);
+  if (!std::empty(error)) {
+    reject(roq::fix::OrdRejReason::ORDER_EXCEEDS_LIMIT, error);
+    return;
+  }
   auto new_order_single_2 = new_order_single;
   new_order_single_2.cl_ord_id = request_id;
   Trace event_2{event.trace_info, new_order_single_2};
-  dispatch_to_server(event_2);
-  // note! *after* request has been sent
-  add_req_id(mapping, req_id, request_id, session_id, true);
+  if (!dispatch_to_server(event_2, mapping, req_id, request_id, session_id, true)) {
+    reject(roq::fix::OrdRejReason::OTHER, ERROR_DUPLICATE_CL_ORD_ID);
+    return;
+  }
+  add_origin(request_id, session_id);
+  risk_.add(account_id, request_id);
 }
 
 void Controller::operator()(Trace<codec::fix::OrderCancelReplaceRequest> const &event, uint64_t session_id) {
@@ -1321,27 +1474,36 @@ void Controller::operator()(Trace<codec::fix::OrderCancelReplaceRequest> const &
   }
   auto req_id = order_cancel_replace_request.cl_ord_id;
   auto &mapping = subscriptions_.cl_ord_id;
-  auto &client_to_server = mapping.client_to_server[session_id];
   auto client_id = get_client_from_parties(order_cancel_replace_request);
-  auto iter = client_to_server.find(req_id);
-  if (iter != std::end(client_to_server)) {
+  auto reject_duplicate = [&]() {
     reject(
         ORDER_ID_NONE,
         roq::fix::OrdStatus::REJECTED,  // XXX FIXME should be latest "known"
         roq::fix::CxlRejReason::DUPLICATE_CL_ORD_ID,
         ERROR_DUPLICATE_CL_ORD_ID);
+  };
+  // note! cl_ord_id(server) is shared by all sessions of the strategy
+  auto request_id = create_request_id(client_id, req_id);
+  if (mapping.find(request_id) != nullptr) {
+    reject_duplicate();
+    return;
+  }
+  auto account_id = risk_.find(order_cancel_replace_request.account);
+  auto error = risk_.check(account_id, order_cancel_replace_request);
+  if (!std::empty(error)) {
+    reject(ORDER_ID_NONE, roq::fix::OrdStatus::REJECTED, roq::fix::CxlRejReason::OTHER, error);
     return;
   }
-  auto request_id = create_request_id(client_id, req_id);
   auto orig_cl_ord_id = create_request_id(client_id, order_cancel_replace_request.orig_cl_ord_id);
   auto order_cancel_replace_request_2 = order_cancel_replace_request;
   order_cancel_replace_request_2.cl_ord_id = request_id;
   order_cancel_replace_request_2.orig_cl_ord_id = orig_cl_ord_id;
   Trace event_2{event.trace_info, order_cancel_replace_request_2};
-  dispatch_to_server(event_2);
-  // note! *after* request has been sent
-  client_to_server.emplace(req_id, request_id);
-  mapping.server_to_client.try_emplace(request_id, session_id, req_id, true);
+  if (!dispatch_to_server(event_2, mapping, req_id, request_id, session_id, true)) {
+    reject_duplicate();
+    return;
+  }
+  add_origin(request_id, session_id);
 }
 
 void Controller::operator()(Trace<codec::fix::OrderCancelRequest> const &event, uint64_t session_id) {
@@ -1374,27 +1536,23 @@ void Controller::operator()(Trace<codec::fix::OrderCancelRequest> const &event,
   }
   auto req_id = order_cancel_request.cl_ord_id;
   auto &mapping = subscriptions_.cl_ord_id;
-  auto &client_to_server = mapping.client_to_server[session_id];
   auto client_id = get_client_from_parties(order_cancel_request);
-  auto iter = client_to_server.find(req_id);
-  if (iter != std::end(client_to_server)) {
-    reject(
-        ORDER_ID_NONE,
-        roq::fix::OrdStatus::REJECTED,  // XXX FIXME should be latest "known"
-        roq::fix::CxlRejReason::DUPLICATE_CL_ORD_ID,
-        ERROR_DUPLICATE_ORD_STATUS_REQ_ID);
-    return;
-  }
+  // note! cl_ord_id(server) is shared by all sessions of the strategy
   auto request_id = create_request_id(client_id, order_cancel_request.cl_ord_id);
   auto orig_cl_ord_id = create_request_id(client_id, order_cancel_request.orig_cl_ord_id);
   auto order_cancel_request_2 = order_cancel_request;
   order_cancel_request_2.cl_ord_id = request_id;
   order_cancel_request_2.orig_cl_ord_id = orig_cl_ord_id;
   Trace event_2{event.trace_info, order_cancel_request_2};
-  dispatch_to_server(event_2);
-  // note! *after* request has been sent
-  client_to_server.emplace(req_id, request_id);
-  mapping.server_to_client.try_emplace(request_id, session_id, req_id, true);
+  if (!dispatch_to_server(event_2, mapping, req_id, request_id, session_id, true)) {
+    reject(
+        ORDER_ID_NONE,
+        roq::fix::OrdStatus::REJECTED,  // XXX FIXME should be latest "known"
+        roq::fix::CxlRejReason::DUPLICATE_CL_ORD_ID,
+        ERROR_DUPLICATE_CL_ORD_ID);
+    return;
+  }
+  add_origin(request_id, session_id);
 }
 
 void Controller::operator()(Trace<codec::fix::OrderMassStatusRequest> const &event, uint64_t session_id) {
@@ -1448,21 +1606,17 @@ void Controller::operator()(Trace<codec::fix::OrderMassStatusRequest> const &eve
   }
   auto req_id = order_mass_status_request.mass_status_req_id;
   auto &mapping = subscriptions_.mass_status_req_id;
-  auto &client_to_server = mapping.client_to_server[session_id];
-  auto iter = client_to_server.find(req_id);
-  if (iter != std::end(client_to_server)) {
-    reject(roq::fix::OrdRejReason::OTHER, ERROR_DUPLICATE_MASS_STATUS_REQ_ID);
-    return;
-  }
   auto client_id = get_client_from_parties(order_mass_status_request);
+  // note! req_id(server) is shared by all sessions of the strategy
   auto request_id = create_request_id(client_id, req_id);
   auto order_mass_status_request_2 = order_mass_status_request;
   order_mass_status_request_2.mass_status_req_id = request_id;
   Trace event_2{event.trace_info, order_mass_status_request_2};
-  dispatch_to_server(event_2);
-  // note! *after* request has been sent
-  client_to_server.emplace(req_id, request_id);
-  mapping.server_to_client.try_emplace(request_id, session_id, req_id, false);
+  if (!dispatch_to_server(event_2, mapping, req_id, request_id, session_id, false)) {
+    reject(roq::fix::OrdRejReason::OTHER, ERROR_DUPLICATE_MASS_STATUS_REQ_ID);
+    return;
+  }
+  add_timeout(mapping, request_id, event.value);
 }
 
 void Controller::operator()(Trace<codec::fix::OrderMassCancelRequest> const &event, uint64_t session_id) {
@@ -1490,21 +1644,17 @@ void Controller::operator()(Trace<codec::fix::OrderMassCancelRequest> const &eve
   }
   auto req_id = order_mass_cancel_request.cl_ord_id;
   auto &mapping = subscriptions_.mass_cancel_cl_ord_id;
-  auto &client_to_server = mapping.client_to_server[session_id];
-  auto iter = client_to_server.find(req_id);
-  if (iter != std::end(client_to_server)) {
-    reject(roq::fix::MassCancelRejectReason::OTHER, ERROR_DUPLICATE_CL_ORD_ID);
-    return;
-  }
   auto client_id = get_client_from_parties(order_mass_cancel_request);
+  // note! cl_ord_id(server) is shared by all sessions of the strategy
   auto request_id = create_request_id(client_id, req_id);
   auto order_mass_cancel_request_2 = order_mass_cancel_request;
   order_mass_cancel_request_2.cl_ord_id = request_id;
   Trace event_2{event.trace_info, order_mass_cancel_request_2};
-  dispatch_to_server(event_2);
-  // note! *after* request has been sent
-  client_to_server.emplace(req_id, request_id);
-  mapping.server_to_client.try_emplace(request_id, session_id, req_id, false);
+  if (!dispatch_to_server(event_2, mapping, req_id, request_id, session_id, false)) {
+    reject(roq::fix::MassCancelRejectReason::OTHER, ERROR_DUPLICATE_CL_ORD_ID);
+    return;
+  }
+  add_timeout(mapping, request_id, event.value);
 }
 
 void Controller::operator()(Trace<codec::fix::RequestForPositions> const &event, uint64_t session_id) {
@@ -1532,12 +1682,11 @@ void Controller::operator()(Trace<codec::fix::RequestForPositions> const &event,
     return;
   }
   auto &mapping = subscriptions_.pos_req_id;
-  auto &client_to_server = mapping.client_to_server[session_id];
-  auto iter = client_to_server.find(req_id);
-  auto exists = iter != std::end(client_to_server);
+  auto existing = std::string{mapping.find(session_id, req_id)};  // note! req_id(server)
+  auto exists = !std::empty(existing);
   auto subscription_request_type = get_subscription_request_type(event);
   auto dispatch = [&](auto keep_alive) {
-    auto request_id = exists ? (*iter).second : shared_.create_request_id();
+    auto request_id = exists ? existing : shared_.create_request_id();
     auto request_for_positions_2 = request_for_positions;
     request_for_positions_2.pos_req_id = request_id;
     Trace event_2{event.trace_info, request_for_positions_2};
@@ -1545,10 +1694,9 @@ void Controller::operator()(Trace<codec::fix::RequestForPositions> const &event,
     // note! *after* request has been sent
     if (exists) {
       assert(subscription_request_type == roq::fix::SubscriptionRequestType::UNSUBSCRIBE);  // see below
-      auto iter = mapping.server_to_client.find(request_id);
-      if (iter != std::end(mapping.server_to_client)) {
-        auto &[session_id_2, req_id_2, keep_alive_2] = (*iter).second;
-        keep_alive_2 = keep_alive;
+      auto route = mapping.find(request_id);
+      if (route != nullptr) {
+        (*route).keep_alive = keep_alive;
       } else {
         log::fatal("Unexpected"sv);
       }
@@ -1556,8 +1704,20 @@ void Controller::operator()(Trace<codec::fix::RequestForPositions> const &event,
       assert(
           subscription_request_type == roq::fix::SubscriptionRequestType::SNAPSHOT ||
           subscription_request_type == roq::fix::SubscriptionRequestType::SNAPSHOT_UPDATES);  // see below
-      client_to_server.emplace(req_id, request_id);
-      mapping.server_to_client.try_emplace(request_id, session_id, req_id, keep_alive);
+      add_req_id(mapping, req_id, request_id, session_id, keep_alive);
+      add_timeout(mapping, request_id, event.value);
+    }
+  };
+  // note! served from the position cache once a complete snapshot has been received for the account
+  // the fix-bridge authorizes everyone else (the cache is shared by all users)
+  auto &account = request_for_positions.account;
+  auto local = positions_.is_complete(account) && shared_.is_explicitly_entitled(session_id, account);
+  auto serve = [&](auto keep_alive) {
+    send_positions(event, session_id);
+    if (keep_alive) {
+      auto request_id = shared_.create_request_id();
+      add_req_id(mapping, req_id, request_id, session_id, true);
+      positions_.subscribe(account, request_id);
     }
   };
   switch (subscription_request_type) {
@@ -1569,6 +1729,8 @@ void Controller::operator()(Trace<codec::fix::RequestForPositions> const &event,
     case SNAPSHOT:
       if (exists) {
         reject(ERROR_DUPLICATED_POS_REQ_ID);
+      } else if (local) {
+        serve(false);
       } else {
         dispatch(false);
       }
@@ -1576,13 +1738,19 @@ void Controller::operator()(Trace<codec::fix::RequestForPositions> const &event,
     case SNAPSHOT_UPDATES:
       if (exists) {
         reject(ERROR_DUPLICATED_POS_REQ_ID);
+      } else if (local) {
+        serve(true);
       } else {
         dispatch(true);
       }
       break;
     case UNSUBSCRIBE:
       if (exists) {
-        dispatch(false);
+        if (positions_.unsubscribe(existing)) {
+          remove_req_id(mapping, existing);  // note! local subscription, nothing to send
+        } else {
+          dispatch(false);
+        }
       } else {
         reject(ERROR_UNKNOWN_POS_REQ_ID);
       }
@@ -1612,27 +1780,30 @@ void Controller::operator()(Trace<codec::fix::TradeCaptureReportRequest> const &
     return;
   }
   auto &mapping = subscriptions_.trade_request_id;
-  auto &client_to_server = mapping.client_to_server[session_id];
-  auto iter = client_to_server.find(req_id);
-  auto exists = iter != std::end(client_to_server);
+  auto existing = std::string{mapping.find(session_id, req_id)};  // note! req_id(server)
+  auto exists = !std::empty(existing);
   auto subscription_request_type = get_subscription_request_type(event);
   auto dispatch = [&](auto keep_alive) {
     auto client_id = get_client_from_parties(trade_capture_report_request);
+    // note! req_id(server) is shared by all sessions of the strategy
     auto request_id = create_request_id(client_id, req_id);
     auto trade_capture_report_request_2 = trade_capture_report_request;
     trade_capture_report_request_2.trade_request_id = request_id;
     Trace event_2{event.trace_info, trade_capture_report_request_2};
-    dispatch_to_server(event_2);
-    // note! *after* request has been sent
     if (exists) {
       assert(subscription_request_type == roq::fix::SubscriptionRequestType::UNSUBSCRIBE);
+      dispatch_to_server(event_2);
+      // note! *after* request has been sent
       remove_req_id(mapping, request_id);  // note! protocol doesn't have an ack for unsubscribe
     } else {
       assert(
           subscription_request_type == roq::fix::SubscriptionRequestType::SNAPSHOT ||
           subscription_request_type == roq::fix::SubscriptionRequestType::SNAPSHOT_UPDATES);
-      client_to_server.emplace(req_id, request_id);
-      mapping.server_to_client.try_emplace(request_id, session_id, req_id, keep_alive);
+      if (!dispatch_to_server(event_2, mapping, req_id, request_id, session_id, keep_alive)) {
+        reject(ERROR_DUPLICATE_TRADE_REQUEST_ID);
+        return;
+      }
+      add_timeout(mapping, request_id, event.value);
     }
   };
   switch (subscription_request_type) {
@@ -1674,6 +1845,8 @@ void Controller::dispatch(Args &&...args) {
   if (static_cast<bool>(auth_session_))
     (*auth_session_)(event);
   server_session_(event);
+  if (static_cast<bool>(market_data_session_))
+    (*market_data_session_)(event);
   client_manager_(event);
 }
 
@@ -1682,11 +1855,69 @@ void Controller::dispatch_to_server(Trace<T> const &event) {
   server_session_(event);
 }
 
+// note! the route is reserved *before* the request is sent
+// server side req_ids derived from the client's req_id are shared by all sessions of the strategy
+// returns false (and sends nothing) if either req_id is already in use
+template <typename T>
+bool Controller::dispatch_to_server(
+    Trace<T> const &event,
+    auto &mapping,
+    std::string_view const &req_id,
+    std::string_view const &request_id,
+    uint64_t session_id,
+    bool keep_alive) {
+  if (!add_req_id(mapping, req_id, request_id, session_id, keep_alive))
+    return false;
+  try {
+    dispatch_to_server(event);
+  } catch (...) {
+    remove_req_id(mapping, request_id);
+    throw;
+  }
+  return true;
+}
+
 template <typename T>
-bool Controller::dispatch_to_client(Trace<T> const &event, uint64_t session_id) {
+void Controller::dispatch_to_market_data(Trace<T> const &event) {
+  if (static_cast<bool>(market_data_session_))
+    (*market_data_session_)(event);
+  else
+    server_session_(event);
+}
+
+// note! held messages are sent when an inbound batch (from any session) has been processed
+void Controller::flush() {
+  shared_.batch_end([&](auto session_id) { client_manager_.find(session_id, [](auto &session) { session.flush(); }); });
+  server_session_.flush();
+  if (static_cast<bool>(market_data_session_))
+    (*market_data_session_).flush();
+}
+
+// note! subscriptions are lost when the market data session disconnects
+void Controller::reject_market_data_subscriptions(TraceInfo const &trace_info) {
+  auto &mapping = subscriptions_.md_req_id;
+  std::vector<std::string> req_ids;
+  mapping.get_all([&](auto &req_id, auto &) { req_ids.emplace_back(req_id); });
+  for (auto &req_id : req_ids) {
+    auto dispatch = [&](auto session_id, auto &req_id, [[maybe_unused]] auto keep_alive) {
+      auto market_data_request_reject = roq::codec::fix::MarketDataRequestReject{
+          .md_req_id = req_id,
+          .md_req_rej_reason = roq::fix::MDReqRejReason::UNSUPPORTED_SCOPE,  // XXX FIXME what to use ???
+          .text = ERROR_DISCONNECTED,
+      };
+      Trace event{trace_info, market_data_request_reject};
+      dispatch_to_client(event, session_id);
+    };
+    find_req_id(mapping, req_id, dispatch);
+    remove_req_id(mapping, req_id);
+  }
+}
+
+template <typename T, typename... Args>
+bool Controller::dispatch_to_client(Trace<T> const &event, uint64_t session_id, Args &&...args) {
   auto success = false;
   client_manager_.find(session_id, [&](auto &session) {
-    session(event);
+    session(event, std::forward<Args>(args)...);
     success = true;
   });
   if (!success)
@@ -1694,68 +1925,197 @@ bool Controller::dispatch_to_client(Trace<T> const &event, uint64_t session_id)
   return success;
 }
 
-template <typename T>
-void Controller::broadcast(Trace<T> const &event, std::string_view const &client_id) {
-  auto iter = subscriptions_.user.client_to_session.find(client_id);
-  if (iter == std::end(subscriptions_.user.client_to_session))
-    return;
-  auto session_id = (*iter).second;
-  client_manager_.find(session_id, [&](auto &session) { session(event); });
+template <typename T, typename... Args>
+void Controller::broadcast(
+    Trace<T> const &event, std::string_view const &client_id, std::string_view const &cl_ord_id, Args &&...args) {
+  auto sessions = user_find(client_id);
+  if (!shared_.settings.client.broadcast_execution_reports) {
+    auto iter = cl_ord_id_.origin.find(cl_ord_id);
+    if (iter != std::end(cl_ord_id_.origin)) {
+      auto session_id = (*iter).second;
+      if (std::find(std::begin(sessions), std::end(sessions), session_id) != std::end(sessions)) {
+        client_manager_.find(session_id, [&](auto &session) { session(event, args...); });
+        return;
+      }
+    }
+    // note! falls back to all sessions if the originating session is unknown or has gone
+  }
+  for (auto session_id : sessions)
+    client_manager_.find(session_id, [&](auto &session) { session(event, args...); });
 }
 
 // req_id
 
 template <typename Callback>
 bool Controller::find_req_id(auto &mapping, std::string_view const &req_id, Callback callback) {
-  auto iter = mapping.server_to_client.find(req_id);
-  if (iter == std::end(mapping.server_to_client))
+  auto route = mapping.find(req_id);
+  if (route == nullptr)
     return false;
-  auto &[session_id, client_req_id, keep_alive] = (*iter).second;
-  callback(session_id, client_req_id, keep_alive);
+  remove_timeout(*route);
+  callback((*route).session_id, (*route).req_id, (*route).keep_alive);
   return true;
 }
 
-void Controller::add_req_id(
+bool Controller::add_req_id(
     auto &mapping,
     std::string_view const &req_id,
     std::string_view const &request_id,
     uint64_t session_id,
     bool keep_alive) {
-  auto &client_to_server = mapping.client_to_server[session_id];
-  client_to_server.emplace(req_id, request_id);
-  mapping.server_to_client.try_emplace(request_id, session_id, req_id, keep_alive);
+  if (mapping.add(req_id, request_id, session_id, keep_alive))
+    return true;
+  log::warn(R"(DEBUG: DUPLICATE req_id(client)="{}" <==> req_id(server)="{}")"sv, req_id, request_id);
+  return false;
 }
 
 bool Controller::remove_req_id(auto &mapping, std::string_view const &req_id) {
   if (std::empty(req_id))
     return true;
-  auto iter_1 = mapping.server_to_client.find(req_id);
-  if (iter_1 == std::end(mapping.server_to_client))
-    return false;
-  auto &[session_id, client_req_id, keep_alive] = (*iter_1).second;
-  auto iter_2 = mapping.client_to_server.find(session_id);
-  if (iter_2 != std::end(mapping.client_to_server)) {
-    log::warn(R"(DEBUG: REMOVE req_id(client)="{} <==> req_id(server)="{}")"sv, client_req_id, req_id);
-    (*iter_2).second.erase(client_req_id);
-    if (std::empty((*iter_2).second))
-      mapping.client_to_server.erase(iter_2);
-  }
-  log::warn(R"(DEBUG: REMOVE req_id(server)="{}")"sv, req_id);
-  mapping.server_to_client.erase(iter_1);
-  return true;
+  return mapping.remove(req_id, [&](auto &route) {
+    log::warn(R"(DEBUG: REMOVE req_id(client)="{} <==> req_id(server)="{}")"sv, route.req_id, req_id);
+    remove_timeout(route);
+  });
 }
 
 template <typename Callback>
 void Controller::clear_req_ids(auto &mapping, uint64_t session_id, Callback callback) {
-  auto iter = mapping.client_to_server.find(session_id);
-  if (iter == std::end(mapping.client_to_server))
-    return;
-  auto &tmp = (*iter).second;
-  for (auto &[_, req_id] : tmp) {
+  mapping.clear(session_id, [&](auto &req_id, auto &route) {
     callback(req_id);
-    mapping.server_to_client.erase(req_id);
+    remove_timeout(route);
+  });
+}
+
+// timeout
+
+void Controller::add_timeout(auto &mapping, std::string_view const &req_id, auto const &request) {
+  using value_type = std::remove_cvref<decltype(request)>::type;
+  auto route = mapping.find(req_id);
+  if (route == nullptr)
+    return;
+  auto now = shared_.clock.get_system();
+  auto timeout = Timeout{
+      .mapping = &mapping,
+      .ref_msg_type = value_type::MSG_TYPE,
+      .req_id = std::string{req_id},
+      .account = {},
+      .account_type = {},
+      .trade_request_type = {},
+      .symbol = {},
+      .security_exchange = {},
+  };
+  if constexpr (std::is_same<value_type, codec::fix::RequestForPositions>::value) {
+    timeout.account = request.account;
+    timeout.account_type = request.account_type;
+  } else if constexpr (std::is_same<value_type, codec::fix::TradeCaptureReportRequest>::value) {
+    timeout.trade_request_type = request.trade_request_type;
+    timeout.symbol = request.symbol;
+    timeout.security_exchange = request.security_exchange;
+  }
+  (*route).timeout = timeouts_.add(now, now + shared_.settings.server.request_timeout, std::move(timeout));
+}
+
+void Controller::remove_timeout(auto &route) {
+  if (!route.timeout)
+    return;
+  timeouts_.remove(route.timeout);
+  route.timeout = {};
+}
+
+// note! subscriptions may still have been created by the fix-bridge (and must therefore be cancelled)
+void Controller::request_timeout(Timeout const &timeout, tools::Router::Route const &route) {
+  TraceInfo trace_info;
+  switch (timeout.ref_msg_type) {
+    using enum roq::fix::MsgType;
+    case MARKET_DATA_REQUEST: {
+      if (route.keep_alive && market_data_ready()) {
+        auto market_data_request = codec::fix::MarketDataRequest{
+            .md_req_id = timeout.req_id,
+            .subscription_request_type = roq::fix::SubscriptionRequestType::UNSUBSCRIBE,
+            .market_depth = {},
+            .md_update_type = {},
+            .aggregated_book = {},
+            .no_md_entry_types = {},  // note! non-standard -- fix-bridge will unsubscribe all
+            .no_related_sym = {},
+            .no_trading_sessions = {},
+            .custom_type = {},
+            .custom_value = {},
+        };
+        Trace event{trace_info, market_data_request};
+        dispatch_to_market_data(event);
+      }
+      auto market_data_request_reject = codec::fix::MarketDataRequestReject{
+          .md_req_id = route.req_id,
+          .md_req_rej_reason = roq::fix::MDReqRejReason::UNSUPPORTED_SCOPE,  // XXX FIXME what to use ???
+          .text = ERROR_REQUEST_TIMEOUT,
+      };
+      Trace event{trace_info, market_data_request_reject};
+      dispatch_to_client(event, route.session_id);
+      break;
+    }
+    case REQUEST_FOR_POSITIONS: {
+      if (route.keep_alive && ready()) {
+        auto request_for_positions = codec::fix::RequestForPositions{};
+        request_for_positions.pos_req_id = timeout.req_id;
+        request_for_positions.subscription_request_type = roq::fix::SubscriptionRequestType::UNSUBSCRIBE;
+        request_for_positions.account = timeout.account;
+        request_for_positions.account_type = timeout.account_type;
+        Trace event{trace_info, request_for_positions};
+        dispatch_to_server(event);
+      }
+      auto pos_maint_rpt_id = shared_.create_request_id();
+      auto request_for_positions_ack = codec::fix::RequestForPositionsAck{
+          .pos_maint_rpt_id = pos_maint_rpt_id,  // required
+          .pos_req_id = route.req_id,
+          .total_num_pos_reports = {},
+          .unsolicited_indicator = false,
+          .pos_req_result = roq::fix::PosReqResult::INVALID_OR_UNSUPPORTED,  // required
+          .pos_req_status = roq::fix::PosReqStatus::REJECTED,                // required
+          .no_party_ids = {},                                                // required
+          .account = timeout.account,                                        // required
+          .account_type = timeout.account_type,                              // required
+          .text = ERROR_REQUEST_TIMEOUT,
+      };
+      Trace event{trace_info, request_for_positions_ack};
+      dispatch_to_client(event, route.session_id);
+      break;
+    }
+    case TRADE_CAPTURE_REPORT_REQUEST: {
+      if (route.keep_alive && ready()) {
+        auto trade_capture_report_request = codec::fix::TradeCaptureReportRequest{};
+        trade_capture_report_request.trade_request_id = timeout.req_id;
+        trade_capture_report_request.trade_request_type = timeout.trade_request_type;
+        trade_capture_report_request.subscription_request_type = roq::fix::SubscriptionRequestType::UNSUBSCRIBE;
+        trade_capture_report_request.symbol = timeout.symbol;
+        trade_capture_report_request.security_exchange = timeout.security_exchange;
+        Trace event{trace_info, trade_capture_report_request};
+        dispatch_to_server(event);
+      }
+      auto trade_capture_report_request_ack = codec::fix::TradeCaptureReportRequestAck{
+          .trade_request_id = route.req_id,                                // required
+          .trade_request_type = timeout.trade_request_type,                // required
+          .trade_request_result = roq::fix::TradeRequestResult::OTHER,     // required
+          .trade_request_status = roq::fix::TradeRequestStatus::REJECTED,  // required
+          .symbol = timeout.symbol,                                        // required
+          .security_exchange = timeout.security_exchange,                  // required
+          .text = ERROR_REQUEST_TIMEOUT,
+      };
+      Trace event{trace_info, trade_capture_report_request_ack};
+      dispatch_to_client(event, route.session_id);
+      break;
+    }
+    default: {
+      auto business_message_reject = codec::fix::BusinessMessageReject{
+          .ref_seq_num = {},
+          .ref_msg_type = timeout.ref_msg_type,                             // required
+          .business_reject_ref_id = route.req_id,                           // required (sometimes)
+          .business_reject_reason = roq::fix::BusinessRejectReason::OTHER,  // required
+          .text = ERROR_REQUEST_TIMEOUT,
+      };
+      Trace event{trace_info, business_message_reject};
+      dispatch_to_client(event, route.session_id);
+      break;
+    }
   }
-  mapping.client_to_server.erase(iter);
 }
 
 // cl_ord_id
@@ -1786,34 +2146,176 @@ void Controller::remove_cl_ord_id(std::string_view const &cl_ord_id) {
   }
 }
 
+void Controller::add_origin(std::string_view const &cl_ord_id, uint64_t session_id) {
+  if (shared_.settings.client.broadcast_execution_reports)
+    return;
+  cl_ord_id_.origin.try_emplace(cl_ord_id, session_id);
+}
+
+void Controller::remove_origin(std::string_view const &cl_ord_id) {
+  if (std::empty(cl_ord_id))
+    return;
+  auto iter = cl_ord_id_.origin.find(cl_ord_id);
+  if (iter != std::end(cl_ord_id_.origin))
+    cl_ord_id_.origin.erase(iter);
+}
+
+// positions
+
+void Controller::send_positions(Trace<codec::fix::RequestForPositions> const &event, uint64_t session_id) {
+  auto &request_for_positions = event.value;
+  auto &account = request_for_positions.account;
+  auto total_num_pos_reports = static_cast<uint32_t>(positions_.size(account));
+  auto request_id = shared_.create_request_id();
+  auto request_for_positions_ack = codec::fix::RequestForPositionsAck{
+      .pos_maint_rpt_id = request_id,  // required
+      .pos_req_id = request_for_positions.pos_req_id,
+      .total_num_pos_reports = total_num_pos_reports,
+      .unsolicited_indicator = false,
+      .pos_req_result = roq::fix::PosReqResult::VALID,     // required
+      .pos_req_status = roq::fix::PosReqStatus::COMPLETED,  // required
+      .no_party_ids = request_for_positions.no_party_ids,   // required
+      .account = account,                                   // required
+      .account_type = request_for_positions.account_type,   // required
+      .text = {},
+  };
+  Trace event_2{event.trace_info, request_for_positions_ack};
+  dispatch_to_client(event_2, session_id);
+  positions_.get(account, [&](auto &position) {
+    auto pos_maint_rpt_id = shared_.create_request_id();
+    create_position_report(
+        account,
+        position,
+        request_for_positions.pos_req_id,
+        pos_maint_rpt_id,
+        total_num_pos_reports,
+        false,
+        [&](auto &position_report) {
+          Trace event_3{event.trace_info, position_report};
+          dispatch_to_client(event_3, session_id);
+        });
+  });
+}
+
+void Controller::publish_position(
+    TraceInfo const &trace_info, std::string_view const &account, Positions::Position const &position) {
+  positions_.get_subscriptions(account, [&](auto &request_id) {
+    auto dispatch = [&](auto session_id, auto &req_id, [[maybe_unused]] auto keep_alive) {
+      auto pos_maint_rpt_id = shared_.create_request_id();
+      create_position_report(account, position, req_id, pos_maint_rpt_id, 1, false, [&](auto &position_report) {
+        Trace event{trace_info, position_report};
+        dispatch_to_client(event, session_id);
+      });
+    };
+    find_req_id(subscriptions_.pos_req_id, request_id, dispatch);
+  });
+}
+
+// note! local subscriptions are rejected when the position cache can no longer be maintained
+void Controller::reject_position_subscription(
+    TraceInfo const &trace_info,
+    std::string_view const &account,
+    std::string_view const &request_id,
+    std::string_view const &text) {
+  auto &mapping = subscriptions_.pos_req_id;
+  auto dispatch = [&](auto session_id, auto &req_id, [[maybe_unused]] auto keep_alive) {
+    auto pos_maint_rpt_id = shared_.create_request_id();
+    auto request_for_positions_ack = codec::fix::RequestForPositionsAck{
+        .pos_maint_rpt_id = pos_maint_rpt_id,  // required
+        .pos_req_id = req_id,
+        .total_num_pos_reports = {},
+        .unsolicited_indicator = true,
+        .pos_req_result = roq::fix::PosReqResult::INVALID_OR_UNSUPPORTED,  // required
+        .pos_req_status = roq::fix::PosReqStatus::REJECTED,                // required
+        .no_party_ids = {},                                                // required
+        .account = account,                                                // required
+        .account_type = {},                                                // required
+        .text = text,
+    };
+    Trace event{trace_info, request_for_positions_ack};
+    dispatch_to_client(event, session_id);
+  };
+  find_req_id(mapping, request_id, dispatch);
+  remove_req_id(mapping, request_id);
+}
+
 // user
 
 void Controller::user_add(std::string_view const &username, uint64_t session_id) {
   log::info(R"(DEBUG: USER ADD client_id="{}" <==> session_id={})"sv, username, session_id);
-  auto res_1 = subscriptions_.user.client_to_session.try_emplace(username, session_id).second;
-  if (!res_1)
-    log::fatal("Unexpected"sv);
-  auto res_2 = subscriptions_.user.session_to_client.try_emplace(session_id, username).second;
-  if (!res_2)
+  auto sessions = user_sessions(username, true);
+  if (sessions == nullptr)
+    log::fatal(R"(Unexpected: client_id="{}" (expected strategy_id))"sv, username);
+  auto res = subscriptions_.user.session_to_client.try_emplace(session_id, username).second;
+  if (!res)
     log::fatal("Unexpected"sv);
+  (*sessions).emplace_back(session_id);
 }
 
-void Controller::user_remove(std::string_view const &username, bool ready) {
-  auto iter = subscriptions_.user.client_to_session.find(username);
-  if (iter != std::end(subscriptions_.user.client_to_session)) {
-    auto session_id = (*iter).second;
+void Controller::user_remove(std::string_view const &username, uint64_t session_id, bool ready) {
+  auto sessions = user_sessions(username, false);
+  if (sessions != nullptr && std::erase(*sessions, session_id) > 0) {
     log::info(R"(DEBUG: USER REMOVE client_id="{}" <==> session_id={})"sv, username, session_id);
     subscriptions_.user.session_to_client.erase(session_id);
-    subscriptions_.user.client_to_session.erase(iter);
   } else if (ready) {
     // note! disconnect doesn't wait before cleaning up the resources
     log::fatal(R"(Unexpected: client_id="{}")"sv, username);
   }
 }
 
+std::span<uint64_t const> Controller::user_find(std::string_view const &username) const {
+  auto strategy_id = get_strategy_id(username);
+  auto &user = subscriptions_.user;
+  if (strategy_id < std::size(user.strategy_to_sessions))
+    return user.strategy_to_sessions[strategy_id];
+  if (strategy_id <= MAX_DIRECT_STRATEGY_ID)
+    return {};
+  auto iter = user.strategy_to_sessions_fallback.find(strategy_id);
+  if (iter == std::end(user.strategy_to_sessions_fallback))
+    return {};
+  return (*iter).second;
+}
+
+// note! returns nullptr if the client_id is not a strategy_id
+std::vector<uint64_t> *Controller::user_sessions(std::string_view const &username, bool create) {
+  auto strategy_id = get_strategy_id(username);
+  if (strategy_id == UNDEFINED_STRATEGY_ID)
+    return nullptr;
+  auto &user = subscriptions_.user;
+  if (strategy_id <= MAX_DIRECT_STRATEGY_ID) {
+    if (strategy_id >= std::size(user.strategy_to_sessions)) {
+      if (!create)
+        return nullptr;
+      user.strategy_to_sessions.resize(strategy_id + 1);
+    }
+    return &user.strategy_to_sessions[strategy_id];
+  }
+  if (create)
+    return &user.strategy_to_sessions_fallback[strategy_id];
+  auto iter = user.strategy_to_sessions_fallback.find(strategy_id);
+  if (iter == std::end(user.strategy_to_sessions_fallback))
+    return nullptr;
+  return &(*iter).second;
+}
+
 bool Controller::user_is_locked(std::string_view const &username) const {
-  auto iter = subscriptions_.user.client_to_session.find(username);
-  return iter != std::end(subscriptions_.user.client_to_session);
+  return std::size(user_find(username)) >= shared_.settings.client.max_sessions_per_user;
+}
+
+// note! the fix-bridge is not involved when other sessions are using the same user
+void Controller::user_respond(
+    TraceInfo const &trace_info,
+    codec::fix::UserRequest const &user_request,
+    uint64_t session_id,
+    roq::fix::UserStatus user_status) {
+  auto user_response = codec::fix::UserResponse{
+      .user_request_id = user_request.user_request_id,
+      .username = user_request.username,
+      .user_status = user_status,
+      .user_status_text = {},
+  };
+  Trace event{trace_info, user_response};
+  dispatch_to_client(event, session_id);
 }
 
 }  // namespace fix
@@ -5,6 +5,7 @@
 #include <memory>
 #include <span>
 #include <string_view>
+#include <vector>
 
 #include "roq/utils/container.hpp"
 
@@ -14,6 +15,8 @@
 #include "roq/io/sys/timer.hpp"
 
 #include "roq/proxy/fix/config.hpp"
+#include "roq/proxy/fix/positions.hpp"
+#include "roq/proxy/fix/risk.hpp"
 #include "roq/proxy/fix/settings.hpp"
 #include "roq/proxy/fix/shared.hpp"
 
@@ -24,6 +27,9 @@
 #include "roq/proxy/fix/client/manager.hpp"
 #include "roq/proxy/fix/client/session.hpp"
 
+#include "roq/proxy/fix/tools/router.hpp"
+#include "roq/proxy/fix/tools/timer_wheel.hpp"
+
 namespace roq {
 namespace proxy {
 namespace fix {
@@ -39,6 +45,7 @@ struct Controller final : public io::sys::Signal::Handler,
 
  protected:
   bool ready() const { return ready_; }
+  bool market_data_ready() const { return market_data_session_ ? market_data_ready_ : ready_; }
 
   // io::sys::Signal::Handler
   void operator()(io::sys::Signal::Event const &) override;
@@ -53,6 +60,7 @@ struct Controller final : public io::sys::Signal::Handler,
   // server::Session::Handler
   void operator()(Trace<server::Session::Ready> const &) override;
   void operator()(Trace<server::Session::Disconnected> const &) override;
+  void operator()(Trace<server::Session::Flush> const &) override;
   //
   void operator()(Trace<codec::fix::BusinessMessageReject> const &) override;
   // - user
@@ -63,12 +71,12 @@ struct Controller final : public io::sys::Signal::Handler,
   void operator()(Trace<codec::fix::SecurityStatus> const &) override;
   // - market data
   void operator()(Trace<codec::fix::MarketDataRequestReject> const &) override;
-  void operator()(Trace<codec::fix::MarketDataSnapshotFullRefresh> const &) override;
-  void operator()(Trace<codec::fix::MarketDataIncrementalRefresh> const &) override;
+  void operator()(Trace<tools::Lazy<codec::fix::MarketDataSnapshotFullRefresh>> const &) override;
+  void operator()(Trace<tools::Lazy<codec::fix::MarketDataIncrementalRefresh>> const &) override;
   // - orders
   void operator()(Trace<codec::fix::OrderCancelReject> const &) override;
   void operator()(Trace<codec::fix::OrderMassCancelReport> const &) override;
-  void operator()(Trace<codec::fix::ExecutionReport> const &) override;
+  void operator()(Trace<codec::fix::ExecutionReport> const &, std::span<std::byte const> const &message) override;
   // - positions
   void operator()(Trace<codec::fix::RequestForPositionsAck> const &) override;
   void operator()(Trace<codec::fix::PositionReport> const &) override;
@@ -78,6 +86,7 @@ struct Controller final : public io::sys::Signal::Handler,
 
   // client::Session::Handler
   void operator()(Trace<client::Session::Disconnected> const &, uint64_t session_id) override;
+  void operator()(Trace<client::Session::Flush> const &, uint64_t session_id) override;
   // - user
   void operator()(Trace<codec::fix::UserRequest> const &, uint64_t session_id) override;
   // - security
@@ -107,15 +116,31 @@ struct Controller final : public io::sys::Signal::Handler,
   void dispatch_to_server(Trace<T> const &);
 
   template <typename T>
-  bool dispatch_to_client(Trace<T> const &, uint64_t session_id);
+  void dispatch_to_market_data(Trace<T> const &);
+
+  void reject_market_data_subscriptions(TraceInfo const &);
+
+  void flush();
 
   template <typename T>
-  void broadcast(Trace<T> const &, std::string_view const &client_id);
+  bool dispatch_to_server(
+      Trace<T> const &,
+      auto &mapping,
+      std::string_view const &req_id_client,
+      std::string_view const &req_id_server,
+      uint64_t session_id,
+      bool keep_alive);
+
+  template <typename T, typename... Args>
+  bool dispatch_to_client(Trace<T> const &, uint64_t session_id, Args &&...);
+
+  template <typename T, typename... Args>
+  void broadcast(Trace<T> const &, std::string_view const &client_id, std::string_view const &cl_ord_id, Args &&...);
 
   template <typename Callback>
   bool find_req_id(auto &mapping, std::string_view const &req_id, Callback callback);
 
-  void add_req_id(
+  bool add_req_id(
       auto &mapping,
       std::string_view const &req_id_client,
       std::string_view const &req_id_server,
@@ -131,12 +156,33 @@ struct Controller final : public io::sys::Signal::Handler,
     clear_req_ids(mapping, session_id, []([[maybe_unused]] auto &req_id) {});
   }
 
+  // note! request is the original (client) request
+  void add_timeout(auto &mapping, std::string_view const &req_id, auto const &request);
+  void remove_timeout(auto &route);
+
   void ensure_cl_ord_id(std::string_view const &cl_ord_id, roq::fix::OrdStatus);
   void remove_cl_ord_id(std::string_view const &cl_ord_id);
 
+  void add_origin(std::string_view const &cl_ord_id, uint64_t session_id);
+  void remove_origin(std::string_view const &cl_ord_id);
+
+  void send_positions(Trace<codec::fix::RequestForPositions> const &, uint64_t session_id);
+  void publish_position(TraceInfo const &, std::string_view const &account, Positions::Position const &);
+  void request_timeout(Timeout const &, tools::Router::Route const &);
+
+  void reject_position_subscription(
+      TraceInfo const &,
+      std::string_view const &account,
+      std::string_view const &request_id,
+      std::string_view const &text);
+
   void user_add(std::string_view const &username, uint64_t session_id);
-  void user_remove(std::string_view const &username, bool ready);
+  void user_remove(std::string_view const &username, uint64_t session_id, bool ready);
+  std::span<uint64_t const> user_find(std::string_view const &username) const;
+  std::vector<uint64_t> *user_sessions(std::string_view const &username, bool create);
   bool user_is_locked(std::string_view const &username) const;
+  void user_respond(
+      TraceInfo const &, codec::fix::UserRequest const &, uint64_t session_id, roq::fix::UserStatus user_status);
 
  private:
   io::Context &context_;
@@ -146,24 +192,23 @@ struct Controller final : public io::sys::Signal::Handler,
   Shared shared_;
   std::unique_ptr<auth::Session> auth_session_;
   server::Session server_session_;
+  std::unique_ptr<server::Session> market_data_session_;  // note! null if market data shares the order entry session
   client::Manager client_manager_;
   bool ready_ = {};
+  bool market_data_ready_ = {};
   // req_id mappings
+  using Mapping = tools::Router;
   struct {
     struct {
-      utils::unordered_map<std::string, uint64_t> client_to_session;
+      // strategy_id => session_id's (note! client_id is the strategy_id, direct index when small)
+      std::vector<std::vector<uint64_t>> strategy_to_sessions;
+      utils::unordered_map<uint32_t, std::vector<uint64_t>> strategy_to_sessions_fallback;
       utils::unordered_map<uint64_t, std::string> session_to_client;
       // user_request_id => session_id
       utils::unordered_map<std::string, uint64_t> server_to_client;
       // session_id => user_request_id
       utils::unordered_map<uint64_t, std::string> client_to_server;
     } user;
-    struct Mapping final {
-      // req_id(server) => {session_id, req_id(client), keep_alive}
-      utils::unordered_map<std::string, std::tuple<uint64_t, std::string, bool>> server_to_client;
-      // session_id => req_id(client) => req_id(server)
-      utils::unordered_map<uint64_t, utils::unordered_map<std::string, std::string>> client_to_server;
-    };
     Mapping security_req_id;
     Mapping security_status_req_id;
     Mapping trad_ses_req_id;
@@ -178,9 +223,24 @@ struct Controller final : public io::sys::Signal::Handler,
   struct {
     // cl_ord_id(server) => order status
     utils::unordered_map<std::string, roq::fix::OrdStatus> state;
+    // cl_ord_id(server) => session_id (only used when execution reports are not broadcast)
+    utils::unordered_map<std::string, uint64_t> origin;
   } cl_ord_id_;
-  // WORK-AROUND
-  uint32_t total_num_pos_reports_ = {};
+  Positions positions_;
+  Risk risk_;
+  // req_id(server) => request timeout
+  struct Timeout final {
+    Mapping *mapping = {};
+    roq::fix::MsgType ref_msg_type = {};
+    std::string req_id;  // server
+    // note! only used for the native reject (and unsubscribe)
+    std::string account;  // RequestForPositions
+    roq::fix::AccountType account_type = {};
+    roq::fix::TradeRequestType trade_request_type = {};  // TradeCaptureReportRequest
+    std::string symbol;
+    std::string security_exchange;
+  };
+  tools::TimerWheel<Timeout> timeouts_;
 };
 
 }  // namespace fix
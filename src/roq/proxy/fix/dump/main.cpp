@@ -0,0 +1,99 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+
+#include <magic_enum.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "roq/utils/charconv.hpp"
+
+#include "roq/utils/debug/fix/message.hpp"
+
+#include "roq/proxy/fix/tools/capture.hpp"
+
+using namespace std::literals;
+
+using namespace roq::proxy::fix;
+
+// note!
+// decodes a binary capture file (see tools::Capture)
+// usage: roq-fix-proxy-dump <file> [--session-id=<id>] [--direction=<client_inbound|client_outbound|...>]
+
+// === CONSTANTS ===
+
+namespace {
+auto const SESSION_ID = "--session-id="sv;
+auto const DIRECTION = "--direction="sv;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+struct Filter final {
+  std::optional<uint64_t> session_id;
+  std::optional<tools::Capture::Direction> direction;
+
+  bool operator()(tools::Capture::Header const &header) const {
+    if (session_id && header.session_id != *session_id)
+      return false;
+    if (direction && header.direction != *direction)
+      return false;
+    return true;
+  }
+};
+
+auto parse_direction(std::string_view const &value) -> tools::Capture::Direction {
+  auto result = magic_enum::enum_cast<tools::Capture::Direction>(value, magic_enum::case_insensitive);
+  if (!result)
+    throw std::invalid_argument{fmt::format(R"(Unexpected: direction="{}")"sv, value)};
+  return *result;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+int main(int argc, char **argv) {
+  auto args = std::span{argv, static_cast<size_t>(argc)}.subspan(1);
+  if (std::empty(args)) {
+    fmt::print(stderr, "Usage: {} <file> [{}<id>] [{}<direction>]\n"sv, argv[0], SESSION_ID, DIRECTION);
+    return EXIT_FAILURE;
+  }
+  try {
+    std::string_view path = args[0];
+    Filter filter;
+    for (std::string_view arg : args.subspan(1)) {
+      if (arg.starts_with(SESSION_ID)) {
+        filter.session_id = roq::utils::from_chars<uint64_t>(arg.substr(std::size(SESSION_ID)));
+      } else if (arg.starts_with(DIRECTION)) {
+        filter.direction = parse_direction(arg.substr(std::size(DIRECTION)));
+      } else {
+        throw std::invalid_argument{fmt::format(R"(Unexpected: arg="{}")"sv, arg)};
+      }
+    }
+    tools::Capture::Reader reader{path};
+    tools::Capture::Header header;
+    std::span<std::byte const> message;
+    while (reader(header, message)) {
+      if (!filter(header))
+        continue;
+      auto timestamp = std::chrono::sys_time<std::chrono::nanoseconds>{std::chrono::nanoseconds{header.timestamp}};
+      fmt::print(
+          "{:%Y-%m-%dT%H:%M:%S} {} session_id={} {}\n"sv,
+          timestamp,
+          magic_enum::enum_name(header.direction),
+          header.session_id,
+          roq::utils::debug::fix::Message{message});
+    }
+    return EXIT_SUCCESS;
+  } catch (std::exception &e) {
+    fmt::print(stderr, "Error: {}\n"sv, e.what());
+  }
+  return EXIT_FAILURE;
+}
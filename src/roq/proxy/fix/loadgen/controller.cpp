@@ -0,0 +1,195 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/loadgen/controller.hpp"
+
+#include <magic_enum.hpp>
+
+#include <algorithm>
+#include <array>
+
+#include "roq/logging.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace loadgen {
+
+// === CONSTANTS ===
+
+namespace {
+auto const TIMER_FREQUENCY = 1ms;
+
+auto const PERCENTILES = std::array<double, 4>{50.0, 90.0, 99.0, 99.9};
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+auto create_connection_factory(auto &context, auto &uri) {
+  log::debug("uri={}"sv, uri);
+  auto config = io::net::ConnectionFactory::Config{
+      .interface = {},
+      .uris = {&uri, 1},
+      .validate_certificate = false,
+  };
+  return io::net::ConnectionFactory::create(context, config);
+}
+
+auto create_distribution(auto &flags) {
+  auto weights = std::array<double, 3>{
+      static_cast<double>(flags.new_order_single_weight),
+      static_cast<double>(flags.order_cancel_request_weight),
+      static_cast<double>(flags.market_data_request_weight),
+  };
+  if (std::all_of(std::begin(weights), std::end(weights), [](auto value) { return value == 0.0; }))
+    log::fatal("Unexpected: all weights are zero"sv);
+  return std::discrete_distribution<size_t>{std::begin(weights), std::end(weights)};
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Controller::Controller(flags::Flags const &flags, io::Context &context)
+    : flags_{flags}, context_{context}, terminate_{context.create_signal(*this, io::sys::Signal::Type::TERMINATE)},
+      interrupt_{context.create_signal(*this, io::sys::Signal::Type::INTERRUPT)},
+      timer_{context.create_timer(*this, TIMER_FREQUENCY)}, client_uri_{flags.client_uri},
+      connection_factory_{create_connection_factory(context, client_uri_)}, shared_{flags},
+      random_engine_{flags.seed}, distribution_{create_distribution(flags)} {
+  sessions_.reserve(flags.sessions);
+}
+
+void Controller::run() {
+  log::info("Event loop is now running"sv);
+  start_ = shared_.clock.update();
+  last_update_ = start_;
+  last_report_ = start_;
+  next_report_ = start_ + flags_.report_freq;
+  (*timer_).resume();
+  context_.dispatch();
+  for (auto &session : sessions_)
+    (*session).stop();
+  log::info("Event loop has terminated"sv);
+}
+
+// io::sys::Signal::Handler
+
+void Controller::operator()(io::sys::Signal::Event const &event) {
+  log::warn("*** SIGNAL: {} ***"sv, magic_enum::enum_name(event.type));
+  report(shared_.clock.update());
+  context_.stop();
+}
+
+// io::sys::Timer::Handler
+
+void Controller::operator()(io::sys::Timer::Event const &event) {
+  auto now = event.now;
+  shared_.clock.calibrate();
+  connect(now);
+  for (auto &session : sessions_)
+    (*session).refresh(now);
+  send(now);
+  if (next_report_ <= now) {
+    next_report_ = now + flags_.report_freq;
+    report(now);
+  }
+  if ((now - start_) >= flags_.duration) {
+    log::info("Done"sv);
+    report(now);
+    context_.stop();
+  }
+}
+
+// utilities
+
+void Controller::connect(std::chrono::nanoseconds now) {
+  auto elapsed = std::chrono::duration<double>(now - start_).count();
+  auto target = std::min<size_t>(flags_.sessions, static_cast<size_t>(elapsed * flags_.connect_rate) + 1);
+  while (std::size(sessions_) < target) {
+    auto index = static_cast<uint32_t>(std::size(sessions_));
+    auto &session = sessions_.emplace_back(std::make_unique<Session>(shared_, *connection_factory_, index));
+    (*session).start();
+  }
+}
+
+void Controller::send(std::chrono::nanoseconds now) {
+  budget_ += flags_.rate * std::chrono::duration<double>(now - last_update_).count();
+  last_update_ = now;
+  // note! round-robin, each ready session is visited at most once per pass
+  auto count = std::size(sessions_);
+  while (budget_ >= 1.0) {
+    auto sent = false;
+    for (size_t i = 0; i < count && budget_ >= 1.0; ++i) {
+      auto &session = *sessions_[next_session_];
+      next_session_ = (next_session_ + 1) % count;
+      if (!session.ready())
+        continue;
+      send(session);
+      budget_ -= 1.0;
+      sent = true;
+    }
+    if (!sent) {
+      budget_ = 0.0;  // note! no bursts when sessions become ready
+      break;
+    }
+  }
+}
+
+void Controller::send(Session &session) {
+  auto now = shared_.clock.update();  // note! exact time for each request
+  switch (distribution_(random_engine_)) {
+    case 0:
+      session.send_new_order_single(now);
+      break;
+    case 1:
+      if (!session.send_order_cancel_request(now))
+        session.send_new_order_single(now);
+      break;
+    case 2:
+      session.send_market_data_request(now);
+      break;
+  }
+}
+
+void Controller::report(std::chrono::nanoseconds now) {
+  auto ready = std::count_if(std::begin(sessions_), std::end(sessions_), [](auto &item) { return (*item).ready(); });
+  auto &statistics = shared_.statistics;
+  auto seconds = std::chrono::duration<double>(now - last_report_).count();
+  last_report_ = now;
+  auto rate = [&](auto value) { return seconds > 0.0 ? static_cast<double>(value) / seconds : 0.0; };
+  log::info(
+      "sessions={} (ready={}), sent={} ({:.0f} msg/s), received={} ({:.0f} msg/s), rejected={}"sv,
+      std::size(sessions_),
+      ready,
+      statistics.sent,
+      rate(statistics.sent),
+      statistics.received,
+      rate(statistics.received),
+      statistics.rejected);
+  for (size_t i = 0; i < std::size(statistics.latency); ++i) {
+    auto &histogram = statistics.latency[i];
+    if (histogram.empty())
+      continue;
+    log::info(
+        "{}: count={}, mean={}, p50={}, p90={}, p99={}, p99.9={}, max={}"sv,
+        magic_enum::enum_name(static_cast<Request>(i)),
+        histogram.size(),
+        histogram.mean(),
+        histogram.percentile(PERCENTILES[0]),
+        histogram.percentile(PERCENTILES[1]),
+        histogram.percentile(PERCENTILES[2]),
+        histogram.percentile(PERCENTILES[3]),
+        histogram.max());
+    histogram.clear();
+  }
+  statistics.sent = {};
+  statistics.received = {};
+  statistics.rejected = {};
+}
+
+}  // namespace loadgen
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
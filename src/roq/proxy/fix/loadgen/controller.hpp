@@ -0,0 +1,79 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "roq/io/context.hpp"
+
+#include "roq/io/sys/signal.hpp"
+#include "roq/io/sys/timer.hpp"
+
+#include "roq/io/net/connection_factory.hpp"
+
+#include "roq/io/web/uri.hpp"
+
+#include "roq/proxy/fix/loadgen/session.hpp"
+#include "roq/proxy/fix/loadgen/shared.hpp"
+
+#include "roq/proxy/fix/loadgen/flags/flags.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace loadgen {
+
+// note!
+// sessions are opened gradually (connect_rate) and requests are spread round-robin across ready sessions
+// the request rate is maintained by a token budget, replenished on every timer tick
+
+struct Controller final : public io::sys::Signal::Handler, public io::sys::Timer::Handler {
+  Controller(flags::Flags const &, io::Context &);
+
+  Controller(Controller &&) = delete;
+  Controller(Controller const &) = delete;
+
+  void run();
+
+ protected:
+  // io::sys::Signal::Handler
+  void operator()(io::sys::Signal::Event const &) override;
+
+  // io::sys::Timer::Handler
+  void operator()(io::sys::Timer::Event const &) override;
+
+  // utilities
+
+  void connect(std::chrono::nanoseconds now);
+  void send(std::chrono::nanoseconds now);
+  void send(Session &);
+
+  void report(std::chrono::nanoseconds now);
+
+ private:
+  flags::Flags const &flags_;
+  io::Context &context_;
+  std::unique_ptr<io::sys::Signal> const terminate_;
+  std::unique_ptr<io::sys::Signal> const interrupt_;
+  std::unique_ptr<io::sys::Timer> const timer_;
+  io::web::URI const client_uri_;
+  std::unique_ptr<io::net::ConnectionFactory> const connection_factory_;
+  Shared shared_;
+  std::vector<std::unique_ptr<Session>> sessions_;
+  std::mt19937 random_engine_;
+  std::discrete_distribution<size_t> distribution_;
+  std::chrono::nanoseconds start_ = {};
+  std::chrono::nanoseconds last_update_ = {};
+  std::chrono::nanoseconds next_report_ = {};
+  std::chrono::nanoseconds last_report_ = {};
+  double budget_ = {};
+  size_t next_session_ = {};
+};
+
+}  // namespace loadgen
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,320 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/loadgen/session.hpp"
+
+#include <fmt/format.h>
+
+#include <array>
+#include <cassert>
+
+#include "roq/logging.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace loadgen {
+
+// === CONSTANTS ===
+
+namespace {
+// note! body length, comp ids, msg seq num, sending time and checksum are re-computed (see Splice)
+
+auto const LOGON = "8=FIX.4.4\x01"
+                   "9=0\x01"
+                   "35=A\x01"
+                   "98=0\x01"
+                   "108=0\x01"
+                   "141=Y\x01"
+                   "95=0\x01"
+                   "96=0\x01"
+                   "553=0\x01"
+                   "554=0\x01"
+                   "10=000\x01"sv;
+
+auto const HEARTBEAT = "8=FIX.4.4\x01"
+                       "9=0\x01"
+                       "35=0\x01"
+                       "112=0\x01"
+                       "10=000\x01"sv;
+
+auto const NEW_ORDER_SINGLE = "8=FIX.4.4\x01"
+                              "9=0\x01"
+                              "35=D\x01"
+                              "11=0\x01"
+                              "1=0\x01"
+                              "55=0\x01"
+                              "207=0\x01"
+                              "54=1\x01"  // buy
+                              "40=2\x01"  // limit
+                              "38=0\x01"
+                              "44=0\x01"
+                              "59=1\x01"  // gtc
+                              "60=0\x01"
+                              "10=000\x01"sv;
+
+auto const ORDER_CANCEL_REQUEST = "8=FIX.4.4\x01"
+                                  "9=0\x01"
+                                  "35=F\x01"
+                                  "11=0\x01"
+                                  "41=0\x01"
+                                  "1=0\x01"
+                                  "55=0\x01"
+                                  "207=0\x01"
+                                  "54=1\x01"  // buy
+                                  "38=0\x01"
+                                  "60=0\x01"
+                                  "10=000\x01"sv;
+
+auto const MARKET_DATA_REQUEST = "8=FIX.4.4\x01"
+                                 "9=0\x01"
+                                 "35=V\x01"
+                                 "262=0\x01"
+                                 "263=0\x01"  // snapshot
+                                 "264=1\x01"  // top of book
+                                 "267=2\x01"
+                                 "269=0\x01"  // bid
+                                 "269=1\x01"  // offer
+                                 "146=1\x01"
+                                 "55=0\x01"
+                                 "207=0\x01"
+                                 "10=000\x01"sv;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+auto format(auto &value, auto index) {
+  return fmt::format(fmt::runtime(value), index);
+}
+
+auto create_connection_manager(auto &handler, auto &connection_factory) {
+  auto config = io::net::ConnectionManager::Config{
+      .connection_timeout = 5s,
+      .disconnect_on_idle_timeout = {},
+      .always_reconnect = true,
+  };
+  return io::net::ConnectionManager::create(handler, connection_factory, config);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Session::Session(Shared &shared, io::net::ConnectionFactory &connection_factory, uint32_t index)
+    : shared_{shared}, index_{index}, username_{format(shared.flags.username, index)},
+      password_{format(shared.flags.password, index)},
+      comp_ids_{tools::Splice::create_comp_ids(
+          format(shared.flags.sender_comp_id, index), shared.flags.target_comp_id)},
+      connection_manager_{create_connection_manager(*this, connection_factory)} {
+}
+
+void Session::start() {
+  (*connection_manager_).start();
+}
+
+void Session::stop() {
+  (*connection_manager_).stop();
+}
+
+void Session::refresh(std::chrono::nanoseconds now) {
+  (*connection_manager_).refresh(now);
+  if (state_ != State::READY || now < next_heartbeat_)
+    return;
+  send_heartbeat({}, now);
+}
+
+void Session::send_new_order_single(std::chrono::nanoseconds now) {
+  assert(ready());
+  auto cl_ord_id = create_req_id();
+  // note! same timestamp as the header, i.e. the cached result remains valid
+  auto transact_time = shared_.sending_time(shared_.clock.get_realtime());
+  auto replacements = std::array<tools::Splice::Replacement, 7>{{
+      {11, cl_ord_id},
+      {1, shared_.flags.account},
+      {55, shared_.flags.symbol},
+      {207, shared_.flags.exchange},
+      {38, shared_.flags.quantity},
+      {44, shared_.flags.price},
+      {60, transact_time},
+  }};
+  send(NEW_ORDER_SINGLE, replacements, now);
+  ++shared_.statistics.sent;
+  pending_.try_emplace(std::move(cl_ord_id), Pending{.request = Request::NEW_ORDER_SINGLE, .sent = now});
+}
+
+bool Session::send_order_cancel_request(std::chrono::nanoseconds now) {
+  assert(ready());
+  if (std::empty(working_orders_))
+    return false;
+  auto orig_cl_ord_id = std::move(working_orders_.back());
+  working_orders_.pop_back();
+  auto cl_ord_id = create_req_id();
+  auto transact_time = shared_.sending_time(shared_.clock.get_realtime());
+  auto replacements = std::array<tools::Splice::Replacement, 7>{{
+      {11, cl_ord_id},
+      {41, orig_cl_ord_id},
+      {1, shared_.flags.account},
+      {55, shared_.flags.symbol},
+      {207, shared_.flags.exchange},
+      {38, shared_.flags.quantity},
+      {60, transact_time},
+  }};
+  send(ORDER_CANCEL_REQUEST, replacements, now);
+  ++shared_.statistics.sent;
+  pending_.try_emplace(std::move(cl_ord_id), Pending{.request = Request::ORDER_CANCEL_REQUEST, .sent = now});
+  return true;
+}
+
+void Session::send_market_data_request(std::chrono::nanoseconds now) {
+  assert(ready());
+  auto md_req_id = create_req_id();
+  auto replacements = std::array<tools::Splice::Replacement, 3>{{
+      {262, md_req_id},
+      {55, shared_.flags.symbol},
+      {207, shared_.flags.exchange},
+  }};
+  send(MARKET_DATA_REQUEST, replacements, now);
+  ++shared_.statistics.sent;
+  pending_.try_emplace(std::move(md_req_id), Pending{.request = Request::MARKET_DATA_REQUEST, .sent = now});
+}
+
+// io::net::ConnectionManager::Handler
+
+void Session::operator()(io::net::ConnectionManager::Connected const &) {
+  log::debug("Connected (index={})"sv, index_);
+  auto now = shared_.clock.update();
+  send_logon(now);
+  state_ = State::LOGON_SENT;
+}
+
+void Session::operator()(io::net::ConnectionManager::Disconnected const &) {
+  log::warn("Disconnected (index={})"sv, index_);
+  state_ = State::DISCONNECTED;
+  msg_seq_num_ = {};
+  next_heartbeat_ = {};
+  pending_.clear();
+  working_orders_.clear();
+}
+
+void Session::operator()(io::net::ConnectionManager::Read const &) {
+  auto now = shared_.clock.update();  // note! receive time, shared by everything in this batch
+  auto buffer = (*connection_manager_).buffer();
+  size_t total_bytes = 0;
+  while (!std::empty(buffer)) {
+    auto bytes = tools::Splice::get_message_length(buffer);
+    if (bytes == 0)
+      break;
+    parse(buffer.subspan(0, bytes), now);
+    total_bytes += bytes;
+    buffer = buffer.subspan(bytes);
+  }
+  (*connection_manager_).drain(total_bytes);
+}
+
+void Session::parse(std::span<std::byte const> const &message, std::chrono::nanoseconds now) {
+  auto msg_type = tools::Splice::find(message, 35);
+  if (msg_type == "8"sv) {  // ExecutionReport
+    auto cl_ord_id = tools::Splice::find(message, 11);
+    auto ord_status = tools::Splice::find(message, 39);
+    auto iter = pending_.find(cl_ord_id);
+    // note! new orders can be canceled once acknowledged
+    if (iter != std::end(pending_) && (*iter).second.request == Request::NEW_ORDER_SINGLE && ord_status != "8"sv)
+      working_orders_.emplace_back(cl_ord_id);
+    response(cl_ord_id, now, ord_status == "8"sv);
+  } else if (msg_type == "9"sv) {  // OrderCancelReject
+    response(tools::Splice::find(message, 11), now, true);
+  } else if (msg_type == "W"sv) {  // MarketDataSnapshotFullRefresh
+    response(tools::Splice::find(message, 262), now, false);
+  } else if (msg_type == "Y"sv) {  // MarketDataRequestReject
+    response(tools::Splice::find(message, 262), now, true);
+  } else if (msg_type == "j"sv) {  // BusinessMessageReject
+    response(tools::Splice::find(message, 379), now, true);
+  } else if (msg_type == "1"sv) {  // TestRequest
+    send_heartbeat(tools::Splice::find(message, 112), now);
+  } else if (msg_type == "A"sv) {  // Logon
+    log::debug("Ready (index={})"sv, index_);
+    state_ = State::READY;
+  } else if (msg_type == "5"sv) {  // Logout
+    log::warn(R"(Logout (index={}, text="{}"))"sv, index_, tools::Splice::find(message, 58));
+  } else if (msg_type == "3"sv) {  // Reject
+    log::warn(R"(Reject (index={}, text="{}"))"sv, index_, tools::Splice::find(message, 58));
+    ++shared_.statistics.rejected;
+  }
+}
+
+// note! only the first response is used to measure latency
+void Session::response(std::string_view const &req_id, std::chrono::nanoseconds now, bool rejected) {
+  ++shared_.statistics.received;
+  if (rejected)
+    ++shared_.statistics.rejected;
+  auto iter = pending_.find(req_id);
+  if (iter == std::end(pending_))
+    return;
+  auto &pending = (*iter).second;
+  shared_.statistics.latency[static_cast<size_t>(pending.request)](now - pending.sent);
+  pending_.erase(iter);
+}
+
+void Session::send_logon(std::chrono::nanoseconds now) {
+  auto heartbeat_freq = std::chrono::duration_cast<std::chrono::seconds>(shared_.flags.heartbeat_freq);
+  auto heart_bt_int = fmt::format("{}"sv, heartbeat_freq.count());
+  std::string raw_data;
+  std::string password;
+  switch (shared_.crypto.method()) {
+    using enum tools::Crypto::Method;
+    case UNDEFINED:
+      password = password_;
+      break;
+    case HMAC_SHA256:
+      raw_data = fmt::format("{}-{}"sv, index_, shared_.clock.get_realtime().count());
+      password = shared_.crypto.sign(password_, raw_data);
+      break;
+    case HMAC_SHA256_TS: {
+      auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(shared_.clock.get_realtime());
+      raw_data = fmt::format("{}.{}"sv, timestamp.count(), index_);
+      password = shared_.crypto.sign(password_, raw_data);
+      break;
+    }
+  }
+  auto raw_data_length = std::empty(raw_data) ? std::string{} : fmt::format("{}"sv, std::size(raw_data));
+  auto replacements = std::array<tools::Splice::Replacement, 5>{{
+      {108, heart_bt_int},
+      {95, raw_data_length},  // note! dropped if empty
+      {96, raw_data},
+      {553, username_},
+      {554, password},
+  }};
+  send(LOGON, replacements, now);
+}
+
+void Session::send_heartbeat(std::string_view const &test_req_id, std::chrono::nanoseconds now) {
+  auto replacements = std::array<tools::Splice::Replacement, 1>{{
+      {112, test_req_id},  // note! dropped if empty
+  }};
+  send(HEARTBEAT, replacements, now);
+}
+
+void Session::send(
+    std::string_view const &message,
+    std::span<tools::Splice::Replacement const> const &replacements,
+    std::chrono::nanoseconds now) {
+  auto header = tools::Splice::Header{
+      .comp_ids = comp_ids_,
+      .msg_seq_num = ++msg_seq_num_,
+      .sending_time = shared_.sending_time(shared_.clock.get_realtime()),
+  };
+  auto raw = std::span{reinterpret_cast<std::byte const *>(std::data(message)), std::size(message)};
+  (*connection_manager_).send(tools::Splice::encode(shared_.encode_buffer, raw, header, replacements));
+  next_heartbeat_ = now + shared_.flags.heartbeat_freq;
+}
+
+std::string Session::create_req_id() {
+  return fmt::format("{}-{}"sv, index_, ++next_req_id_);
+}
+
+}  // namespace loadgen
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
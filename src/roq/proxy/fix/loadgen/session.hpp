@@ -0,0 +1,93 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "roq/utils/container.hpp"
+
+#include "roq/io/net/connection_factory.hpp"
+#include "roq/io/net/connection_manager.hpp"
+
+#include "roq/proxy/fix/tools/splice.hpp"
+
+#include "roq/proxy/fix/loadgen/shared.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace loadgen {
+
+// note!
+// messages are encoded from raw templates (see Splice)
+// responses are matched on the request id without decoding
+
+struct Session final : public io::net::ConnectionManager::Handler {
+  Session(Shared &, io::net::ConnectionFactory &, uint32_t index);
+
+  Session(Session &&) = delete;
+  Session(Session const &) = delete;
+
+  void start();
+  void stop();
+  void refresh(std::chrono::nanoseconds now);
+
+  bool ready() const { return state_ == State::READY; }
+
+  void send_new_order_single(std::chrono::nanoseconds now);
+  bool send_order_cancel_request(std::chrono::nanoseconds now);  // note! false if there is nothing to cancel
+  void send_market_data_request(std::chrono::nanoseconds now);
+
+  enum class State {
+    DISCONNECTED,
+    LOGON_SENT,
+    READY,
+  };
+
+ protected:
+  // io::net::ConnectionManager::Handler
+  void operator()(io::net::ConnectionManager::Connected const &) override;
+  void operator()(io::net::ConnectionManager::Disconnected const &) override;
+  void operator()(io::net::ConnectionManager::Read const &) override;
+
+  void parse(std::span<std::byte const> const &message, std::chrono::nanoseconds now);
+
+  void response(std::string_view const &req_id, std::chrono::nanoseconds now, bool rejected);
+
+  void send_logon(std::chrono::nanoseconds now);
+  void send_heartbeat(std::string_view const &test_req_id, std::chrono::nanoseconds now);
+
+  void send(
+      std::string_view const &message,
+      std::span<tools::Splice::Replacement const> const &replacements,
+      std::chrono::nanoseconds now);
+
+  std::string create_req_id();
+
+ private:
+  Shared &shared_;
+  uint32_t const index_;
+  std::string const username_;
+  std::string const password_;
+  std::string const comp_ids_;
+  std::unique_ptr<io::net::ConnectionManager> const connection_manager_;
+  State state_ = {};
+  uint64_t msg_seq_num_ = {};
+  uint64_t next_req_id_ = {};
+  std::chrono::nanoseconds next_heartbeat_ = {};
+  struct Pending final {
+    Request request = {};
+    std::chrono::nanoseconds sent = {};
+  };
+  utils::unordered_map<std::string, Pending> pending_;
+  std::vector<std::string> working_orders_;
+};
+
+}  // namespace loadgen
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
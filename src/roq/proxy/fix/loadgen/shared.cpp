@@ -0,0 +1,27 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/loadgen/shared.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace loadgen {
+
+// === CONSTANTS ===
+
+namespace {
+auto const ENCODE_BUFFER_SIZE = size_t{65536};
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Shared::Shared(flags::Flags const &flags)
+    : flags{flags}, encode_buffer(ENCODE_BUFFER_SIZE), crypto{flags.auth_method, {}} {
+}
+
+}  // namespace loadgen
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,54 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "roq/proxy/fix/tools/clock.hpp"
+#include "roq/proxy/fix/tools/crypto.hpp"
+#include "roq/proxy/fix/tools/histogram.hpp"
+#include "roq/proxy/fix/tools/sending_time.hpp"
+
+#include "roq/proxy/fix/loadgen/flags/flags.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace loadgen {
+
+enum class Request : uint8_t {
+  NEW_ORDER_SINGLE,
+  ORDER_CANCEL_REQUEST,
+  MARKET_DATA_REQUEST,
+};
+
+struct Shared final {
+  explicit Shared(flags::Flags const &);
+
+  flags::Flags const &flags;
+
+  // note! scratch buffer shared by all sessions (everything runs on the same thread)
+  std::vector<std::byte> encode_buffer;
+
+  // note! sampled for each request and once per io callback
+  tools::Clock clock;
+
+  tools::SendingTime sending_time;
+
+  tools::Crypto crypto;
+
+  // statistics (reset after each report)
+  struct Statistics final {
+    uint64_t sent = {};
+    uint64_t received = {};
+    uint64_t rejected = {};
+    std::array<tools::Histogram, 3> latency;  // note! indexed by Request
+  } statistics;
+};
+
+}  // namespace loadgen
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
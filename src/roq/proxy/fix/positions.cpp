@@ -0,0 +1,179 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/positions.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "roq/logging.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+
+// === CONSTANTS ===
+
+namespace {
+// note! the position type updated by fills
+auto const FILL_POS_TYPE = roq::fix::PosType::TRANSACTION_QUANTITY;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+auto create_key(auto &security_exchange, auto &symbol, auto pos_type) {
+  return fmt::format("{}:{}:{}"sv, security_exchange, symbol, static_cast<int>(pos_type));
+}
+
+auto is_fill(auto &execution_report) {
+  if (execution_report.exec_type != roq::fix::ExecType::TRADE)
+    return false;
+  return execution_report.last_qty.value > 0.0;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+void Positions::clear_accounts() {
+  if (!std::empty(accounts_))
+    log::info("Positions: cleared {} account(s)"sv, std::size(accounts_));
+  accounts_.clear();
+}
+
+void Positions::begin_snapshot(std::string_view const &account, uint32_t total_num_pos_reports) {
+  if (std::empty(account))
+    return;
+  auto &tmp = (*accounts_.try_emplace(account).first).second;
+  // note! a snapshot replaces everything, requests received while it is being refreshed are not served locally
+  tmp.positions.clear();
+  tmp.fills = false;
+  tmp.remaining = total_num_pos_reports;
+  tmp.complete = !tmp.remaining;
+  if (tmp.complete)
+    log::info(R"(Positions: account="{}" is now complete (no positions))"sv, account);
+}
+
+bool Positions::is_complete(std::string_view const &account) const {
+  auto iter = accounts_.find(account);
+  if (iter == std::end(accounts_))
+    return false;
+  return (*iter).second.complete;
+}
+
+size_t Positions::size(std::string_view const &account) const {
+  auto iter = accounts_.find(account);
+  if (iter == std::end(accounts_))
+    return 0;
+  return std::size((*iter).second.positions);
+}
+
+void Positions::subscribe(std::string_view const &account, std::string_view const &request_id) {
+  (*subscriptions_.try_emplace(account).first).second.emplace(request_id);
+  subscription_to_account_.try_emplace(request_id, account);
+}
+
+bool Positions::unsubscribe(std::string_view const &request_id) {
+  auto iter = subscription_to_account_.find(request_id);
+  if (iter == std::end(subscription_to_account_))
+    return false;
+  auto iter_2 = subscriptions_.find((*iter).second);
+  if (iter_2 != std::end(subscriptions_)) {
+    (*iter_2).second.erase(request_id);
+    if (std::empty((*iter_2).second))
+      subscriptions_.erase(iter_2);
+  }
+  subscription_to_account_.erase(iter);
+  return true;
+}
+
+bool Positions::is_subscription(std::string_view const &request_id) const {
+  return subscription_to_account_.find(request_id) != std::end(subscription_to_account_);
+}
+
+bool Positions::update(codec::fix::PositionReport const &position_report) {
+  if (position_report.pos_req_result != roq::fix::PosReqResult::VALID)
+    return false;
+  if (std::empty(position_report.account) || std::empty(position_report.symbol))
+    return false;
+  auto &account = (*accounts_.try_emplace(position_report.account).first).second;
+  if (account.remaining) {
+    --account.remaining;
+    if (!account.remaining && !account.complete) {
+      log::info(R"(Positions: account="{}" is now complete)"sv, position_report.account);
+      account.complete = true;
+    }
+  }
+  return true;
+}
+
+// note! one position per pos_type, quantities of different types are never combined
+Positions::Position const *Positions::update(
+    codec::fix::PositionReport const &position_report, codec::fix::Position const &item) {
+  auto iter = accounts_.find(position_report.account);
+  assert(iter != std::end(accounts_));
+  auto &account = (*iter).second;
+  if (item.pos_type == FILL_POS_TYPE)
+    account.fills = true;
+  auto key = create_key(position_report.security_exchange, position_report.symbol, item.pos_type);
+  auto &position = account.positions[key];
+  if (std::empty(position.symbol)) {
+    position.symbol = position_report.symbol;
+    position.security_exchange = position_report.security_exchange;
+    position.pos_type = item.pos_type;
+  }
+  position.long_qty = item.long_qty;
+  position.short_qty = item.short_qty;
+  return &position;
+}
+
+Positions::Position const *Positions::update(codec::fix::ExecutionReport const &execution_report, bool &invalidated) {
+  if (!is_fill(execution_report))
+    return nullptr;
+  auto iter = accounts_.find(execution_report.account);
+  if (iter == std::end(accounts_))
+    return nullptr;
+  auto &account = (*iter).second;
+  auto key = create_key(execution_report.security_exchange, execution_report.symbol, FILL_POS_TYPE);
+  auto iter_2 = account.positions.find(key);
+  if (iter_2 == std::end(account.positions)) {
+    if (!account.complete)
+      return nullptr;  // note! the snapshot will include this fill
+    if (!account.fills) {
+      // note! the position types reported by the fix-bridge can't be maintained from fills
+      log::info(R"(Positions: account="{}" has been invalidated (fill))"sv, execution_report.account);
+      accounts_.erase(iter);
+      invalidated = true;
+      return nullptr;
+    }
+    iter_2 = account.positions.try_emplace(key).first;
+    auto &position = (*iter_2).second;
+    position.symbol = execution_report.symbol;
+    position.security_exchange = execution_report.security_exchange;
+    position.pos_type = FILL_POS_TYPE;
+    position.long_qty.precision = execution_report.last_qty.precision;
+    position.short_qty.precision = execution_report.last_qty.precision;
+  }
+  auto &position = (*iter_2).second;
+  auto net = position.long_qty.value - position.short_qty.value;
+  switch (execution_report.side) {
+    using enum roq::fix::Side;
+    case BUY:
+      net += execution_report.last_qty.value;
+      break;
+    case SELL:
+      net -= execution_report.last_qty.value;
+      break;
+    default:
+      log::warn("Unexpected: side={}"sv, execution_report.side);
+      return nullptr;
+  }
+  position.long_qty.value = std::max(net, 0.0);
+  position.short_qty.value = std::max(-net, 0.0);
+  return &position;
+}
+
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
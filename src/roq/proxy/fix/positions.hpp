@@ -0,0 +1,151 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "roq/utils/container.hpp"
+
+#include "roq/codec/fix/execution_report.hpp"
+#include "roq/codec/fix/position_report.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+
+// note!
+// positions are maintained per account from PositionReport (snapshot) and ExecutionReport (fills)
+// an account can only be served locally once a complete snapshot has been received from the fix-bridge
+// positions are kept per pos_type, fills are only applied to transaction quantity (other types are snapshot only)
+// fills can only be applied if the fix-bridge reports transaction quantity for the account, otherwise the account is
+// invalidated (and its subscriptions dropped) so requests will again be forwarded to the fix-bridge
+
+struct Positions final {
+  using Quantity = decltype(codec::fix::Position::long_qty);
+
+  struct Position final {
+    std::string symbol;
+    std::string security_exchange;
+    roq::fix::PosType pos_type = {};
+    Quantity long_qty = {};
+    Quantity short_qty = {};
+  };
+
+  // note! must be called when the fix-bridge disconnects
+  // callback(account, request_id) is invoked for each subscription (they are all dropped)
+  template <typename Callback>
+  void clear(Callback callback) {
+    drop_subscriptions(callback);
+    clear_accounts();
+  }
+
+  // snapshot
+
+  // note! the account is not complete (and therefore not served locally) until all reports have been received
+  void begin_snapshot(std::string_view const &account, uint32_t total_num_pos_reports);
+
+  bool is_complete(std::string_view const &account) const;
+
+  // updates
+
+  template <typename Callback>
+  void operator()(codec::fix::PositionReport const &position_report, Callback callback) {
+    if (!update(position_report))
+      return;
+    for (auto &item : position_report.no_positions) {
+      auto position = update(position_report, item);
+      if (position)
+        callback(position_report.account, *position);
+    }
+  }
+
+  // note! invalidate(account, request_id) is invoked for each subscription dropped when an account is invalidated
+  template <typename Callback, typename Invalidate>
+  void operator()(codec::fix::ExecutionReport const &execution_report, Callback callback, Invalidate invalidate) {
+    auto invalidated = false;
+    auto position = update(execution_report, invalidated);
+    if (position)
+      callback(execution_report.account, *position);
+    if (invalidated)
+      drop_subscriptions(execution_report.account, invalidate);
+  }
+
+  // query
+
+  template <typename Callback>
+  void get(std::string_view const &account, Callback callback) const {
+    auto iter = accounts_.find(account);
+    if (iter == std::end(accounts_))
+      return;
+    for (auto &[_, position] : (*iter).second.positions)
+      callback(position);
+  }
+
+  size_t size(std::string_view const &account) const;
+
+  // subscriptions
+
+  void subscribe(std::string_view const &account, std::string_view const &request_id);
+  bool unsubscribe(std::string_view const &request_id);
+
+  bool is_subscription(std::string_view const &request_id) const;
+
+  template <typename Callback>
+  void get_subscriptions(std::string_view const &account, Callback callback) const {
+    auto iter = subscriptions_.find(account);
+    if (iter == std::end(subscriptions_))
+      return;
+    for (auto &request_id : (*iter).second)
+      callback(request_id);
+  }
+
+ protected:
+  bool update(codec::fix::PositionReport const &);
+  Position const *update(codec::fix::PositionReport const &, codec::fix::Position const &);
+  Position const *update(codec::fix::ExecutionReport const &, bool &invalidated);
+
+  void clear_accounts();
+
+  // note! callback may (safely) unsubscribe
+  template <typename Callback>
+  void drop_subscriptions(std::string_view const &account, Callback callback) {
+    auto iter = subscriptions_.find(account);
+    if (iter == std::end(subscriptions_))
+      return;
+    auto account_2 = (*iter).first;  // note! copy
+    auto request_ids = std::move((*iter).second);
+    subscriptions_.erase(iter);
+    for (auto &request_id : request_ids) {
+      subscription_to_account_.erase(request_id);
+      callback(account_2, request_id);
+    }
+  }
+
+  template <typename Callback>
+  void drop_subscriptions(Callback callback) {
+    while (!std::empty(subscriptions_)) {
+      auto account = (*std::begin(subscriptions_)).first;  // note! copy
+      drop_subscriptions(account, callback);
+    }
+  }
+
+ private:
+  struct Account final {
+    bool complete = {};
+    uint32_t remaining = {};
+    bool fills = {};  // note! true if the fix-bridge reports transaction quantity for the account
+    // "security_exchange:symbol:pos_type" => position
+    utils::unordered_map<std::string, Position> positions;
+  };
+  // account => positions
+  utils::unordered_map<std::string, Account> accounts_;
+  // account => request_id
+  utils::unordered_map<std::string, utils::unordered_set<std::string>> subscriptions_;
+  // request_id => account
+  utils::unordered_map<std::string, std::string> subscription_to_account_;
+};
+
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,42 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/replay/application.hpp"
+
+#include "roq/exceptions.hpp"
+
+#include "roq/logging.hpp"
+
+#include "roq/io/engine/context_factory.hpp"
+
+#include "roq/proxy/fix/replay/controller.hpp"
+
+#include "roq/proxy/fix/replay/flags/flags.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace replay {
+
+// === IMPLEMENTATION ===
+
+int Application::main(args::Parser const &) {
+  auto flags = flags::Flags::create();
+  auto context = io::engine::ContextFactory::create_libevent();
+  try {
+    return Controller{flags, *context}.run() ? EXIT_SUCCESS : EXIT_FAILURE;
+  } catch (SystemError &e) {
+    log::error("Unhandled exception: {}"sv, e);
+  } catch (Exception &e) {
+    log::error("Unhandled exception: {}"sv, e);
+  } catch (std::exception &e) {
+    log::error(R"(Unhandled exception: type="{}", what="{}")"sv, typeid(e).name(), e.what());
+  }
+  return EXIT_FAILURE;
+}
+
+}  // namespace replay
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
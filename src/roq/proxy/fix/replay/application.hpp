@@ -0,0 +1,22 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include "roq/service.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace replay {
+
+struct Application final : public Service {
+  using Service::Service;  // inherit constructors
+
+ protected:
+  int main(args::Parser const &) override;
+};
+
+}  // namespace replay
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,95 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/replay/client.hpp"
+
+#include "roq/logging.hpp"
+
+#include "roq/proxy/fix/tools/splice.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace replay {
+
+// === CONSTANTS ===
+
+namespace {
+auto const CONNECTION_TIMEOUT = 5s;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+auto create_connection_manager(auto &handler, auto &connection_factory) {
+  auto config = io::net::ConnectionManager::Config{
+      .connection_timeout = CONNECTION_TIMEOUT,
+      .disconnect_on_idle_timeout = {},
+      .always_reconnect = false,  // note! a replayed session can not be resumed
+  };
+  return io::net::ConnectionManager::create(handler, connection_factory, config);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Client::Client(Handler &handler, uint64_t session_id, io::net::ConnectionFactory &connection_factory)
+    : handler_{handler}, session_id_{session_id},
+      connection_manager_{create_connection_manager(*this, connection_factory)} {
+}
+
+void Client::start() {
+  (*connection_manager_).start();
+}
+
+void Client::stop() {
+  (*connection_manager_).stop();
+}
+
+void Client::refresh(std::chrono::nanoseconds now) {
+  (*connection_manager_).refresh(now);
+}
+
+void Client::send(std::span<std::byte const> const &message, std::chrono::nanoseconds now) {
+  (*connection_manager_).send(encoder_(message, now));
+}
+
+void Client::send_heartbeat(std::string_view const &test_req_id, std::chrono::nanoseconds now) {
+  (*connection_manager_).send(encoder_.create_heartbeat(test_req_id, now));
+}
+
+// io::net::ConnectionManager::Handler
+
+void Client::operator()(io::net::ConnectionManager::Connected const &) {
+  log::debug("Connected (session_id={})"sv, session_id_);
+  ready_ = true;
+  encoder_.reset();
+  handler_(Connected{}, session_id_);
+}
+
+void Client::operator()(io::net::ConnectionManager::Disconnected const &) {
+  log::debug("Disconnected (session_id={})"sv, session_id_);
+  ready_ = false;
+  handler_(Disconnected{}, session_id_);
+}
+
+void Client::operator()(io::net::ConnectionManager::Read const &) {
+  auto buffer = (*connection_manager_).buffer();
+  size_t total_bytes = 0;
+  while (!std::empty(buffer)) {
+    auto bytes = tools::Splice::get_message_length(buffer);
+    if (bytes == 0)
+      break;
+    handler_(Received{.message = buffer.subspan(0, bytes)}, session_id_);
+    total_bytes += bytes;
+    buffer = buffer.subspan(bytes);
+  }
+  (*connection_manager_).drain(total_bytes);
+}
+
+}  // namespace replay
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,65 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <span>
+
+#include "roq/io/net/connection_factory.hpp"
+#include "roq/io/net/connection_manager.hpp"
+
+#include "roq/proxy/fix/replay/encoder.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace replay {
+
+// note! replays a recorded client session (connects to the proxy)
+
+struct Client final : public io::net::ConnectionManager::Handler {
+  struct Connected final {};
+  struct Disconnected final {};
+  struct Received final {
+    std::span<std::byte const> message;
+  };
+
+  struct Handler {
+    virtual void operator()(Connected const &, uint64_t session_id) = 0;
+    virtual void operator()(Disconnected const &, uint64_t session_id) = 0;
+    virtual void operator()(Received const &, uint64_t session_id) = 0;
+  };
+
+  Client(Handler &, uint64_t session_id, io::net::ConnectionFactory &);
+
+  Client(Client &&) = delete;
+  Client(Client const &) = delete;
+
+  void start();
+  void stop();
+  void refresh(std::chrono::nanoseconds now);
+
+  bool ready() const { return ready_; }
+
+  void send(std::span<std::byte const> const &message, std::chrono::nanoseconds now);
+  void send_heartbeat(std::string_view const &test_req_id, std::chrono::nanoseconds now);
+
+ protected:
+  // io::net::ConnectionManager::Handler
+  void operator()(io::net::ConnectionManager::Connected const &) override;
+  void operator()(io::net::ConnectionManager::Disconnected const &) override;
+  void operator()(io::net::ConnectionManager::Read const &) override;
+
+ private:
+  Handler &handler_;
+  uint64_t const session_id_;
+  std::unique_ptr<io::net::ConnectionManager> const connection_manager_;
+  bool ready_ = {};
+  Encoder encoder_;
+};
+
+}  // namespace replay
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,387 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/replay/controller.hpp"
+
+#include <magic_enum.hpp>
+
+#include <array>
+#include <cassert>
+#include <limits>
+
+#include "roq/clock.hpp"
+
+#include "roq/logging.hpp"
+
+#include "roq/proxy/fix/tools/splice.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace replay {
+
+// === CONSTANTS ===
+
+namespace {
+auto const TIMER_FREQUENCY = 1ms;
+
+auto const UNDEFINED_TRIGGER = std::numeric_limits<size_t>::max();
+
+// note! fields the proxy generates for upstream (and upstream echoes back)
+auto const ID_TAGS = std::array<uint32_t, 11>{
+    11,   // ClOrdID
+    41,   // OrigClOrdID
+    262,  // MDReqID
+    320,  // SecurityReqID
+    324,  // SecurityStatusReqID
+    335,  // TradSesReqID
+    568,  // TradeRequestID
+    584,  // MassStatusReqID
+    710,  // PosReqID
+    790,  // OrdStatusReqID
+    923,  // UserRequestID
+};
+
+auto const PERCENTILES = std::array<double, 4>{50.0, 90.0, 99.0, 99.9};
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+auto get_msg_type(auto &message) {
+  return tools::Splice::find(message, 35);
+}
+
+// note! session level messages are handled by each side of the replay
+bool is_admin(auto &msg_type) {
+  if (std::size(msg_type) != 1)
+    return false;
+  switch (msg_type[0]) {
+    case '0':  // Heartbeat
+    case '1':  // TestRequest
+    case '2':  // ResendRequest
+    case '3':  // Reject
+    case '4':  // SequenceReset
+    case '5':  // Logout
+    case 'A':  // Logon
+      return true;
+    default:
+      return false;
+  }
+}
+
+auto create_connection_factory(auto &context, auto &uri) {
+  log::debug("uri={}"sv, uri);
+  auto config = io::net::ConnectionFactory::Config{
+      .interface = {},
+      .uris = {&uri, 1},
+      .validate_certificate = false,
+  };
+  return io::net::ConnectionFactory::create(context, config);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Controller::Controller(flags::Flags const &flags, io::Context &context)
+    : flags_{flags}, context_{context}, terminate_{context.create_signal(*this, io::sys::Signal::Type::TERMINATE)},
+      interrupt_{context.create_signal(*this, io::sys::Signal::Type::INTERRUPT)},
+      timer_{context.create_timer(*this, TIMER_FREQUENCY)}, client_uri_{flags.client_uri},
+      connection_factory_{create_connection_factory(context, client_uri_)},
+      upstream_{*this, context, flags.listen_address} {
+}
+
+bool Controller::run() {
+  load(flags_.capture_file);
+  if (std::empty(records_)) {
+    log::warn("Nothing to replay"sv);
+    return false;
+  }
+  log::info("Replay is now running"sv);
+  start_ = clock::get_system();
+  (*timer_).resume();
+  context_.dispatch();
+  for (auto &[_, client] : clients_)
+    (*client).stop();
+  log::info("Replay has terminated"sv);
+  return success_;
+}
+
+// io::sys::Signal::Handler
+
+void Controller::operator()(io::sys::Signal::Event const &event) {
+  log::warn("*** SIGNAL: {} ***"sv, magic_enum::enum_name(event.type));
+  finish(false);
+}
+
+// io::sys::Timer::Handler
+
+void Controller::operator()(io::sys::Timer::Event const &event) {
+  for (auto &[_, client] : clients_)
+    (*client).refresh(event.now);
+  pump(event.now);
+  if (done_ || next_ < std::size(records_))
+    return;
+  // note! everything has been sent, waiting for the proxy
+  auto outstanding = std::size(server_expected_);
+  for (auto &[_, expected] : client_expected_)
+    outstanding += std::size(expected);
+  if (outstanding == 0) {
+    finish(true);
+  } else if ((event.now - last_sent_) > flags_.timeout) {
+    log::warn("Timeout: {} message(s) were never received from the proxy"sv, outstanding);
+    finish(false);
+  }
+}
+
+// Client::Handler
+
+void Controller::operator()(Client::Connected const &, uint64_t session_id) {
+  log::info("Client connected (session_id={})"sv, session_id);
+  pump(clock::get_system());
+}
+
+void Controller::operator()(Client::Disconnected const &, uint64_t session_id) {
+  log::warn("Client disconnected (session_id={})"sv, session_id);
+  clients_logged_on_.erase(session_id);
+}
+
+void Controller::operator()(Client::Received const &received, uint64_t session_id) {
+  auto now = clock::get_system();
+  auto msg_type = get_msg_type(received.message);
+  if (msg_type == "1"sv) {
+    get_client(session_id).send_heartbeat(tools::Splice::find(received.message, 112), now);
+  } else if (msg_type == "A"sv) {
+    clients_logged_on_.emplace(session_id);
+  } else if (!is_admin(msg_type)) {
+    receive(client_expected_[session_id], now, false);
+  }
+  pump(now);
+}
+
+// Upstream::Handler
+
+void Controller::operator()(Upstream::Connected const &) {
+}
+
+void Controller::operator()(Upstream::Disconnected const &) {
+  log::warn("Upstream disconnected"sv);
+  upstream_logon_ = false;
+}
+
+void Controller::operator()(Upstream::Received const &received) {
+  auto now = clock::get_system();
+  auto msg_type = get_msg_type(received.message);
+  if (msg_type == "1"sv) {
+    upstream_.send_heartbeat(tools::Splice::find(received.message, 112), now);
+  } else if (msg_type == "A"sv) {
+    upstream_logon_ = true;
+  } else if (!is_admin(msg_type)) {
+    // note! ids generated by the proxy are only expected to differ from the recording
+    if (server_outbound_count_ < std::size(server_outbound_)) {
+      auto &recorded = server_outbound_[server_outbound_count_];
+      for (auto tag : ID_TAGS) {
+        auto lhs = tools::Splice::find(recorded, tag);
+        auto rhs = tools::Splice::find(received.message, tag);
+        if (!std::empty(lhs) && lhs != rhs)
+          id_mapping_.insert_or_assign(std::string{lhs}, std::string{rhs});
+      }
+    }
+    ++server_outbound_count_;
+    receive(server_expected_, now, true);
+  }
+  pump(now);
+}
+
+// utilities
+
+void Controller::load(std::string_view const &path) {
+  log::info(R"(Loading "{}"...)"sv, path);
+  tools::Capture::Reader reader{path};
+  tools::Capture::Header header;
+  std::span<std::byte const> message;
+  auto last_inbound = UNDEFINED_TRIGGER;
+  while (reader(header, message)) {
+    auto msg_type = get_msg_type(message);
+    switch (header.direction) {
+      using enum tools::Capture::Direction;
+      case UNDEFINED:
+        break;
+      case CLIENT_INBOUND:
+      case SERVER_INBOUND:
+        if (is_admin(msg_type) && msg_type != "A"sv)
+          break;
+        last_inbound = std::size(records_);
+        records_.push_back({
+            .direction = header.direction,
+            .session_id = header.session_id,
+            .timestamp = std::chrono::nanoseconds{header.timestamp},
+            .message = {std::begin(message), std::end(message)},
+            .server_outbound_count = std::size(server_outbound_),
+        });
+        break;
+      case CLIENT_OUTBOUND:
+        if (!is_admin(msg_type))
+          client_expected_[header.session_id].emplace_back(last_inbound);
+        break;
+      case SERVER_OUTBOUND:
+        if (!is_admin(msg_type)) {
+          server_outbound_.emplace_back(std::begin(message), std::end(message));
+          server_expected_.emplace_back(last_inbound);
+        }
+        break;
+    }
+  }
+  sent_.resize(std::size(records_));
+  log::info("Loaded {} inbound message(s) and {} expected outbound message(s)"sv, std::size(records_), [&]() {
+    auto result = std::size(server_expected_);
+    for (auto &[_, expected] : client_expected_)
+      result += std::size(expected);
+    return result;
+  }());
+}
+
+void Controller::pump(std::chrono::nanoseconds now) {
+  while (!done_ && next_ < std::size(records_)) {
+    if (!release(next_, now)) {
+      if (blocked_since_.count() == 0) {
+        blocked_since_ = now;
+      } else if ((now - blocked_since_) > flags_.timeout) {
+        auto &record = records_[next_];
+        log::warn(
+            "Timeout: blocked on message #{} (direction={}, session_id={}, msg_type={})"sv,
+            next_,
+            magic_enum::enum_name(record.direction),
+            record.session_id,
+            get_msg_type(record.message));
+        finish(false);
+      }
+      return;
+    }
+    blocked_since_ = {};
+    ++next_;
+  }
+}
+
+// note! returns false if the message can not (yet) be released
+bool Controller::release(size_t index, std::chrono::nanoseconds now) {
+  auto &record = records_[index];
+  if (flags_.pace > 0.0) {
+    auto offset = std::chrono::duration<double>(record.timestamp - records_[0].timestamp) / flags_.pace;
+    if (now < (start_ + std::chrono::duration_cast<std::chrono::nanoseconds>(offset)))
+      return false;
+  }
+  auto is_logon = get_msg_type(record.message) == "A"sv;
+  switch (record.direction) {
+    using enum tools::Capture::Direction;
+    case CLIENT_INBOUND: {
+      // note! logon when the proxy has made the same upstream progress as when recorded
+      if (is_logon && server_outbound_count_ < record.server_outbound_count)
+        return false;
+      auto &client = get_client(record.session_id);
+      if (!client.ready())
+        return false;
+      if (!is_logon && !clients_logged_on_.contains(record.session_id))
+        return false;
+      client.send(record.message, now);
+      break;
+    }
+    case SERVER_INBOUND: {
+      if (!upstream_.ready() || !upstream_logon_)
+        return false;
+      if (server_outbound_count_ < record.server_outbound_count)
+        return false;
+      replacements_.clear();
+      for (auto tag : ID_TAGS) {
+        auto value = tools::Splice::find(record.message, tag);
+        if (std::empty(value))
+          continue;
+        auto iter = id_mapping_.find(value);
+        if (iter != std::end(id_mapping_))
+          replacements_.emplace_back(tag, (*iter).second);
+      }
+      upstream_.send(record.message, now, replacements_);
+      break;
+    }
+    default:
+      assert(false);
+  }
+  sent_[index] = now;
+  last_sent_ = now;
+  if (first_sent_.count() == 0)
+    first_sent_ = now;
+  return true;
+}
+
+void Controller::receive(std::deque<size_t> &expected, std::chrono::nanoseconds now, bool upstream) {
+  if (std::empty(expected)) {
+    ++unexpected_;
+    return;
+  }
+  auto trigger = expected.front();
+  expected.pop_front();
+  if (trigger == UNDEFINED_TRIGGER || sent_[trigger].count() == 0)
+    return;
+  auto from_upstream = records_[trigger].direction == tools::Capture::Direction::SERVER_INBOUND;
+  latency_[from_upstream][upstream](now - sent_[trigger]);
+}
+
+Client &Controller::get_client(uint64_t session_id) {
+  auto iter = clients_.find(session_id);
+  if (iter == std::end(clients_)) {
+    auto client = std::make_unique<Client>(*this, session_id, *connection_factory_);
+    (*client).start();
+    iter = clients_.try_emplace(session_id, std::move(client)).first;
+  }
+  return *(*iter).second;
+}
+
+void Controller::finish(bool success) {
+  if (done_)
+    return;
+  done_ = true;
+  success_ = success;
+  report();
+  context_.stop();
+}
+
+void Controller::report() {
+  auto elapsed = last_sent_ - first_sent_;
+  auto seconds = std::chrono::duration<double>(elapsed).count();
+  auto throughput = seconds > 0.0 ? static_cast<double>(next_) / seconds : 0.0;
+  log::info(
+      "Replayed {} of {} message(s) in {} ({:.0f} msg/s), unexpected={}"sv,
+      next_,
+      std::size(records_),
+      elapsed,
+      throughput,
+      unexpected_);
+  auto names = std::array<std::array<std::string_view, 2>, 2>{{
+      {"client->client"sv, "client->upstream"sv},
+      {"upstream->client"sv, "upstream->upstream"sv},
+  }};
+  for (size_t i = 0; i < 2; ++i) {
+    for (size_t j = 0; j < 2; ++j) {
+      auto &histogram = latency_[i][j];
+      if (histogram.empty())
+        continue;
+      log::info(
+          "{}: count={}, mean={}, p50={}, p90={}, p99={}, p99.9={}, max={}"sv,
+          names[i][j],
+          histogram.size(),
+          histogram.mean(),
+          histogram.percentile(PERCENTILES[0]),
+          histogram.percentile(PERCENTILES[1]),
+          histogram.percentile(PERCENTILES[2]),
+          histogram.percentile(PERCENTILES[3]),
+          histogram.max());
+    }
+  }
+}
+
+}  // namespace replay
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,135 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "roq/utils/container.hpp"
+
+#include "roq/io/context.hpp"
+
+#include "roq/io/sys/signal.hpp"
+#include "roq/io/sys/timer.hpp"
+
+#include "roq/io/net/connection_factory.hpp"
+
+#include "roq/io/web/uri.hpp"
+
+#include "roq/proxy/fix/tools/capture.hpp"
+#include "roq/proxy/fix/tools/histogram.hpp"
+
+#include "roq/proxy/fix/replay/client.hpp"
+#include "roq/proxy/fix/replay/upstream.hpp"
+
+#include "roq/proxy/fix/replay/flags/flags.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace replay {
+
+// note!
+// replays a capture file against a live proxy
+// - the recorded upstream is replaced by a listener (the proxy must be configured to connect here)
+// - each recorded client session is replayed using its own connection
+// - inbound messages (client to proxy, upstream to proxy) are released in recorded order, either as fast as
+//   possible or at the recorded pace
+// - upstream messages are only released once the proxy has forwarded everything preceding them in the recording
+//   (ids generated by the proxy are mapped from the recording to what the proxy actually used)
+// - outbound messages (proxy to client, proxy to upstream) are matched by position to measure latency
+
+struct Controller final : public io::sys::Signal::Handler,
+                          public io::sys::Timer::Handler,
+                          public Client::Handler,
+                          public Upstream::Handler {
+  Controller(flags::Flags const &, io::Context &);
+
+  Controller(Controller &&) = delete;
+  Controller(Controller const &) = delete;
+
+  // note! returns false if the replay did not complete
+  bool run();
+
+ protected:
+  // io::sys::Signal::Handler
+  void operator()(io::sys::Signal::Event const &) override;
+
+  // io::sys::Timer::Handler
+  void operator()(io::sys::Timer::Event const &) override;
+
+  // Client::Handler
+  void operator()(Client::Connected const &, uint64_t session_id) override;
+  void operator()(Client::Disconnected const &, uint64_t session_id) override;
+  void operator()(Client::Received const &, uint64_t session_id) override;
+
+  // Upstream::Handler
+  void operator()(Upstream::Connected const &) override;
+  void operator()(Upstream::Disconnected const &) override;
+  void operator()(Upstream::Received const &) override;
+
+  // utilities
+
+  void load(std::string_view const &path);
+
+  void pump(std::chrono::nanoseconds now);
+  bool release(size_t index, std::chrono::nanoseconds now);
+
+  void receive(std::deque<size_t> &expected, std::chrono::nanoseconds now, bool upstream);
+
+  Client &get_client(uint64_t session_id);
+
+  void finish(bool success);
+  void report();
+
+ private:
+  flags::Flags const &flags_;
+  io::Context &context_;
+  std::unique_ptr<io::sys::Signal> const terminate_;
+  std::unique_ptr<io::sys::Signal> const interrupt_;
+  std::unique_ptr<io::sys::Timer> const timer_;
+  io::web::URI const client_uri_;
+  std::unique_ptr<io::net::ConnectionFactory> const connection_factory_;
+  Upstream upstream_;
+  utils::unordered_map<uint64_t, std::unique_ptr<Client>> clients_;
+  // recording
+  struct Record final {
+    tools::Capture::Direction direction = {};
+    uint64_t session_id = {};
+    std::chrono::nanoseconds timestamp = {};
+    std::vector<std::byte> message;
+    size_t server_outbound_count = {};  // note! recorded proxy to upstream messages preceding this one
+  };
+  std::vector<Record> records_;  // note! inbound only
+  std::vector<std::vector<std::byte>> server_outbound_;  // note! used to map ids
+  // expected outbound messages (index of the inbound message that triggered it)
+  utils::unordered_map<uint64_t, std::deque<size_t>> client_expected_;
+  std::deque<size_t> server_expected_;
+  // state
+  size_t next_ = {};
+  std::chrono::nanoseconds start_ = {};
+  std::chrono::nanoseconds blocked_since_ = {};
+  std::chrono::nanoseconds last_sent_ = {};
+  size_t server_outbound_count_ = {};
+  bool upstream_logon_ = {};  // note! the proxy has sent its logon
+  utils::unordered_set<uint64_t> clients_logged_on_;
+  utils::unordered_map<std::string, std::string> id_mapping_;
+  std::vector<tools::Splice::Replacement> replacements_;
+  std::vector<std::chrono::nanoseconds> sent_;  // note! per record
+  bool done_ = {};
+  bool success_ = {};
+  // statistics
+  size_t unexpected_ = {};
+  std::chrono::nanoseconds first_sent_ = {};
+  // note! [trigger is upstream][receiver is upstream]
+  std::array<std::array<tools::Histogram, 2>, 2> latency_;
+};
+
+}  // namespace replay
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
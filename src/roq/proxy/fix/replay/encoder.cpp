@@ -0,0 +1,69 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/replay/encoder.hpp"
+
+#include <cassert>
+
+using namespace std::literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace replay {
+
+// === CONSTANTS ===
+
+namespace {
+auto const ENCODE_BUFFER_SIZE = size_t{1048576};
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+auto to_span(std::string_view const &value) {
+  return std::span{reinterpret_cast<std::byte const *>(std::data(value)), std::size(value)};
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Encoder::Encoder() : buffer_(ENCODE_BUFFER_SIZE) {
+}
+
+void Encoder::reset() {
+  msg_seq_num_ = {};
+}
+
+std::span<std::byte const> Encoder::operator()(
+    std::span<std::byte const> const &message,
+    std::chrono::nanoseconds now,
+    std::span<tools::Splice::Replacement const> const &replacements) {
+  if (std::empty(comp_ids_)) [[unlikely]]
+    comp_ids_ = tools::Splice::create_comp_ids(tools::Splice::find(message, 49), tools::Splice::find(message, 56));
+  auto header = tools::Splice::Header{
+      .comp_ids = comp_ids_,
+      .msg_seq_num = ++msg_seq_num_,
+      .sending_time = sending_time_(now),
+  };
+  auto strip_party_ids = false;
+  return tools::Splice::encode(buffer_, message, header, replacements, strip_party_ids);
+}
+
+std::span<std::byte const> Encoder::create_heartbeat(std::string_view const &test_req_id, std::chrono::nanoseconds now) {
+  assert(!std::empty(comp_ids_));
+  // note! body length and checksum are recomputed by splice
+  heartbeat_.clear();
+  heartbeat_.append("8=FIX.4.4\x01"
+                    "9=0\x01"
+                    "35=0\x01"
+                    "112="sv);
+  heartbeat_.append(test_req_id);
+  heartbeat_.append("\x01"
+                    "10=000\x01"sv);
+  return (*this)(to_span(heartbeat_), now);
+}
+
+}  // namespace replay
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
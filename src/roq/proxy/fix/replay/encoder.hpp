@@ -0,0 +1,54 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/proxy/fix/tools/sending_time.hpp"
+#include "roq/proxy/fix/tools/splice.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace replay {
+
+// note!
+// re-frames recorded messages for a live connection
+// - comp ids are taken from the first message (the recorded logon)
+// - msg_seq_num is re-sequenced from 1
+// - sending_time is the replay time
+// party ids are kept, the proxy relies on them for routing
+
+struct Encoder final {
+  Encoder();
+
+  Encoder(Encoder &&) = delete;
+  Encoder(Encoder const &) = delete;
+
+  void reset();
+
+  std::span<std::byte const> operator()(
+      std::span<std::byte const> const &message,
+      std::chrono::nanoseconds now,
+      std::span<tools::Splice::Replacement const> const &replacements = {});
+
+  // note! response to a test request
+  std::span<std::byte const> create_heartbeat(std::string_view const &test_req_id, std::chrono::nanoseconds now);
+
+ private:
+  std::string comp_ids_;
+  uint64_t msg_seq_num_ = {};
+  tools::SendingTime sending_time_;
+  std::vector<std::byte> buffer_;
+  std::string heartbeat_;
+};
+
+}  // namespace replay
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
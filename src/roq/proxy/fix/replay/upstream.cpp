@@ -0,0 +1,94 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/replay/upstream.hpp"
+
+#include <cassert>
+
+#include "roq/logging.hpp"
+
+#include "roq/proxy/fix/tools/splice.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace replay {
+
+// === HELPERS ===
+
+namespace {
+auto create_listener(auto &handler, auto &context, auto &listen_address) {
+  auto network_address = io::NetworkAddress{listen_address};
+  log::debug("network_address={}"sv, network_address);
+  return context.create_tcp_listener(handler, network_address);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Upstream::Upstream(Handler &handler, io::Context &context, std::string_view const &listen_address)
+    : handler_{handler}, listener_{create_listener(*this, context, listen_address)} {
+}
+
+void Upstream::send(
+    std::span<std::byte const> const &message,
+    std::chrono::nanoseconds now,
+    std::span<tools::Splice::Replacement const> const &replacements) {
+  assert(ready());
+  (*connection_).send(encoder_(message, now, replacements));
+}
+
+void Upstream::send_heartbeat(std::string_view const &test_req_id, std::chrono::nanoseconds now) {
+  assert(ready());
+  (*connection_).send(encoder_.create_heartbeat(test_req_id, now));
+}
+
+// io::net::tcp::Listener::Handler
+
+void Upstream::operator()(io::net::tcp::Connection::Factory &factory) {
+  if (connection_ && !zombie_) {
+    log::warn("Unexpected: already connected"sv);
+    return;
+  }
+  log::info("Connected"sv);
+  connection_ = factory.create(*this);
+  zombie_ = false;
+  buffer_.drain(std::size(buffer_.data()));
+  encoder_.reset();
+  handler_(Connected{});
+}
+
+void Upstream::operator()(io::net::tcp::Connection::Factory &factory, io::NetworkAddress const &) {
+  (*this)(factory);
+}
+
+// io::net::tcp::Connection::Handler
+
+void Upstream::operator()(io::net::tcp::Connection::Read const &) {
+  if (zombie_)
+    return;
+  buffer_.append(*connection_);
+  auto buffer = buffer_.data();
+  size_t total_bytes = 0;
+  while (!std::empty(buffer)) {
+    auto bytes = tools::Splice::get_message_length(buffer);
+    if (bytes == 0)
+      break;
+    handler_(Received{.message = buffer.subspan(0, bytes)});
+    total_bytes += bytes;
+    buffer = buffer.subspan(bytes);
+  }
+  buffer_.drain(total_bytes);
+}
+
+void Upstream::operator()(io::net::tcp::Connection::Disconnected const &) {
+  log::info("Disconnected"sv);
+  zombie_ = true;
+  handler_(Disconnected{});
+}
+
+}  // namespace replay
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
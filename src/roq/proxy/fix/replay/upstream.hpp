@@ -0,0 +1,71 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <span>
+
+#include "roq/io/buffer.hpp"
+#include "roq/io/context.hpp"
+
+#include "roq/io/net/tcp/connection.hpp"
+#include "roq/io/net/tcp/listener.hpp"
+
+#include "roq/proxy/fix/replay/encoder.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace replay {
+
+// note! replaces the upstream fix-bridge (the proxy connects here)
+
+struct Upstream final : public io::net::tcp::Listener::Handler, public io::net::tcp::Connection::Handler {
+  struct Connected final {};
+  struct Disconnected final {};
+  struct Received final {
+    std::span<std::byte const> message;
+  };
+
+  struct Handler {
+    virtual void operator()(Connected const &) = 0;
+    virtual void operator()(Disconnected const &) = 0;
+    virtual void operator()(Received const &) = 0;
+  };
+
+  Upstream(Handler &, io::Context &, std::string_view const &listen_address);
+
+  Upstream(Upstream &&) = delete;
+  Upstream(Upstream const &) = delete;
+
+  bool ready() const { return static_cast<bool>(connection_) && !zombie_; }
+
+  void send(
+      std::span<std::byte const> const &message,
+      std::chrono::nanoseconds now,
+      std::span<tools::Splice::Replacement const> const &replacements);
+  void send_heartbeat(std::string_view const &test_req_id, std::chrono::nanoseconds now);
+
+ protected:
+  // io::net::tcp::Listener::Handler
+  void operator()(io::net::tcp::Connection::Factory &) override;
+  void operator()(io::net::tcp::Connection::Factory &, io::NetworkAddress const &) override;
+
+  // io::net::tcp::Connection::Handler
+  void operator()(io::net::tcp::Connection::Read const &) override;
+  void operator()(io::net::tcp::Connection::Disconnected const &) override;
+
+ private:
+  Handler &handler_;
+  std::unique_ptr<io::net::tcp::Listener> const listener_;
+  std::unique_ptr<io::net::tcp::Connection> connection_;
+  bool zombie_ = {};  // note! we can't release the connection while on its call stack
+  io::Buffer buffer_;
+  Encoder encoder_;
+};
+
+}  // namespace replay
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,236 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/risk.hpp"
+
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+#include "roq/logging.hpp"
+
+#include "roq/proxy/fix/tools/splice.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+
+// === CONSTANTS ===
+
+namespace {
+auto const ERROR_MAX_ORDER_QTY = "RISK_MAX_ORDER_QTY"sv;
+auto const ERROR_MAX_NOTIONAL = "RISK_MAX_NOTIONAL"sv;
+auto const ERROR_MAX_OPEN_ORDERS = "RISK_MAX_OPEN_ORDERS"sv;
+auto const ERROR_PRICE_BAND = "RISK_PRICE_BAND"sv;
+auto const ERROR_NO_REFERENCE_PRICE = "RISK_NO_REFERENCE_PRICE"sv;
+
+auto const TAG_SYMBOL = uint32_t{55};
+auto const TAG_SECURITY_EXCHANGE = uint32_t{207};
+auto const TAG_MD_ENTRY_TYPE = uint32_t{269};
+auto const TAG_MD_ENTRY_PX = uint32_t{270};
+
+auto const MD_ENTRY_TYPE_TRADE = "2"sv;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+template <typename R>
+auto create_account_to_id(auto &config) {
+  using result_type = std::remove_cvref<R>::type;
+  result_type result;
+  for (auto &[name, _] : config.accounts)
+    result.try_emplace(name, static_cast<uint32_t>(std::size(result)));
+  return result;
+}
+
+template <typename R>
+auto create_limits(auto &config, auto &account_to_id) {
+  using result_type = std::remove_cvref<R>::type;
+  result_type result(std::size(account_to_id));
+  for (auto &[name, account] : config.accounts) {
+    auto iter = account_to_id.find(name);
+    assert(iter != std::end(account_to_id));
+    auto &limits = result[(*iter).second];
+    limits.max_order_qty = account.max_order_qty;
+    limits.max_notional = account.max_notional;
+    limits.max_open_orders = account.max_open_orders;
+    limits.price_band = account.price_band;
+    log::info(R"(Risk: account="{}" ==> {})"sv, name, account);
+  }
+  return result;
+}
+
+bool create_requires_market_data(auto &limits) {
+  for (auto &item : limits)
+    if (item.price_band > 0.0 || item.max_notional > 0.0)
+      return true;
+  return false;
+}
+
+// note! also covers market orders
+auto is_defined(double value) {
+  return std::isfinite(value) && value != 0.0;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Risk::Risk(Config const &config)
+    : account_to_id_{create_account_to_id<decltype(account_to_id_)>(config)},
+      limits_{create_limits<decltype(limits_)>(config, account_to_id_)}, exposure_(std::size(limits_)),
+      requires_market_data_{create_requires_market_data(limits_)} {
+}
+
+uint32_t Risk::find(std::string_view const &account) const {
+  auto iter = account_to_id_.find(account);
+  if (iter == std::end(account_to_id_))
+    return UNDEFINED;
+  return (*iter).second;
+}
+
+std::string_view Risk::check(uint32_t account_id, codec::fix::NewOrderSingle const &new_order_single) const {
+  if (account_id == UNDEFINED)
+    return {};
+  auto &limits = limits_[account_id];
+  auto &exposure = exposure_[account_id];
+  if (limits.max_open_orders && exposure.open_orders >= limits.max_open_orders)
+    return ERROR_MAX_OPEN_ORDERS;
+  return check_helper(
+      account_id,
+      new_order_single.security_exchange,
+      new_order_single.symbol,
+      new_order_single.order_qty.value,
+      new_order_single.price.value);
+}
+
+std::string_view Risk::check(
+    uint32_t account_id, codec::fix::OrderCancelReplaceRequest const &order_cancel_replace_request) const {
+  if (account_id == UNDEFINED)
+    return {};
+  return check_helper(
+      account_id,
+      order_cancel_replace_request.security_exchange,
+      order_cancel_replace_request.symbol,
+      order_cancel_replace_request.order_qty.value,
+      order_cancel_replace_request.price.value);
+}
+
+void Risk::add(uint32_t account_id, std::string_view const &cl_ord_id) {
+  if (account_id == UNDEFINED)
+    return;
+  if (orders_.try_emplace(cl_ord_id, account_id).second)
+    ++exposure_[account_id].open_orders;
+}
+
+void Risk::replace(std::string_view const &orig_cl_ord_id, std::string_view const &cl_ord_id) {
+  auto iter = orders_.find(orig_cl_ord_id);
+  if (iter == std::end(orders_))
+    return;
+  auto account_id = (*iter).second;
+  orders_.erase(iter);
+  orders_.try_emplace(cl_ord_id, account_id);
+}
+
+void Risk::remove(std::string_view const &cl_ord_id) {
+  auto iter = orders_.find(cl_ord_id);
+  if (iter == std::end(orders_))
+    return;
+  auto &exposure = exposure_[(*iter).second];
+  assert(exposure.open_orders > 0);
+  --exposure.open_orders;
+  orders_.erase(iter);
+}
+
+void Risk::clear() {
+  if (!std::empty(orders_))
+    log::info("Risk: releasing {} open order(s)"sv, std::size(orders_));
+  orders_.clear();
+  for (auto &item : exposure_)
+    item = {};
+}
+
+uint32_t Risk::get_open_orders(uint32_t account_id) const {
+  if (account_id == UNDEFINED)
+    return 0;
+  return exposure_[account_id].open_orders;
+}
+
+// note! scans the raw message, no need to decode market data just to find the last trade
+void Risk::operator()(std::span<std::byte const> const &message) {
+  std::string_view symbol, security_exchange, md_entry_type;
+  tools::Splice::for_each(message, [&](auto tag, auto &value) {
+    switch (tag) {
+      case TAG_SYMBOL:
+        symbol = value;
+        break;
+      case TAG_SECURITY_EXCHANGE:
+        security_exchange = value;
+        break;
+      case TAG_MD_ENTRY_TYPE:
+        md_entry_type = value;
+        break;
+      case TAG_MD_ENTRY_PX: {
+        if (md_entry_type != MD_ENTRY_TYPE_TRADE || std::empty(symbol))
+          break;
+        auto price = 0.0;
+        auto [ptr, ec] = std::from_chars(std::data(value), std::data(value) + std::size(value), price);
+        if (ec != std::errc{} || !(price > 0.0))
+          break;
+        auto &tmp = (*last_price_.try_emplace(security_exchange).first).second;
+        auto iter = tmp.find(symbol);
+        if (iter == std::end(tmp)) {
+          tmp.try_emplace(symbol, price);
+        } else {
+          (*iter).second = price;
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  });
+}
+
+std::string_view Risk::check_helper(
+    uint32_t account_id,
+    std::string_view const &security_exchange,
+    std::string_view const &symbol,
+    double quantity,
+    double price) const {
+  auto &limits = limits_[account_id];
+  if (limits.max_order_qty > 0.0 && is_defined(quantity) && quantity > limits.max_order_qty)
+    return ERROR_MAX_ORDER_QTY;
+  if (limits.max_notional == 0.0 && limits.price_band == 0.0)
+    return {};
+  auto last_price = get_last_price(security_exchange, symbol);
+  if (limits.price_band > 0.0 && is_defined(price) && last_price > 0.0) {
+    // note! no reference price means no band
+    if (std::fabs(price - last_price) > (limits.price_band * last_price))
+      return ERROR_PRICE_BAND;
+  }
+  if (limits.max_notional > 0.0 && is_defined(quantity)) {
+    auto reference_price = is_defined(price) ? price : last_price;
+    if (!(reference_price > 0.0))
+      return ERROR_NO_REFERENCE_PRICE;  // note! market order without market data
+    if ((quantity * reference_price) > limits.max_notional)
+      return ERROR_MAX_NOTIONAL;
+  }
+  return {};
+}
+
+double Risk::get_last_price(std::string_view const &security_exchange, std::string_view const &symbol) const {
+  auto iter_1 = last_price_.find(security_exchange);
+  if (iter_1 == std::end(last_price_))
+    return std::numeric_limits<double>::quiet_NaN();
+  auto iter_2 = (*iter_1).second.find(symbol);
+  if (iter_2 == std::end((*iter_1).second))
+    return std::numeric_limits<double>::quiet_NaN();
+  return (*iter_2).second;
+}
+
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
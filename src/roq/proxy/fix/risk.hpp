@@ -0,0 +1,93 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/utils/container.hpp"
+
+#include "roq/codec/fix/new_order_single.hpp"
+#include "roq/codec/fix/order_cancel_replace_request.hpp"
+
+#include "roq/proxy/fix/config.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+
+// note!
+// pre-trade risk checks, applied before an order request is forwarded to the fix-bridge
+// accounts are mapped to a dense index when the config is loaded, limits and exposure are flat arrays
+// accounts without configured limits are not checked
+// price bands are relative to the last traded price as seen from market data passing through the proxy
+
+struct Risk final {
+  static constexpr uint32_t const UNDEFINED = std::numeric_limits<uint32_t>::max();
+
+  explicit Risk(Config const &);
+
+  Risk(Risk &&) = delete;
+  Risk(Risk const &) = delete;
+
+  bool requires_market_data() const { return requires_market_data_; }
+
+  // returns the account index (UNDEFINED if the account has no limits)
+  uint32_t find(std::string_view const &account) const;
+
+  // returns an error (empty if accepted)
+  std::string_view check(uint32_t account_id, codec::fix::NewOrderSingle const &) const;
+  std::string_view check(uint32_t account_id, codec::fix::OrderCancelReplaceRequest const &) const;
+
+  // order tracking (cl_ord_id is the server side id)
+  void add(uint32_t account_id, std::string_view const &cl_ord_id);
+  void replace(std::string_view const &orig_cl_ord_id, std::string_view const &cl_ord_id);
+  void remove(std::string_view const &cl_ord_id);
+
+  // note! must be called when the fix-bridge disconnects (order state is no longer known)
+  void clear();
+
+  uint32_t get_open_orders(uint32_t account_id) const;
+
+  // market data (raw message, MarketDataSnapshotFullRefresh or MarketDataIncrementalRefresh)
+  void operator()(std::span<std::byte const> const &message);
+
+ protected:
+  std::string_view check_helper(
+      uint32_t account_id,
+      std::string_view const &security_exchange,
+      std::string_view const &symbol,
+      double quantity,
+      double price) const;
+
+  double get_last_price(std::string_view const &security_exchange, std::string_view const &symbol) const;
+
+ private:
+  struct Limits final {
+    double max_order_qty = {};
+    double max_notional = {};
+    uint32_t max_open_orders = {};
+    double price_band = {};
+  };
+  struct Exposure final {
+    uint32_t open_orders = {};
+  };
+  // account => account_id
+  utils::unordered_map<std::string, uint32_t> const account_to_id_;
+  // account_id => ...
+  std::vector<Limits> const limits_;
+  std::vector<Exposure> exposure_;
+  bool const requires_market_data_;
+  // cl_ord_id(server) => account_id
+  utils::unordered_map<std::string, uint32_t> orders_;
+  // security_exchange => symbol => last traded price
+  utils::unordered_map<std::string, utils::unordered_map<std::string, double>> last_price_;
+};
+
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -17,6 +17,8 @@
 
 #include "roq/fix/reader.hpp"
 
+#include "roq/proxy/fix/tools/splice.hpp"
+
 using namespace std::literals;
 
 namespace roq {
@@ -44,6 +46,12 @@ auto create_connection_factory(auto &settings, auto &context, auto &uri) {
   return io::net::ConnectionFactory::create(context, config);
 }
 
+auto create_sender_comp_id(auto &settings, auto type) -> std::string_view {
+  if (type == Session::Type::MARKET_DATA && !std::empty(settings.server.market_data_sender_comp_id))
+    return settings.server.market_data_sender_comp_id;
+  return settings.server.sender_comp_id;
+}
+
 auto create_connection_manager(auto &handler, auto &settings, auto &connection_factory) {
   auto config = io::net::ConnectionManager::Config{
       .connection_timeout = settings.net.connection_timeout,
@@ -56,14 +64,18 @@ auto create_connection_manager(auto &handler, auto &settings, auto &connection_f
 
 // === IMPLEMENTATION ===
 
-Session::Session(Handler &handler, Settings const &settings, io::Context &context, io::web::URI const &uri)
-    : handler_{handler}, username_{settings.server.username}, password_{settings.server.password},
-      sender_comp_id_{settings.server.sender_comp_id}, target_comp_id_{settings.server.target_comp_id},
-      ping_freq_{settings.server.ping_freq}, debug_{settings.server.debug},
-      connection_factory_{create_connection_factory(settings, context, uri)},
-      connection_manager_{create_connection_manager(*this, settings, *connection_factory_)},
-      decode_buffer_(settings.server.decode_buffer_size), decode_buffer_2_(settings.server.decode_buffer_size),
-      encode_buffer_(settings.server.encode_buffer_size) {
+Session::Session(Handler &handler, Shared &shared, io::Context &context, io::web::URI const &uri, Type type)
+    : handler_{handler}, shared_{shared}, type_{type}, username_{shared.settings.server.username},
+      password_{shared.settings.server.password}, sender_comp_id_{create_sender_comp_id(shared.settings, type)},
+      target_comp_id_{shared.settings.server.target_comp_id},
+      comp_ids_{tools::Splice::create_comp_ids(sender_comp_id_, target_comp_id_)},
+      ping_freq_{shared.settings.server.ping_freq},
+      debug_{shared.settings.server.debug},
+      connection_factory_{create_connection_factory(shared.settings, context, uri)},
+      connection_manager_{create_connection_manager(*this, shared.settings, *connection_factory_)},
+      decode_buffer_(shared.settings.server.decode_buffer_size),
+      decode_buffer_2_(shared.settings.server.decode_buffer_size),
+      encode_buffer_(shared.settings.server.encode_buffer_size) {
 }
 
 void Session::operator()(Event<Start> const &) {
@@ -161,9 +173,12 @@ void Session::operator()(io::net::ConnectionManager::Connected const &) {
 void Session::operator()(io::net::ConnectionManager::Disconnected const &) {
   log::debug("Disconnected"sv);
   TraceInfo trace_info;
-  Disconnected disconnected;
+  auto disconnected = Disconnected{
+      .type = type_,
+  };
   Trace event{trace_info, disconnected};
   handler_(event);
+  outbox_.clear();
   outbound_ = {};
   inbound_ = {};
   next_heartbeat_ = {};
@@ -175,11 +190,14 @@ void Session::operator()(io::net::ConnectionManager::Read const &) {
     if (debug_) [[unlikely]]
       log::info("{}"sv, utils::debug::fix::Message{message});
   };
+  shared_.clock.update();  // note! sampled once for everything dispatched from here
+  shared_.batch_begin();
   auto buffer = (*connection_manager_).buffer();
   size_t total_bytes = 0;
   while (!std::empty(buffer)) {
     TraceInfo trace_info;
     auto parser = [&](auto &message) {
+      message_ = buffer.subspan(0, tools::Splice::get_message_length(buffer));
       try {
         check(message.header);
         Trace event{trace_info, message};
@@ -196,11 +214,17 @@ void Session::operator()(io::net::ConnectionManager::Read const &) {
     auto bytes = roq::fix::Reader<FIX_VERSION>::dispatch(buffer, parser, logger);
     if (bytes == 0)
       break;
+    shared_.capture(tools::Capture::Direction::SERVER_INBOUND, {}, buffer.subspan(0, bytes));
     assert(bytes <= std::size(buffer));
     total_bytes += bytes;
     buffer = buffer.subspan(bytes);
   }
   (*connection_manager_).drain(total_bytes);
+  // note! messages held for any client session are sent when the batch ends
+  TraceInfo trace_info;
+  auto flush = Flush{};
+  Trace event{trace_info, flush};
+  handler_(event);
 }
 
 // inbound
@@ -299,13 +323,16 @@ void Session::parse(Trace<roq::fix::Message> const &event) {
       break;
     }
     case MARKET_DATA_SNAPSHOT_FULL_REFRESH: {
-      auto market_data_snapshot_full_refresh =
-          codec::fix::MarketDataSnapshotFullRefresh::create(message, decode_buffer_);
+      // note! decoded on demand, routing only needs md_req_id
+      tools::Lazy<codec::fix::MarketDataSnapshotFullRefresh> market_data_snapshot_full_refresh{
+          message, message_, decode_buffer_};
       dispatch(event, market_data_snapshot_full_refresh);
       break;
     }
     case MARKET_DATA_INCREMENTAL_REFRESH: {
-      auto market_data_incremental_refresh = codec::fix::MarketDataIncrementalRefresh::create(message, decode_buffer_);
+      // note! decoded on demand, routing only needs md_req_id
+      tools::Lazy<codec::fix::MarketDataIncrementalRefresh> market_data_incremental_refresh{
+          message, message_, decode_buffer_};
       dispatch(event, market_data_incremental_refresh);
       break;
     }
@@ -374,7 +401,9 @@ void Session::operator()(Trace<codec::fix::Logon> const &event, roq::fix::Header
   auto &[trace_info, logon] = event;
   log::debug("logon={}, trace_info={}"sv, logon, trace_info);
   assert(state_ == State::LOGON_SENT);
-  Ready ready;
+  auto ready = Ready{
+      .type = type_,
+  };
   Trace event_2{trace_info, ready};
   handler_(event_2);
   (*this)(State::READY);
@@ -429,13 +458,15 @@ void Session::operator()(Trace<codec::fix::MarketDataRequestReject> const &event
   handler_(event);
 }
 
-void Session::operator()(Trace<codec::fix::MarketDataSnapshotFullRefresh> const &event, roq::fix::Header const &) {
+void Session::operator()(
+    Trace<tools::Lazy<codec::fix::MarketDataSnapshotFullRefresh>> const &event, roq::fix::Header const &) {
   auto &[trace_info, market_data_snapshot_full_refresh] = event;
   log::debug<1>("market_data_snapshot_full_refresh={}, trace_info={}"sv, market_data_snapshot_full_refresh, trace_info);
   handler_(event);
 }
 
-void Session::operator()(Trace<codec::fix::MarketDataIncrementalRefresh> const &event, roq::fix::Header const &) {
+void Session::operator()(
+    Trace<tools::Lazy<codec::fix::MarketDataIncrementalRefresh>> const &event, roq::fix::Header const &) {
   auto &[trace_info, market_data_incremental_refresh] = event;
   log::debug<1>("market_data_incremental_refresh={}, trace_info={}"sv, market_data_incremental_refresh, trace_info);
   handler_(event);
@@ -462,7 +493,7 @@ void Session::operator()(Trace<codec::fix::OrderMassCancelReport> const &event,
 void Session::operator()(Trace<codec::fix::ExecutionReport> const &event, roq::fix::Header const &) {
   auto &[trace_info, execution_report] = event;
   log::debug("execution_report={}, trace_info={}"sv, execution_report, trace_info);
-  handler_(event);
+  handler_(event, message_);
 }
 
 void Session::operator()(Trace<codec::fix::RequestForPositionsAck> const &event, roq::fix::Header const &) {
@@ -507,21 +538,59 @@ void Session::send(T const &value) {
 template <typename T>
 void Session::send_helper(T const &value) {
   log::info<2>("send (=> server): {}={}"sv, nameof::nameof_short_type<T>(), value);
-  auto sending_time = clock::get_realtime();
+  auto priority = outbox_.get_priority(value);
+  auto held = shared_.settings.server.priority_outbox && shared_.batch() && tools::Outbox::hold(priority);
+  // note! the session header is written by reframe (pre-serialized comp ids and cached sending time)
   auto header = roq::fix::Header{
       .version = FIX_VERSION,
       .msg_type = T::MSG_TYPE,
-      .sender_comp_id = sender_comp_id_,
-      .target_comp_id = target_comp_id_,
-      .msg_seq_num = ++outbound_.msg_seq_num,  // note!
-      .sending_time = sending_time,
+      .sender_comp_id = {},
+      .target_comp_id = {},
+      .msg_seq_num = {},
+      .sending_time = {},
+  };
+  auto buffer = std::span{encode_buffer_};
+  auto encoded = value.encode(header, buffer.subspan(tools::Splice::HEADROOM));
+  if (held) {
+    outbox_.push(priority, encoded, value);  // note! framed when flushed
+    return;
+  }
+  auto header_2 = tools::Splice::Header{
+      .comp_ids = comp_ids_,
+      .msg_seq_num = ++outbound_.msg_seq_num,
+      .sending_time = shared_.sending_time(shared_.clock.get_realtime()),
   };
-  auto message = value.encode(header, encode_buffer_);
+  auto message = tools::Splice::reframe(buffer, encoded, header_2);
+  shared_.capture(tools::Capture::Direction::SERVER_OUTBOUND, {}, message);
   if (debug_) [[unlikely]]
     log::info("{}"sv, utils::debug::fix::Message{message});
   (*connection_manager_).send(message);
 }
 
+void Session::flush() {
+  if (outbox_.empty())
+    return;
+  if (!ready()) {
+    log::warn("Dropping held messages (not ready)"sv);
+    outbox_.clear();
+    return;
+  }
+  auto sending_time = shared_.sending_time(shared_.clock.get_realtime());
+  // note! only the session header is rewritten (in-place)
+  outbox_.flush([&](auto &buffer, auto &message) {
+    auto header = tools::Splice::Header{
+        .comp_ids = comp_ids_,
+        .msg_seq_num = ++outbound_.msg_seq_num,
+        .sending_time = sending_time,
+    };
+    auto message_2 = tools::Splice::reframe(buffer, message, header);
+    shared_.capture(tools::Capture::Direction::SERVER_OUTBOUND, {}, message_2);
+    if (debug_) [[unlikely]]
+      log::info("{}"sv, utils::debug::fix::Message{message_2});
+    (*connection_manager_).send(message_2);
+  });
+}
+
 void Session::send_logon() {
   auto heart_bt_int = static_cast<decltype(codec::fix::Logon::heart_bt_int)>(
       std::chrono::duration_cast<std::chrono::seconds>(ping_freq_).count());
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -54,6 +55,10 @@
 #include "roq/codec/fix/user_response.hpp"
 
 #include "roq/proxy/fix/settings.hpp"
+#include "roq/proxy/fix/shared.hpp"
+
+#include "roq/proxy/fix/tools/lazy.hpp"
+#include "roq/proxy/fix/tools/outbox.hpp"
 
 namespace roq {
 namespace proxy {
@@ -61,11 +66,22 @@ namespace fix {
 namespace server {
 
 struct Session final : public io::net::ConnectionManager::Handler {
-  struct Ready final {};
-  struct Disconnected final {};
+  // note! market data can optionally be routed through a separate upstream session
+  enum class Type {
+    ORDER_ENTRY,
+    MARKET_DATA,
+  };
+  struct Ready final {
+    Type type = {};
+  };
+  struct Disconnected final {
+    Type type = {};
+  };
+  struct Flush final {};  // note! an inbound batch has been processed (held messages can now be sent)
   struct Handler {
     virtual void operator()(Trace<Ready> const &) = 0;
     virtual void operator()(Trace<Disconnected> const &) = 0;
+    virtual void operator()(Trace<Flush> const &) = 0;
     //
     virtual void operator()(Trace<codec::fix::BusinessMessageReject> const &) = 0;
     // user
@@ -76,12 +92,13 @@ struct Session final : public io::net::ConnectionManager::Handler {
     virtual void operator()(Trace<codec::fix::SecurityStatus> const &) = 0;
     // market data
     virtual void operator()(Trace<codec::fix::MarketDataRequestReject> const &) = 0;
-    virtual void operator()(Trace<codec::fix::MarketDataSnapshotFullRefresh> const &) = 0;
-    virtual void operator()(Trace<codec::fix::MarketDataIncrementalRefresh> const &) = 0;
+    virtual void operator()(Trace<tools::Lazy<codec::fix::MarketDataSnapshotFullRefresh>> const &) = 0;
+    virtual void operator()(Trace<tools::Lazy<codec::fix::MarketDataIncrementalRefresh>> const &) = 0;
     // orders
     virtual void operator()(Trace<codec::fix::OrderCancelReject> const &) = 0;
     virtual void operator()(Trace<codec::fix::OrderMassCancelReport> const &) = 0;
-    virtual void operator()(Trace<codec::fix::ExecutionReport> const &) = 0;
+    // note! message is the raw fix message (can be used to avoid re-encoding)
+    virtual void operator()(Trace<codec::fix::ExecutionReport> const &, std::span<std::byte const> const &message) = 0;
     // positions
     virtual void operator()(Trace<codec::fix::RequestForPositionsAck> const &) = 0;
     virtual void operator()(Trace<codec::fix::PositionReport> const &) = 0;
@@ -90,7 +107,7 @@ struct Session final : public io::net::ConnectionManager::Handler {
     virtual void operator()(Trace<codec::fix::TradeCaptureReport> const &) = 0;
   };
 
-  Session(Handler &, Settings const &, io::Context &, io::web::URI const &);
+  Session(Handler &, Shared &, io::Context &, io::web::URI const &, Type = Type::ORDER_ENTRY);
 
   void operator()(Event<Start> const &);
   void operator()(Event<Stop> const &);
@@ -98,6 +115,9 @@ struct Session final : public io::net::ConnectionManager::Handler {
 
   bool ready() const;
 
+  // note! sends held messages (see tools::Outbox)
+  void flush();
+
   // user
   void operator()(Trace<codec::fix::UserRequest> const &);
   // ssecurity
@@ -163,8 +183,8 @@ struct Session final : public io::net::ConnectionManager::Handler {
   // - market data
 
   void operator()(Trace<codec::fix::MarketDataRequestReject> const &, roq::fix::Header const &);
-  void operator()(Trace<codec::fix::MarketDataSnapshotFullRefresh> const &, roq::fix::Header const &);
-  void operator()(Trace<codec::fix::MarketDataIncrementalRefresh> const &, roq::fix::Header const &);
+  void operator()(Trace<tools::Lazy<codec::fix::MarketDataSnapshotFullRefresh>> const &, roq::fix::Header const &);
+  void operator()(Trace<tools::Lazy<codec::fix::MarketDataIncrementalRefresh>> const &, roq::fix::Header const &);
 
   // - user
 
@@ -201,11 +221,14 @@ struct Session final : public io::net::ConnectionManager::Handler {
 
  private:
   Handler &handler_;
+  Shared &shared_;
+  Type const type_;
   // config
   std::string_view const username_;
   std::string_view const password_;
   std::string_view const sender_comp_id_;
   std::string_view const target_comp_id_;
+  std::string const comp_ids_;  // note! pre-serialized session header, see tools::Splice
   std::chrono::nanoseconds const ping_freq_;
   bool const debug_;
   // connection
@@ -221,6 +244,8 @@ struct Session final : public io::net::ConnectionManager::Handler {
   std::vector<std::byte> decode_buffer_;
   std::vector<std::byte> decode_buffer_2_;
   std::vector<std::byte> encode_buffer_;
+  std::span<std::byte const> message_;  // note! raw bytes of the message currently being parsed
+  tools::Outbox outbox_;
   // state
   enum class State {
     DISCONNECTED,
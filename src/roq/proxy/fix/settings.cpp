@@ -30,6 +30,10 @@ Settings Settings::create(args::Parser const &) {
       .auth = flags::Auth::create(),
       .server = flags::Server::create(),
       .client = flags::Client::create(),
+      .capture{
+          .file = flags.capture_file,
+          .buffer_size = flags.capture_buffer_size,
+      },
       .test{
           .enable_order_mass_cancel = flags.enable_order_mass_cancel,
           .disable_remove_cl_ord_id = flags.disable_remove_cl_ord_id,
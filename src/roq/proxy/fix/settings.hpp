@@ -33,6 +33,11 @@ struct Settings final {
   flags::Server server;
   flags::Client client;
 
+  struct {
+    std::string_view file;
+    size_t buffer_size = {};
+  } capture;
+
   struct {
     bool enable_order_mass_cancel = {};
     bool disable_remove_cl_ord_id = {};
@@ -60,6 +65,10 @@ struct fmt::formatter<roq::proxy::fix::Settings> {
         R"(auth={}, )"
         R"(server={}, )"
         R"(client={}, )"
+        R"(capture={{)"
+        R"(file="{}", )"
+        R"(buffer_size={})"
+        R"(}}, )"
         R"(test={{)"
         R"(enable_order_mass_cancel={}, )"
         R"(disable_remove_cl_ord_id={})"
@@ -71,6 +80,8 @@ struct fmt::formatter<roq::proxy::fix::Settings> {
         value.auth,
         value.server,
         value.client,
+        value.capture.file,
+        value.capture.buffer_size,
         value.test.enable_order_mass_cancel,
         value.test.disable_remove_cl_ord_id);
   }
@@ -2,6 +2,9 @@
 
 #include "roq/proxy/fix/shared.hpp"
 
+#include <cassert>
+#include <system_error>
+
 #include "roq/logging.hpp"
 
 #include "roq/clock.hpp"
@@ -16,6 +19,13 @@ namespace roq {
 namespace proxy {
 namespace fix {
 
+// === CONSTANTS ===
+
+namespace {
+auto const SESSION_TIMER_RESOLUTION = 10ms;
+auto const CAPTURE_REPORT_FREQUENCY = 10s;
+}  // namespace
+
 // === HELPERS ===
 
 namespace {
@@ -28,6 +38,39 @@ auto create_username_to_password_and_strategy_id(auto &config) {
   return result;
 }
 
+template <typename R>
+auto create_username_to_throttles(auto &config) {
+  using result_type = std::remove_cvref<R>::type;
+  result_type result;
+  auto create_token_bucket = [](auto &throttle) { return tools::TokenBucket{throttle.rate, throttle.burst}; };
+  for (auto &[_, user] : config.users) {
+    auto &throttle = user.throttle;
+    if (!throttle.orders.rate && !throttle.cancels.rate && !throttle.requests.rate)
+      continue;
+    log::info(R"(Throttle: username="{}")"sv, user.username);
+    result.try_emplace(
+        user.username,
+        typename result_type::mapped_type{
+            create_token_bucket(throttle.orders),
+            create_token_bucket(throttle.cancels),
+            create_token_bucket(throttle.requests),
+        });
+  }
+  return result;
+}
+
+auto create_entitlements(auto &config) {
+  tools::Entitlements result;
+  for (auto &[_, user] : config.users) {
+    if (std::empty(user.accounts))
+      continue;
+    if (!result.add(user.username, user.accounts))
+      log::fatal("Unexpected: too many accounts (max={})"sv, tools::Entitlements::MAX_ACCOUNTS);
+    log::info(R"(Entitlements: username="{}", accounts=[{}])"sv, user.username, fmt::join(user.accounts, ", "sv));
+  }
+  return result;
+}
+
 template <typename R>
 auto create_regex_symbols(auto &config) {
   using result_type = std::remove_cvref<R>::type;
@@ -39,6 +82,13 @@ auto create_regex_symbols(auto &config) {
   return result;
 }
 
+auto create_capture(auto &settings) -> std::unique_ptr<tools::Capture> {
+  if (std::empty(settings.capture.file))
+    return {};
+  log::info(R"(Capturing raw fix messages to "{}")"sv, settings.capture.file);
+  return std::make_unique<tools::Capture>(settings.capture.file, settings.capture.buffer_size);
+}
+
 auto create_next_request_id() {
   return static_cast<uint64_t>(clock::get_realtime().count());
 }
@@ -47,12 +97,46 @@ auto create_next_request_id() {
 // === IMPLEMENTATION ===
 
 Shared::Shared(Settings const &settings, Config const &config)
-    : settings{settings},
+    : settings{settings}, decode_buffer(settings.client.decode_buffer_size),
+      encode_buffer(settings.client.encode_buffer_size), session_timers{SESSION_TIMER_RESOLUTION},
       username_to_password_and_strategy_id_{
           create_username_to_password_and_strategy_id<decltype(username_to_password_and_strategy_id_)>(config)},
+      username_to_throttles_{create_username_to_throttles<decltype(username_to_throttles_)>(config)},
+      entitlements_{create_entitlements(config)},
       regex_symbols_{create_regex_symbols<decltype(regex_symbols_)>(config)},
       next_request_id_{create_next_request_id()},
-      crypto_{settings.client.auth_method, settings.client.auth_timestamp_tolerance} {
+      crypto_{settings.client.auth_method, settings.client.auth_timestamp_tolerance},
+      capture_{create_capture(settings)} {
+}
+
+Shared::~Shared() {
+  if (!capture_)
+    return;
+  (*capture_).flush();
+  auto dropped = (*capture_).dropped();
+  if (dropped)
+    log::warn("Capture: dropped {} message(s) in total"sv, dropped);
+}
+
+void Shared::refresh_capture(std::chrono::nanoseconds now) {
+  if (!capture_)
+    return;
+  auto error = (*capture_).error();
+  if (error != capture_status_.error) [[unlikely]] {
+    capture_status_.error = error;
+    log::error(
+        R"(Capture: no longer capturing (write failed: {}), file="{}")"sv,
+        std::generic_category().message(error),
+        settings.capture.file);
+  }
+  if (now < capture_status_.next_report)
+    return;
+  capture_status_.next_report = now + CAPTURE_REPORT_FREQUENCY;
+  auto dropped = (*capture_).dropped();
+  if (dropped == capture_status_.dropped)
+    return;
+  log::warn("Capture: dropped {} message(s) (total={})"sv, dropped - capture_status_.dropped, dropped);
+  capture_status_.dropped = dropped;
 }
 
 bool Shared::include(std::string_view const &symbol) const {
@@ -86,7 +170,7 @@ void Shared::remove_user(std::string_view const &username) {
 }
 
 void Shared::session_remove(uint64_t session_id) {
-  sessions_to_remove_.emplace(session_id);
+  sessions_to_remove_.emplace_back(session_id);
   session_remove_helper(session_id);
 }
 
@@ -107,14 +191,14 @@ std::string_view Shared::session_logon_helper(
     log::warn("Invalid: password"sv);
     return Error::INVALID_PASSWORD;
   }
-  auto iter_2 = username_to_session_.find(username);
-  if (iter_2 != std::end(username_to_session_)) {
-    log::warn(R"(Invalid: user already logged on (check session_id={}, username="{}"))"sv, (*iter_2).second, username);
+  auto res_1 = username_to_sessions_.try_emplace(username);
+  auto &sessions = (*res_1.first).second;
+  if (std::size(sessions) >= settings.client.max_sessions_per_user) {
+    log::warn(R"(Invalid: user already logged on (check username="{}", sessions={}))"sv, username, std::size(sessions));
     return Error::ALREADY_LOGGED_ON;
   }
   log::info(R"(Adding session_id={}, username="{}")"sv, session_id, username);
-  auto res_1 = username_to_session_.try_emplace(username, session_id);
-  assert(res_1.second);
+  sessions.emplace_back(session_id);
   auto &username_1 = (*res_1.first).first;
   [[maybe_unused]] auto res_2 = session_to_username_.try_emplace(session_id, username_1);
   assert(res_2.second);
@@ -128,7 +212,7 @@ std::string_view Shared::session_logout_helper(uint64_t session_id) {
     return Error::NOT_LOGGED_ON;
   auto &username = (*iter).second;
   log::info(R"(Removing session_id={}, username="{}")"sv, session_id, username);
-  username_to_session_.erase(username);
+  session_remove_from_user(session_id, username);
   session_to_username_.erase(iter);
   return {};
 }
@@ -138,11 +222,21 @@ void Shared::session_remove_helper(uint64_t session_id) {
   if (iter != std::end(session_to_username_)) {
     auto &username = (*iter).second;
     log::info(R"(Removing session_id={}, username="{}")"sv, session_id, username);
-    username_to_session_.erase((*iter).second);
+    session_remove_from_user(session_id, username);
     session_to_username_.erase(iter);
   }
 }
 
+void Shared::session_remove_from_user(uint64_t session_id, std::string_view const &username) {
+  auto iter = username_to_sessions_.find(username);
+  if (iter == std::end(username_to_sessions_))
+    return;
+  auto &sessions = (*iter).second;
+  std::erase(sessions, session_id);
+  if (std::empty(sessions))
+    username_to_sessions_.erase(iter);
+}
+
 void Shared::session_cleanup_helper(uint64_t session_id) {
   session_remove_helper(session_id);
   log::info("Removing session_id={}..."sv, session_id);
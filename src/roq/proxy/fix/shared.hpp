@@ -2,6 +2,10 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -12,7 +16,13 @@
 #include "roq/proxy/fix/config.hpp"
 #include "roq/proxy/fix/settings.hpp"
 
+#include "roq/proxy/fix/tools/capture.hpp"
+#include "roq/proxy/fix/tools/clock.hpp"
 #include "roq/proxy/fix/tools/crypto.hpp"
+#include "roq/proxy/fix/tools/entitlements.hpp"
+#include "roq/proxy/fix/tools/sending_time.hpp"
+#include "roq/proxy/fix/tools/timer_wheel.hpp"
+#include "roq/proxy/fix/tools/token_bucket.hpp"
 
 namespace roq {
 namespace proxy {
@@ -21,7 +31,7 @@ namespace fix {
 struct Shared final {
   Shared(Settings const &, Config const &);
 
-  uint64_t next_session_id = {};
+  ~Shared();
 
   utils::unordered_set<std::string> symbols;
 
@@ -29,7 +39,54 @@ struct Shared final {
 
   Settings const &settings;
 
-  std::string encode_buffer;
+  // note! scratch buffers shared by all client sessions (everything runs on the same thread)
+  std::vector<std::byte> decode_buffer;
+  std::vector<std::byte> encode_buffer;
+
+  // note! sampled once per io callback
+  tools::Clock clock;
+
+  // note! formatted once per millisecond, shared by all client sessions
+  tools::SendingTime sending_time;
+
+  // session_id => next deadline (logon, user response or heartbeat)
+  tools::TimerWheel<uint64_t> session_timers;
+
+  // note! raw message, no formatting on the hot path
+  void capture(tools::Capture::Direction direction, uint64_t session_id, std::span<std::byte const> const &message) {
+    if (capture_) [[unlikely]]
+      (*capture_)(direction, session_id, clock.get_realtime(), message);
+  }
+
+  // note! reports capture failures and dropped messages (called periodically from the event loop)
+  void refresh_capture(std::chrono::nanoseconds now);
+
+  enum class MessageClass : size_t {
+    ORDERS,
+    CANCELS,
+    REQUESTS,
+  };
+
+  // note! throttles are per user (shared by all sessions of that user)
+  bool is_throttled(std::string_view const &username, MessageClass message_class) {
+    auto iter = username_to_throttles_.find(username);
+    if (iter == std::end(username_to_throttles_))
+      return false;
+    auto &token_bucket = (*iter).second[static_cast<size_t>(message_class)];
+    return !token_bucket(clock.get_system());
+  }
+
+  bool is_entitled(std::string_view const &username, std::string_view const &account) const {
+    return entitlements_(username, account);
+  }
+
+  // note! cached data (e.g. positions) is only served to sessions explicitly entitled to the account
+  bool is_explicitly_entitled(uint64_t session_id, std::string_view const &account) const {
+    auto iter = session_to_username_.find(session_id);
+    if (iter == std::end(session_to_username_))
+      return false;
+    return entitlements_.is_explicit((*iter).second, account);
+  }
 
   void add_user(std::string_view const &username, std::string_view const &password, uint32_t strategy_id);
   void remove_user(std::string_view const &username);
@@ -61,6 +118,7 @@ struct Shared final {
 
   void session_remove(uint64_t session_id);
 
+  // note! must never be called from a session callback (the session would be released while still on the stack)
   template <typename Callback>
   void session_cleanup(Callback callback) {
     for (auto session_id : sessions_to_remove_) {
@@ -70,17 +128,33 @@ struct Shared final {
     sessions_to_remove_.clear();
   }
 
+  // note! callback is invoked for each session of the user
   template <typename Callback>
   bool session_find(std::string_view const &username, Callback callback) {
-    auto iter = username_to_session_.find(username);
-    if (iter == std::end(username_to_session_))
+    auto iter = username_to_sessions_.find(username);
+    if (iter == std::end(username_to_sessions_))
       return false;
-    callback((*iter).second);
+    for (auto session_id : (*iter).second)
+      callback(session_id);
     return true;
   }
 
   std::string create_request_id();
 
+  // note! outbound messages can be held while an inbound batch is being processed (see tools::Outbox)
+  void batch_begin() { batch_ = true; }
+  bool batch() const { return batch_; }
+
+  void session_flush(uint64_t session_id) { sessions_to_flush_.emplace_back(session_id); }
+
+  template <typename Callback>
+  void batch_end(Callback callback) {
+    batch_ = false;
+    for (auto session_id : sessions_to_flush_)
+      callback(session_id);
+    sessions_to_flush_.clear();
+  }
+
  protected:
   std::string_view session_logon_helper(
       uint64_t session_id,
@@ -91,17 +165,29 @@ struct Shared final {
   std::string_view session_logout_helper(uint64_t session_id);
   void session_remove_helper(uint64_t session_id);
   void session_cleanup_helper(uint64_t session_id);
+  void session_remove_from_user(uint64_t session_id, std::string_view const &username);
 
   utils::unordered_map<std::string, std::pair<std::string, uint32_t>> username_to_password_and_strategy_id_;
-  utils::unordered_map<std::string, uint64_t> username_to_session_;
+  // username => session_id's (at most max_sessions_per_user)
+  utils::unordered_map<std::string, std::vector<uint64_t>> username_to_sessions_;
+  utils::unordered_map<std::string, std::array<tools::TokenBucket, 3>> username_to_throttles_;
+  tools::Entitlements const entitlements_;
   utils::unordered_map<uint64_t, std::string> session_to_username_;
-  utils::unordered_set<uint64_t> sessions_to_remove_;
+  std::vector<uint64_t> sessions_to_remove_;  // note! a session can only become a zombie once
+  bool batch_ = {};
+  std::vector<uint64_t> sessions_to_flush_;  // note! a session is only added when its outbox was empty
 
  private:
   std::vector<utils::regex::Pattern> const regex_symbols_;
 
   uint64_t next_request_id_ = {};
   tools::Crypto crypto_;
+  std::unique_ptr<tools::Capture> const capture_;  // note! null if disabled
+  struct {
+    uint64_t dropped = {};
+    int error = {};
+    std::chrono::nanoseconds next_report = {};
+  } capture_status_;
 };
 
 }  // namespace fix
@@ -0,0 +1,89 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/simulator/controller.hpp"
+
+#include <magic_enum.hpp>
+
+#include "roq/logging.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace simulator {
+
+// === CONSTANTS ===
+
+namespace {
+auto const TIMER_FREQUENCY = 1ms;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+auto create_listener(auto &handler, auto &flags, auto &context) {
+  auto network_address = io::NetworkAddress{flags.listen_address};
+  log::debug("network_address={}"sv, network_address);
+  return context.create_tcp_listener(handler, network_address);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Controller::Controller(flags::Flags const &flags, io::Context &context)
+    : context_{context}, terminate_{context.create_signal(*this, io::sys::Signal::Type::TERMINATE)},
+      interrupt_{context.create_signal(*this, io::sys::Signal::Type::INTERRUPT)},
+      timer_{context.create_timer(*this, TIMER_FREQUENCY)}, listener_{create_listener(*this, flags, context)},
+      shared_{flags} {
+}
+
+void Controller::run() {
+  log::info("Event loop is now running"sv);
+  (*timer_).resume();
+  context_.dispatch();
+  log::info("Event loop has terminated"sv);
+}
+
+// io::sys::Signal::Handler
+
+void Controller::operator()(io::sys::Signal::Event const &event) {
+  log::warn("*** SIGNAL: {} ***"sv, magic_enum::enum_name(event.type));
+  context_.stop();
+}
+
+// io::sys::Timer::Handler
+
+void Controller::operator()(io::sys::Timer::Event const &event) {
+  shared_.clock.calibrate();
+  for (auto &session : sessions_)
+    (*session).refresh(event.now);
+  remove_zombies();
+}
+
+// io::net::tcp::Listener::Handler
+
+void Controller::operator()(io::net::tcp::Connection::Factory &factory) {
+  shared_.clock.update();
+  remove_zombies();
+  auto session_id = ++next_session_id_;
+  log::info("Connected (session_id={})"sv, session_id);
+  sessions_.emplace_back(std::make_unique<Session>(shared_, session_id, factory));
+}
+
+void Controller::operator()(io::net::tcp::Connection::Factory &factory, io::NetworkAddress const &) {
+  (*this)(factory);
+}
+
+// utilities
+
+// note! zombies are released as soon as we're no longer on their call stack, i.e. the next timer or accept callback
+void Controller::remove_zombies() {
+  std::erase_if(sessions_, [](auto &session) { return (*session).zombie(); });
+}
+
+}  // namespace simulator
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
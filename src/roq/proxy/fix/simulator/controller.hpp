@@ -0,0 +1,64 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "roq/io/context.hpp"
+
+#include "roq/io/sys/signal.hpp"
+#include "roq/io/sys/timer.hpp"
+
+#include "roq/io/net/tcp/listener.hpp"
+
+#include "roq/proxy/fix/simulator/session.hpp"
+#include "roq/proxy/fix/simulator/shared.hpp"
+
+#include "roq/proxy/fix/simulator/flags/flags.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace simulator {
+
+struct Controller final : public io::sys::Signal::Handler,
+                          public io::sys::Timer::Handler,
+                          public io::net::tcp::Listener::Handler {
+  Controller(flags::Flags const &, io::Context &);
+
+  Controller(Controller &&) = delete;
+  Controller(Controller const &) = delete;
+
+  void run();
+
+ protected:
+  // io::sys::Signal::Handler
+  void operator()(io::sys::Signal::Event const &) override;
+
+  // io::sys::Timer::Handler
+  void operator()(io::sys::Timer::Event const &) override;
+
+  // io::net::tcp::Listener::Handler
+  void operator()(io::net::tcp::Connection::Factory &) override;
+  void operator()(io::net::tcp::Connection::Factory &, io::NetworkAddress const &) override;
+
+  // utilities
+
+  void remove_zombies();
+
+ private:
+  io::Context &context_;
+  std::unique_ptr<io::sys::Signal> const terminate_;
+  std::unique_ptr<io::sys::Signal> const interrupt_;
+  std::unique_ptr<io::sys::Timer> const timer_;
+  std::unique_ptr<io::net::tcp::Listener> const listener_;
+  Shared shared_;
+  std::vector<std::unique_ptr<Session>> sessions_;
+  uint64_t next_session_id_ = {};
+};
+
+}  // namespace simulator
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,77 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/simulator/encoder.hpp"
+
+#include <fmt/format.h>
+
+#include "roq/proxy/fix/tools/splice.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace simulator {
+
+// === CONSTANTS ===
+
+namespace {
+auto const ENCODE_BUFFER_SIZE = size_t{1048576};
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Encoder::Encoder(std::string_view const &sender_comp_id)
+    : sender_comp_id_{sender_comp_id}, buffer_(ENCODE_BUFFER_SIZE) {
+}
+
+void Encoder::reset(std::string_view const &target_comp_id) {
+  comp_ids_ = tools::Splice::create_comp_ids(sender_comp_id_, target_comp_id);
+  msg_seq_num_ = {};
+}
+
+Encoder &Encoder::operator()(std::string_view const &msg_type) {
+  message_.clear();
+  message_.append("8=FIX.4.4\x01"
+                  "9=0\x01"sv);
+  return add(35, msg_type);
+}
+
+Encoder &Encoder::add(uint32_t tag, std::string_view const &value) {
+  fmt::format_to(std::back_inserter(message_), "{}={}\x01"sv, tag, value);
+  return *this;
+}
+
+Encoder &Encoder::add(uint32_t tag, char value) {
+  return add(tag, std::string_view{&value, 1});
+}
+
+template <typename T>
+requires std::integral<T> || std::floating_point<T>
+Encoder &Encoder::add(uint32_t tag, T value) {
+  fmt::format_to(std::back_inserter(message_), "{}={}\x01"sv, tag, value);
+  return *this;
+}
+
+template Encoder &Encoder::add(uint32_t, int32_t);
+template Encoder &Encoder::add(uint32_t, uint32_t);
+template Encoder &Encoder::add(uint32_t, int64_t);
+template Encoder &Encoder::add(uint32_t, uint64_t);
+template Encoder &Encoder::add(uint32_t, double);
+
+std::span<std::byte const> Encoder::encode(std::chrono::nanoseconds sending_time) {
+  message_.append("10=000\x01"sv);
+  auto header = tools::Splice::Header{
+      .comp_ids = comp_ids_,
+      .msg_seq_num = ++msg_seq_num_,
+      .sending_time = sending_time_(sending_time),
+  };
+  auto message = std::span{reinterpret_cast<std::byte const *>(std::data(message_)), std::size(message_)};
+  auto strip_party_ids = false;
+  return tools::Splice::encode(buffer_, message, header, {}, strip_party_ids);
+}
+
+}  // namespace simulator
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,55 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/proxy/fix/tools/sending_time.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace simulator {
+
+// note!
+// builds a fix message one field at a time (in the order given)
+// the session header is added, body length and checksum computed when the message is encoded (see Splice)
+
+struct Encoder final {
+  explicit Encoder(std::string_view const &sender_comp_id);
+
+  Encoder(Encoder &&) = delete;
+  Encoder(Encoder const &) = delete;
+
+  void reset(std::string_view const &target_comp_id);
+
+  Encoder &operator()(std::string_view const &msg_type);
+
+  Encoder &add(uint32_t tag, std::string_view const &value);
+  Encoder &add(uint32_t tag, char value);
+
+  template <typename T>
+  requires std::integral<T> || std::floating_point<T>
+  Encoder &add(uint32_t tag, T value);
+
+  std::span<std::byte const> encode(std::chrono::nanoseconds sending_time);
+
+ private:
+  std::string const sender_comp_id_;
+  std::string comp_ids_;
+  uint64_t msg_seq_num_ = {};
+  tools::SendingTime sending_time_;
+  std::string message_;
+  std::vector<std::byte> buffer_;
+};
+
+}  // namespace simulator
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,570 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/simulator/session.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+#include "roq/logging.hpp"
+
+#include "roq/proxy/fix/tools/splice.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace simulator {
+
+// === HELPERS ===
+
+namespace {
+auto find(auto &message, uint32_t tag) {
+  return tools::Splice::find(message, tag);
+}
+
+auto find_char(auto &message, uint32_t tag) {
+  auto value = find(message, tag);
+  return std::empty(value) ? '\0' : value[0];
+}
+
+auto find_double(auto &message, uint32_t tag) {
+  auto value = find(message, tag);
+  auto result = 0.0;
+  std::from_chars(std::data(value), std::data(value) + std::size(value), result);
+  return result;
+}
+
+bool is_working(char ord_status) {
+  switch (ord_status) {
+    case '0':  // New
+    case '1':  // PartiallyFilled
+      return true;
+    default:
+      return false;
+  }
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Session::Session(Shared &shared, uint64_t session_id, io::net::tcp::Connection::Factory &factory)
+    : shared_{shared}, session_id_{session_id}, connection_{factory.create(*this)}, encoder_{shared.flags.comp_id} {
+}
+
+void Session::refresh(std::chrono::nanoseconds now) {
+  if (zombie_ || !logged_on_)
+    return;
+  send_market_data(now);
+  if (next_heartbeat_ <= now)
+    send(encoder_("0"sv).encode(shared_.clock.get_realtime()));
+}
+
+// io::net::tcp::Connection::Handler
+
+void Session::operator()(io::net::tcp::Connection::Read const &) {
+  shared_.clock.update();
+  if (zombie_)
+    return;
+  buffer_.append(*connection_);
+  auto buffer = buffer_.data();
+  size_t total_bytes = 0;
+  while (!std::empty(buffer) && !zombie_) {
+    auto bytes = tools::Splice::get_message_length(buffer);
+    if (bytes == 0)
+      break;
+    parse(buffer.subspan(0, bytes));
+    total_bytes += bytes;
+    buffer = buffer.subspan(bytes);
+  }
+  buffer_.drain(total_bytes);
+}
+
+void Session::operator()(io::net::tcp::Connection::Disconnected const &) {
+  log::info("Disconnected (session_id={})"sv, session_id_);
+  zombie_ = true;
+}
+
+void Session::parse(std::span<std::byte const> const &message) {
+  auto msg_type = find(message, 35);
+  if (!logged_on_ && msg_type != "A"sv) {
+    log::warn("Unexpected: not logged on (session_id={}, msg_type={})"sv, session_id_, msg_type);
+    close();
+    return;
+  }
+  if (msg_type == "A"sv) {
+    on_logon(message);
+  } else if (msg_type == "5"sv) {
+    on_logout(message);
+  } else if (msg_type == "1"sv) {
+    on_test_request(message);
+  } else if (msg_type == "0"sv) {
+  } else if (msg_type == "BE"sv) {
+    on_user_request(message);
+  } else if (msg_type == "x"sv) {
+    on_security_list_request(message);
+  } else if (msg_type == "c"sv) {
+    on_security_definition_request(message);
+  } else if (msg_type == "e"sv) {
+    on_security_status_request(message);
+  } else if (msg_type == "V"sv) {
+    on_market_data_request(message);
+  } else if (msg_type == "D"sv) {
+    on_new_order_single(message);
+  } else if (msg_type == "F"sv) {
+    on_order_cancel_request(message);
+  } else if (msg_type == "G"sv) {
+    on_order_cancel_replace_request(message);
+  } else if (msg_type == "H"sv) {
+    on_order_status_request(message);
+  } else if (msg_type == "AF"sv) {
+    on_order_mass_status_request(message);
+  } else if (msg_type == "q"sv) {
+    on_order_mass_cancel_request(message);
+  } else if (msg_type == "AN"sv) {
+    on_request_for_positions(message);
+  } else if (msg_type == "AD"sv) {
+    on_trade_capture_report_request(message);
+  } else {
+    reject(message, "unsupported message type"sv);
+  }
+}
+
+// session
+
+void Session::on_logon(std::span<std::byte const> const &message) {
+  auto sender_comp_id = find(message, 49);
+  log::info(
+      R"(Logon (session_id={}, sender_comp_id="{}", username="{}"))"sv, session_id_, sender_comp_id, find(message, 553));
+  encoder_.reset(sender_comp_id);
+  logged_on_ = true;
+  last_market_data_ = shared_.clock.get_system();
+  encoder_("A"sv)
+      .add(98, '0')  // none
+      .add(108, std::chrono::duration_cast<std::chrono::seconds>(shared_.flags.heartbeat_freq).count());
+  send(encoder_.encode(shared_.clock.get_realtime()));
+}
+
+void Session::on_logout(std::span<std::byte const> const &) {
+  log::info("Logout (session_id={})"sv, session_id_);
+  send(encoder_("5"sv).encode(shared_.clock.get_realtime()));
+  close();
+}
+
+void Session::on_test_request(std::span<std::byte const> const &message) {
+  encoder_("0"sv).add(112, find(message, 112));
+  send(encoder_.encode(shared_.clock.get_realtime()));
+}
+
+// user
+
+void Session::on_user_request(std::span<std::byte const> const &message) {
+  auto user_request_type = find_char(message, 924);
+  auto user_status = user_request_type == '1' ? '1' : '2';  // LoggedIn : NotLoggedIn
+  encoder_("BF"sv)
+      .add(923, find(message, 923))  // UserRequestID
+      .add(553, find(message, 553))  // Username
+      .add(926, user_status);
+  send(encoder_.encode(shared_.clock.get_realtime()));
+}
+
+// reference data
+
+void Session::on_security_list_request(std::span<std::byte const> const &message) {
+  encoder_("y"sv)
+      .add(320, find(message, 320))  // SecurityReqID
+      .add(322, shared_.create_exec_id())
+      .add(560, '0')  // ValidRequest
+      .add(393, std::size(shared_.markets))
+      .add(893, 'Y')  // LastFragment
+      .add(146, std::size(shared_.markets));
+  for (auto &market : shared_.markets)
+    encoder_.add(55, market.symbol).add(207, shared_.flags.exchange);
+  send(encoder_.encode(shared_.clock.get_realtime()));
+}
+
+void Session::on_security_definition_request(std::span<std::byte const> const &message) {
+  auto symbol = find(message, 55);
+  if (shared_.find_market(symbol) < 0) {
+    reject(message, "unknown symbol"sv);
+    return;
+  }
+  encoder_("d"sv)
+      .add(320, find(message, 320))  // SecurityReqID
+      .add(322, shared_.create_exec_id())
+      .add(323, '4')  // ListOfSecuritiesReturnedPerRequest
+      .add(55, symbol)
+      .add(207, shared_.flags.exchange)
+      .add(969, shared_.flags.tick_size)
+      .add(562, shared_.flags.quantity);
+  send(encoder_.encode(shared_.clock.get_realtime()));
+}
+
+void Session::on_security_status_request(std::span<std::byte const> const &message) {
+  auto symbol = find(message, 55);
+  if (shared_.find_market(symbol) < 0) {
+    reject(message, "unknown symbol"sv);
+    return;
+  }
+  encoder_("f"sv)
+      .add(324, find(message, 324))  // SecurityStatusReqID
+      .add(55, symbol)
+      .add(207, shared_.flags.exchange)
+      .add(326, 17);  // ReadyToTrade
+  send(encoder_.encode(shared_.clock.get_realtime()));
+}
+
+// market data
+
+// note! only the first related symbol is used
+void Session::on_market_data_request(std::span<std::byte const> const &message) {
+  auto md_req_id = find(message, 262);
+  auto subscription_request_type = find_char(message, 263);
+  if (subscription_request_type == '2') {  // Unsubscribe
+    std::erase_if(subscriptions_, [&](auto &item) { return item.md_req_id == md_req_id; });
+    return;
+  }
+  auto index = shared_.find_market(find(message, 55));
+  if (index < 0) {
+    encoder_("Y"sv)
+        .add(262, md_req_id)
+        .add(281, '0');  // UnknownSymbol
+    send(encoder_.encode(shared_.clock.get_realtime()));
+    return;
+  }
+  auto &market = shared_.markets[index];
+  encoder_("W"sv)
+      .add(262, md_req_id)
+      .add(55, market.symbol)
+      .add(207, shared_.flags.exchange)
+      .add(268, 2)
+      .add(269, '0')  // Bid
+      .add(270, market.bid_price)
+      .add(271, shared_.flags.quantity)
+      .add(269, '1')  // Offer
+      .add(270, market.ask_price)
+      .add(271, shared_.flags.quantity);
+  send(encoder_.encode(shared_.clock.get_realtime()));
+  if (subscription_request_type == '1') {  // SnapshotAndUpdates
+    auto subscription = Subscription{
+        .md_req_id = std::string{md_req_id},
+        .market = static_cast<size_t>(index),
+    };
+    subscriptions_.emplace_back(std::move(subscription));
+  }
+}
+
+// orders
+
+void Session::on_new_order_single(std::span<std::byte const> const &message) {
+  auto cl_ord_id = find(message, 11);
+  if (cl_ord_id_to_order_id_.contains(cl_ord_id)) {
+    reject(message, "duplicate cl_ord_id"sv);
+    return;
+  }
+  auto order = Order{
+      .order_id = shared_.create_order_id(),
+      .cl_ord_id = std::string{cl_ord_id},
+      .account = std::string{find(message, 1)},
+      .symbol = std::string{find(message, 55)},
+      .side = find_char(message, 54),
+      .ord_type = find_char(message, 40),
+      .time_in_force = find_char(message, 59),
+      .order_qty = find_double(message, 38),
+      .price = find_double(message, 44),
+      .cum_qty = {},
+      .avg_px = {},
+      .ord_status = '0',  // New
+  };
+  if (shared_.find_market(order.symbol) < 0)
+    order.ord_status = '8';  // Rejected
+  send_execution_report(order, order.ord_status, {});
+  if (order.ord_status == '8')
+    return;
+  auto fill = shared_.fill();
+  auto &order_2 = (*orders_.try_emplace(order.order_id, std::move(order)).first).second;
+  cl_ord_id_to_order_id_.try_emplace(order_2.cl_ord_id, order_2.order_id);
+  if (fill)
+    send_fill(order_2);
+}
+
+void Session::on_order_cancel_request(std::span<std::byte const> const &message) {
+  auto cl_ord_id = find(message, 11);
+  auto orig_cl_ord_id = find(message, 41);
+  auto iter = cl_ord_id_to_order_id_.find(orig_cl_ord_id);
+  if (iter == std::end(cl_ord_id_to_order_id_)) {
+    send_order_cancel_reject(cl_ord_id, orig_cl_ord_id);
+    return;
+  }
+  auto &order = orders_[(*iter).second];
+  if (!is_working(order.ord_status)) {
+    send_order_cancel_reject(cl_ord_id, orig_cl_ord_id);
+    return;
+  }
+  order.cl_ord_id = cl_ord_id;
+  order.ord_status = '4';  // Canceled
+  cl_ord_id_to_order_id_.try_emplace(order.cl_ord_id, order.order_id);
+  send_execution_report(order, '4', orig_cl_ord_id);
+}
+
+void Session::on_order_cancel_replace_request(std::span<std::byte const> const &message) {
+  auto cl_ord_id = find(message, 11);
+  auto orig_cl_ord_id = find(message, 41);
+  auto iter = cl_ord_id_to_order_id_.find(orig_cl_ord_id);
+  if (iter == std::end(cl_ord_id_to_order_id_)) {
+    send_order_cancel_reject(cl_ord_id, orig_cl_ord_id);
+    return;
+  }
+  auto &order = orders_[(*iter).second];
+  if (!is_working(order.ord_status)) {
+    send_order_cancel_reject(cl_ord_id, orig_cl_ord_id);
+    return;
+  }
+  order.cl_ord_id = cl_ord_id;
+  if (auto order_qty = find_double(message, 38); order_qty > 0.0)
+    order.order_qty = order_qty;
+  if (auto price = find_double(message, 44); price > 0.0)
+    order.price = price;
+  cl_ord_id_to_order_id_.try_emplace(order.cl_ord_id, order.order_id);
+  send_execution_report(order, '5', orig_cl_ord_id);  // Replaced
+}
+
+void Session::on_order_status_request(std::span<std::byte const> const &message) {
+  auto cl_ord_id = find(message, 11);
+  auto iter = cl_ord_id_to_order_id_.find(cl_ord_id);
+  if (iter == std::end(cl_ord_id_to_order_id_)) {
+    reject(message, "unknown order"sv);
+    return;
+  }
+  send_execution_report(orders_[(*iter).second], 'I', {});  // OrderStatus
+}
+
+void Session::on_order_mass_status_request(std::span<std::byte const> const &message) {
+  auto mass_status_req_id = find(message, 584);
+  for (auto &[_, order] : orders_)
+    send_execution_report(order, 'I', {}, mass_status_req_id);  // OrderStatus
+}
+
+void Session::on_order_mass_cancel_request(std::span<std::byte const> const &message) {
+  auto cl_ord_id = find(message, 11);
+  auto symbol = find(message, 55);
+  auto mass_cancel_request_type = find_char(message, 530);
+  size_t count = 0;
+  for (auto &[_, order] : orders_) {
+    if (!is_working(order.ord_status))
+      continue;
+    if (mass_cancel_request_type == '1' && order.symbol != symbol)  // CancelOrdersForASecurity
+      continue;
+    order.ord_status = '4';  // Canceled
+    send_execution_report(order, '4', {});
+    ++count;
+  }
+  encoder_("r"sv)
+      .add(11, cl_ord_id)
+      .add(37, shared_.create_order_id())
+      .add(530, mass_cancel_request_type)
+      .add(531, mass_cancel_request_type)  // note! response mirrors request
+      .add(533, count);
+  send(encoder_.encode(shared_.clock.get_realtime()));
+}
+
+// positions and trades
+
+void Session::on_request_for_positions(std::span<std::byte const> const &message) {
+  auto pos_req_id = find(message, 710);
+  auto account = find(message, 1);
+  auto iter = shared_.positions.find(account);
+  auto count = iter != std::end(shared_.positions) ? std::size((*iter).second) : size_t{};
+  encoder_("AO"sv)
+      .add(721, shared_.create_exec_id())  // PosMaintRptID
+      .add(710, pos_req_id)
+      .add(727, count)  // TotalNumPosReports
+      .add(728, '0')    // ValidRequest
+      .add(729, '0')    // Completed
+      .add(1, account);
+  send(encoder_.encode(shared_.clock.get_realtime()));
+  if (count == 0)
+    return;
+  for (auto &[symbol, position] : (*iter).second) {
+    encoder_("AP"sv)
+        .add(721, shared_.create_exec_id())  // PosMaintRptID
+        .add(710, pos_req_id)
+        .add(728, '0')  // ValidRequest
+        .add(1, account)
+        .add(55, symbol)
+        .add(207, shared_.flags.exchange)
+        .add(702, 1)
+        .add(703, "TQ"sv)  // TransactionQuantity
+        .add(704, std::max(position, 0.0))
+        .add(705, std::max(-position, 0.0));
+    send(encoder_.encode(shared_.clock.get_realtime()));
+  }
+}
+
+void Session::on_trade_capture_report_request(std::span<std::byte const> const &message) {
+  auto trade_request_id = find(message, 568);
+  auto trade_request_type = find(message, 569);
+  encoder_("AQ"sv)
+      .add(568, trade_request_id)
+      .add(569, trade_request_type)
+      .add(748, std::size(trades_))  // TotNumTradeReports
+      .add(749, '0')                 // Successful
+      .add(750, '0');                // Accepted
+  send(encoder_.encode(shared_.clock.get_realtime()));
+  for (auto &trade : trades_) {
+    encoder_("AE"sv)
+        .add(571, trade.exec_id)  // TradeReportID
+        .add(568, trade_request_id)
+        .add(17, trade.exec_id)
+        .add(570, 'N')  // PreviouslyReported
+        .add(55, trade.symbol)
+        .add(207, shared_.flags.exchange)
+        .add(32, trade.quantity)
+        .add(31, trade.price)
+        .add(552, 1)
+        .add(54, trade.side)
+        .add(37, trade.order_id)
+        .add(11, trade.cl_ord_id)
+        .add(1, trade.account);
+    send(encoder_.encode(shared_.clock.get_realtime()));
+  }
+}
+
+// outbound
+
+void Session::reject(std::span<std::byte const> const &message, std::string_view const &text) {
+  log::warn(R"(Reject (session_id={}, msg_type={}, text="{}"))"sv, session_id_, find(message, 35), text);
+  encoder_("j"sv)
+      .add(45, find(message, 34))  // RefSeqNum
+      .add(372, find(message, 35))  // RefMsgType
+      .add(380, '0')                // Other
+      .add(58, text);
+  send(encoder_.encode(shared_.clock.get_realtime()));
+}
+
+void Session::send_execution_report(
+    Order const &order,
+    char exec_type,
+    std::string_view const &orig_cl_ord_id,
+    std::string_view const &mass_status_req_id) {
+  encoder_("8"sv).add(37, order.order_id).add(11, order.cl_ord_id);
+  if (!std::empty(orig_cl_ord_id))
+    encoder_.add(41, orig_cl_ord_id);
+  if (!std::empty(mass_status_req_id))
+    encoder_.add(584, mass_status_req_id);
+  encoder_.add(17, shared_.create_exec_id())
+      .add(150, exec_type)
+      .add(39, order.ord_status)
+      .add(1, order.account)
+      .add(55, order.symbol)
+      .add(207, shared_.flags.exchange)
+      .add(54, order.side)
+      .add(40, order.ord_type)
+      .add(38, order.order_qty)
+      .add(44, order.price)
+      .add(59, order.time_in_force)
+      .add(151, is_working(order.ord_status) ? (order.order_qty - order.cum_qty) : 0.0)
+      .add(14, order.cum_qty)
+      .add(6, order.avg_px);
+  send(encoder_.encode(shared_.clock.get_realtime()));
+}
+
+void Session::send_fill(Order &order) {
+  auto quantity = order.order_qty - order.cum_qty;
+  auto trade = Trade{
+      .exec_id = shared_.create_exec_id(),
+      .order_id = order.order_id,
+      .cl_ord_id = order.cl_ord_id,
+      .account = order.account,
+      .symbol = order.symbol,
+      .side = order.side,
+      .quantity = quantity,
+      .price = order.price,
+  };
+  order.avg_px = order.price;
+  order.cum_qty = order.order_qty;
+  order.ord_status = '2';  // Filled
+  auto &position = shared_.positions[order.account][order.symbol];
+  position += order.side == '1' ? quantity : -quantity;
+  encoder_("8"sv)
+      .add(37, order.order_id)
+      .add(11, order.cl_ord_id)
+      .add(17, trade.exec_id)
+      .add(150, 'F')  // Trade
+      .add(39, order.ord_status)
+      .add(1, order.account)
+      .add(55, order.symbol)
+      .add(207, shared_.flags.exchange)
+      .add(54, order.side)
+      .add(40, order.ord_type)
+      .add(38, order.order_qty)
+      .add(44, order.price)
+      .add(59, order.time_in_force)
+      .add(32, trade.quantity)
+      .add(31, trade.price)
+      .add(151, 0.0)
+      .add(14, order.cum_qty)
+      .add(6, order.avg_px);
+  send(encoder_.encode(shared_.clock.get_realtime()));
+  trades_.emplace_back(std::move(trade));
+}
+
+void Session::send_order_cancel_reject(std::string_view const &cl_ord_id, std::string_view const &orig_cl_ord_id) {
+  encoder_("9"sv)
+      .add(37, "NONE"sv)
+      .add(11, cl_ord_id)
+      .add(41, orig_cl_ord_id)
+      .add(39, '8')    // Rejected
+      .add(434, '1')   // OrderCancelRequest
+      .add(102, '1');  // UnknownOrder
+  send(encoder_.encode(shared_.clock.get_realtime()));
+}
+
+void Session::send_market_data(std::chrono::nanoseconds now) {
+  market_data_budget_ += shared_.flags.market_data_rate * std::chrono::duration<double>(now - last_market_data_).count();
+  last_market_data_ = now;
+  if (std::empty(subscriptions_)) {
+    market_data_budget_ = {};
+    return;
+  }
+  for (; market_data_budget_ >= 1.0; market_data_budget_ -= 1.0) {
+    for (auto &subscription : subscriptions_) {
+      auto &market = shared_.update_market(subscription.market);
+      encoder_("X"sv)
+          .add(262, subscription.md_req_id)
+          .add(268, 2)
+          .add(279, '1')  // Change
+          .add(269, '0')  // Bid
+          .add(55, market.symbol)
+          .add(207, shared_.flags.exchange)
+          .add(270, market.bid_price)
+          .add(271, shared_.flags.quantity)
+          .add(279, '1')  // Change
+          .add(269, '1')  // Offer
+          .add(55, market.symbol)
+          .add(207, shared_.flags.exchange)
+          .add(270, market.ask_price)
+          .add(271, shared_.flags.quantity);
+      send(encoder_.encode(shared_.clock.get_realtime()));
+    }
+  }
+}
+
+void Session::send(std::span<std::byte const> const &message) {
+  if (zombie_)
+    return;
+  (*connection_).send(message);
+  next_heartbeat_ = shared_.clock.get_system() + shared_.flags.heartbeat_freq;
+}
+
+void Session::close() {
+  if (zombie_)
+    return;
+  zombie_ = true;
+  (*connection_).close();
+}
+
+}  // namespace simulator
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,136 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/utils/container.hpp"
+
+#include "roq/io/buffer.hpp"
+
+#include "roq/io/net/tcp/connection.hpp"
+
+#include "roq/proxy/fix/simulator/encoder.hpp"
+#include "roq/proxy/fix/simulator/shared.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace simulator {
+
+// note!
+// implements the subset of the fix-bridge used by the proxy (see server::Session)
+// orders are acknowledged immediately (and optionally filled)
+// subscribed market data is updated at a fixed rate
+
+struct Session final : public io::net::tcp::Connection::Handler {
+  Session(Shared &, uint64_t session_id, io::net::tcp::Connection::Factory &);
+
+  Session(Session &&) = delete;
+  Session(Session const &) = delete;
+
+  bool zombie() const { return zombie_; }
+
+  void refresh(std::chrono::nanoseconds now);
+
+ protected:
+  // io::net::tcp::Connection::Handler
+  void operator()(io::net::tcp::Connection::Read const &) override;
+  void operator()(io::net::tcp::Connection::Disconnected const &) override;
+
+  void parse(std::span<std::byte const> const &message);
+
+  // session
+  void on_logon(std::span<std::byte const> const &);
+  void on_logout(std::span<std::byte const> const &);
+  void on_test_request(std::span<std::byte const> const &);
+  // user
+  void on_user_request(std::span<std::byte const> const &);
+  // reference data
+  void on_security_list_request(std::span<std::byte const> const &);
+  void on_security_definition_request(std::span<std::byte const> const &);
+  void on_security_status_request(std::span<std::byte const> const &);
+  // market data
+  void on_market_data_request(std::span<std::byte const> const &);
+  // orders
+  void on_new_order_single(std::span<std::byte const> const &);
+  void on_order_cancel_request(std::span<std::byte const> const &);
+  void on_order_cancel_replace_request(std::span<std::byte const> const &);
+  void on_order_status_request(std::span<std::byte const> const &);
+  void on_order_mass_status_request(std::span<std::byte const> const &);
+  void on_order_mass_cancel_request(std::span<std::byte const> const &);
+  // positions and trades
+  void on_request_for_positions(std::span<std::byte const> const &);
+  void on_trade_capture_report_request(std::span<std::byte const> const &);
+
+  void reject(std::span<std::byte const> const &, std::string_view const &text);
+
+  struct Order;
+
+  void send_execution_report(
+      Order const &,
+      char exec_type,
+      std::string_view const &orig_cl_ord_id,
+      std::string_view const &mass_status_req_id = {});
+  void send_fill(Order &);
+  void send_order_cancel_reject(std::string_view const &cl_ord_id, std::string_view const &orig_cl_ord_id);
+  void send_market_data(std::chrono::nanoseconds now);
+
+  void send(std::span<std::byte const> const &message);
+
+  void close();
+
+ private:
+  Shared &shared_;
+  uint64_t const session_id_;
+  std::unique_ptr<io::net::tcp::Connection> connection_;
+  io::Buffer buffer_;
+  Encoder encoder_;
+  bool logged_on_ = {};
+  bool zombie_ = {};
+  std::chrono::nanoseconds next_heartbeat_ = {};
+  std::chrono::nanoseconds last_market_data_ = {};
+  double market_data_budget_ = {};
+  struct Subscription final {
+    std::string md_req_id;
+    size_t market = {};
+  };
+  std::vector<Subscription> subscriptions_;
+  struct Order final {
+    std::string order_id;
+    std::string cl_ord_id;
+    std::string account;
+    std::string symbol;
+    char side = {};
+    char ord_type = {};
+    char time_in_force = {};
+    double order_qty = {};
+    double price = {};
+    double cum_qty = {};
+    double avg_px = {};
+    char ord_status = {};
+  };
+  utils::unordered_map<std::string, Order> orders_;  // note! by order_id
+  utils::unordered_map<std::string, std::string> cl_ord_id_to_order_id_;
+  struct Trade final {
+    std::string exec_id;
+    std::string order_id;
+    std::string cl_ord_id;
+    std::string account;
+    std::string symbol;
+    char side = {};
+    double quantity = {};
+    double price = {};
+  };
+  std::vector<Trade> trades_;
+};
+
+}  // namespace simulator
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,84 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/simulator/shared.hpp"
+
+#include <fmt/format.h>
+
+#include "roq/logging.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace simulator {
+
+// === HELPERS ===
+
+namespace {
+auto create_markets(auto &flags) {
+  std::vector<Shared::Market> result;
+  std::string_view symbols = flags.symbols;
+  while (!std::empty(symbols)) {
+    auto pos = symbols.find(',');
+    auto symbol = symbols.substr(0, pos);
+    if (!std::empty(symbol)) {
+      auto market = Shared::Market{
+          .symbol = std::string{symbol},
+          .bid_price = flags.price,
+          .ask_price = flags.price + flags.tick_size,
+      };
+      result.emplace_back(std::move(market));
+    }
+    if (pos == symbols.npos)
+      break;
+    symbols.remove_prefix(pos + 1);
+  }
+  if (std::empty(result))
+    log::fatal("Unexpected: no symbols"sv);
+  return result;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Shared::Shared(flags::Flags const &flags)
+    : flags{flags}, markets{create_markets(flags)}, random_engine_{flags.seed} {
+}
+
+int32_t Shared::find_market(std::string_view const &symbol) const {
+  for (size_t i = 0; i < std::size(markets); ++i)
+    if (markets[i].symbol == symbol)
+      return static_cast<int32_t>(i);
+  return -1;
+}
+
+Shared::Market const &Shared::update_market(size_t index) {
+  auto &market = markets[index];
+  auto direction = std::uniform_int_distribution<int32_t>{-1, 1}(random_engine_);
+  auto bid_price = market.bid_price + direction * flags.tick_size;
+  if (bid_price > 0.0) {
+    market.bid_price = bid_price;
+    market.ask_price = bid_price + flags.tick_size;
+  }
+  return market;
+}
+
+bool Shared::fill() {
+  if (flags.fill_probability <= 0.0)
+    return false;
+  return std::uniform_real_distribution<double>{0.0, 1.0}(random_engine_) < flags.fill_probability;
+}
+
+std::string Shared::create_order_id() {
+  return fmt::format("{}"sv, ++next_order_id_);
+}
+
+std::string Shared::create_exec_id() {
+  return fmt::format("{}"sv, ++next_exec_id_);
+}
+
+}  // namespace simulator
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
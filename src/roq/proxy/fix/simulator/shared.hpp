@@ -0,0 +1,65 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/utils/container.hpp"
+
+#include "roq/proxy/fix/tools/clock.hpp"
+
+#include "roq/proxy/fix/simulator/flags/flags.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace simulator {
+
+struct Shared final {
+  explicit Shared(flags::Flags const &);
+
+  Shared(Shared &&) = delete;
+  Shared(Shared const &) = delete;
+
+  flags::Flags const &flags;
+
+  // note! sampled once per io callback
+  tools::Clock clock;
+
+  struct Market final {
+    std::string symbol;
+    double bid_price = {};
+    double ask_price = {};
+  };
+
+  std::vector<Market> markets;
+
+  // note! index into markets (or -1 if the symbol is unknown)
+  int32_t find_market(std::string_view const &symbol) const;
+
+  // note! random walk, moves at most one tick
+  Market const &update_market(size_t index);
+
+  // note! filled immediately
+  bool fill();
+
+  std::string create_order_id();
+  std::string create_exec_id();
+
+  // account => symbol => net position
+  utils::unordered_map<std::string, utils::unordered_map<std::string, double>> positions;
+
+ private:
+  std::mt19937 random_engine_;
+  uint64_t next_order_id_ = {};
+  uint64_t next_exec_id_ = {};
+};
+
+}  // namespace simulator
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,96 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cerrno>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "roq/proxy/fix/tools/capture.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+using namespace roq::proxy::fix;
+
+namespace {
+auto to_span(auto const &value) {
+  return std::span{reinterpret_cast<std::byte const *>(std::data(value)), std::size(value)};
+}
+
+auto to_string_view(auto &value) {
+  return std::string_view{reinterpret_cast<char const *>(std::data(value)), std::size(value)};
+}
+
+auto create_path(std::string_view const &name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+}  // namespace
+
+TEST_CASE("proxy_tools_capture_simple", "[fix_proxy_tools_capture]") {
+  auto path = create_path("roq-fix-proxy-test-capture-simple.bin"sv);
+  {
+    tools::Capture capture{path, 4096};
+    capture(tools::Capture::Direction::CLIENT_INBOUND, 1, 1s, to_span("abc"sv));
+    capture(tools::Capture::Direction::SERVER_OUTBOUND, 2, 2s, to_span("defgh"sv));
+    // note! wraps around the ring buffer
+    for (size_t i = 0; i < 100; ++i) {
+      auto message = std::string(i, 'x');
+      capture(tools::Capture::Direction::CLIENT_OUTBOUND, 3, 3s, to_span(message));
+      capture.flush();  // note! avoid drops, the test is about wrapping
+    }
+    capture.flush();
+    CHECK(capture.dropped() == 0);
+  }
+  tools::Capture::Reader reader{path};
+  tools::Capture::Header header;
+  std::span<std::byte const> message;
+  REQUIRE(reader(header, message));
+  CHECK(header.direction == tools::Capture::Direction::CLIENT_INBOUND);
+  CHECK(header.session_id == 1);
+  CHECK(header.timestamp == std::chrono::nanoseconds{1s}.count());
+  CHECK(to_string_view(message) == "abc"sv);
+  REQUIRE(reader(header, message));
+  CHECK(header.direction == tools::Capture::Direction::SERVER_OUTBOUND);
+  CHECK(header.session_id == 2);
+  CHECK(to_string_view(message) == "defgh"sv);
+  for (size_t i = 0; i < 100; ++i) {
+    REQUIRE(reader(header, message));
+    CHECK(std::size(message) == i);
+  }
+  CHECK(!reader(header, message));
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("proxy_tools_capture_dropped", "[fix_proxy_tools_capture]") {
+  auto path = create_path("roq-fix-proxy-test-capture-dropped.bin"sv);
+  {
+    tools::Capture capture{path, 4096};
+    auto message = std::string(5000, 'x');
+    capture(tools::Capture::Direction::CLIENT_INBOUND, 1, 1s, to_span(message));
+    capture.flush();
+    CHECK(capture.dropped() == 1);
+  }
+  tools::Capture::Reader reader{path};
+  tools::Capture::Header header;
+  std::span<std::byte const> message;
+  CHECK(!reader(header, message));
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("proxy_tools_capture_write_error", "[fix_proxy_tools_capture]") {
+  if (!std::filesystem::exists("/dev/full"))
+    return;
+  // note! every write fails with ENOSPC, the writer thread must not terminate the process
+  tools::Capture capture{"/dev/full"sv, 4096};
+  CHECK(capture.error() == 0);
+  auto message = "8=FIX.4.4\x01"sv;
+  capture(tools::Capture::Direction::CLIENT_INBOUND, 1, 1s, to_span(message));
+  capture.flush();
+  CHECK(capture.error() == ENOSPC);
+  // note! no longer capturing
+  capture(tools::Capture::Direction::CLIENT_INBOUND, 1, 2s, to_span(message));
+  capture.flush();
+  CHECK(capture.dropped() == 0);
+}
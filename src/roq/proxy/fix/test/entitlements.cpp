@@ -0,0 +1,61 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <vector>
+
+#include "roq/proxy/fix/tools/entitlements.hpp"
+
+using namespace std::literals;
+
+using namespace roq::proxy::fix;
+
+TEST_CASE("proxy_tools_entitlements_simple", "[fix_proxy_tools_entitlements]") {
+  tools::Entitlements entitlements;
+  std::vector<std::string> accounts_1{"A1", "A2"};
+  std::vector<std::string> accounts_2{"A2"};
+  CHECK(entitlements.add("user_1"sv, accounts_1));
+  CHECK(entitlements.add("user_2"sv, accounts_2));
+  CHECK(entitlements.add("user_3"sv, std::vector<std::string>{}));
+  CHECK(entitlements("user_1"sv, "A1"sv));
+  CHECK(entitlements("user_1"sv, "A2"sv));
+  CHECK(!entitlements("user_2"sv, "A1"sv));
+  CHECK(entitlements("user_2"sv, "A2"sv));
+  // note! unknown account
+  CHECK(!entitlements("user_1"sv, "A3"sv));
+  // note! an empty account is left to the fix-bridge
+  CHECK(entitlements("user_2"sv, ""sv));
+  // note! users without accounts are not restricted
+  CHECK(entitlements("user_3"sv, "A1"sv));
+  CHECK(entitlements("user_3"sv, "A3"sv));
+  CHECK(entitlements("user_4"sv, "A1"sv));
+}
+
+TEST_CASE("proxy_tools_entitlements_explicit", "[fix_proxy_tools_entitlements]") {
+  tools::Entitlements entitlements;
+  std::vector<std::string> accounts{"A1"};
+  CHECK(entitlements.add("user_1"sv, accounts));
+  CHECK(entitlements.add("user_2"sv, std::vector<std::string>{}));
+  CHECK(entitlements.is_explicit("user_1"sv, "A1"sv));
+  CHECK(!entitlements.is_explicit("user_1"sv, "A2"sv));
+  CHECK(!entitlements.is_explicit("user_1"sv, ""sv));
+  // note! unrestricted, but never explicitly entitled
+  CHECK(entitlements("user_2"sv, "A1"sv));
+  CHECK(!entitlements.is_explicit("user_2"sv, "A1"sv));
+  CHECK(!entitlements.is_explicit("user_3"sv, "A1"sv));
+}
+
+TEST_CASE("proxy_tools_entitlements_max_accounts", "[fix_proxy_tools_entitlements]") {
+  tools::Entitlements entitlements;
+  std::vector<std::string> accounts;
+  for (size_t i = 0; i < tools::Entitlements::MAX_ACCOUNTS; ++i)
+    accounts.emplace_back(std::to_string(i));
+  CHECK(entitlements.add("user_1"sv, accounts));
+  // note! re-using existing accounts is fine
+  CHECK(entitlements.add("user_2"sv, accounts));
+  std::vector<std::string> accounts_2{"too_many"};
+  CHECK(!entitlements.add("user_3"sv, accounts_2));
+  CHECK(entitlements("user_1"sv, "1023"sv));
+  CHECK(!entitlements("user_1"sv, "too_many"sv));
+}
@@ -0,0 +1,31 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "roq/proxy/fix/tools/histogram.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+using namespace roq::proxy::fix;
+
+TEST_CASE("proxy_tools_histogram_simple", "[fix_proxy_tools_histogram]") {
+  tools::Histogram histogram;
+  CHECK(std::empty(histogram));
+  CHECK(histogram.percentile(50.0) == 0ns);
+  for (auto i = 100; i > 0; --i)
+    histogram(std::chrono::microseconds{i});
+  CHECK(std::size(histogram) == 100);
+  CHECK(histogram.min() == 1us);
+  CHECK(histogram.max() == 100us);
+  CHECK(histogram.percentile(50.0) == 50us);
+  CHECK(histogram.percentile(99.0) == 99us);
+  CHECK(histogram.percentile(99.9) == 100us);
+  CHECK(histogram.mean() == 50500ns);
+  histogram(1ms);
+  CHECK(histogram.max() == 1ms);
+  histogram.clear();
+  CHECK(std::empty(histogram));
+  histogram(2us);
+  CHECK(histogram.percentile(50.0) == 2us);
+}
@@ -0,0 +1,44 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace test {
+
+// note! body must start with MsgType (35), BeginString (8), BodyLength (9) and CheckSum (10) are added
+inline std::string create_message(std::string_view const &body) {
+  using namespace std::literals;
+  auto body_length = std::size(body);
+  auto result = fmt::format(
+      "8=FIX.4.4\x01"
+      "9={}\x01"
+      "{}"sv,
+      body_length,
+      body);
+  auto checksum = 0u;
+  for (auto c : result)
+    checksum += static_cast<uint8_t>(c);
+  return fmt::format("{}10={:03}\x01"sv, result, checksum % 256);
+}
+
+inline auto to_span(auto &value) {
+  return std::span{reinterpret_cast<std::byte const *>(std::data(value)), std::size(value)};
+}
+
+inline auto to_string_view(auto &value) {
+  return std::string_view{reinterpret_cast<char const *>(std::data(value)), std::size(value)};
+}
+
+}  // namespace test
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,211 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/proxy/fix/tools/outbox.hpp"
+
+#include "roq/proxy/fix/test/message.hpp"
+
+using namespace std::literals;
+
+using namespace roq::proxy::fix;
+using namespace roq::proxy::fix::test;
+
+namespace {
+// note! only the fields used by the outbox
+struct NewOrderSingle final {
+  static constexpr auto MSG_TYPE = roq::fix::MsgType::NEW_ORDER_SINGLE;
+  std::string_view cl_ord_id;
+};
+
+struct OrderCancelRequest final {
+  static constexpr auto MSG_TYPE = roq::fix::MsgType::ORDER_CANCEL_REQUEST;
+  std::string_view orig_cl_ord_id;
+  std::string_view cl_ord_id;
+};
+
+struct OrderMassCancelRequest final {
+  static constexpr auto MSG_TYPE = roq::fix::MsgType::ORDER_MASS_CANCEL_REQUEST;
+  std::string_view cl_ord_id;
+};
+
+struct ExecutionReport final {
+  static constexpr auto MSG_TYPE = roq::fix::MsgType::EXECUTION_REPORT;
+  std::string_view cl_ord_id;
+  std::string_view orig_cl_ord_id;
+};
+
+struct OrderCancelReject final {
+  static constexpr auto MSG_TYPE = roq::fix::MsgType::ORDER_CANCEL_REJECT;
+  std::string_view cl_ord_id;
+  std::string_view orig_cl_ord_id;
+};
+
+struct MarketDataIncrementalRefresh final {
+  static constexpr auto MSG_TYPE = roq::fix::MsgType::MARKET_DATA_INCREMENTAL_REFRESH;
+};
+
+// note! same as the sessions (held messages are framed when flushed)
+struct Sender final {
+  template <typename T>
+  void operator()(T const &value, std::string_view const &body) {
+    auto message = create_message(body);
+    auto priority = outbox.get_priority(value);
+    if (tools::Outbox::hold(priority)) {
+      outbox.push(priority, to_span(message), value);
+    } else {
+      sent.emplace_back(message);
+    }
+  }
+
+  void flush() {
+    outbox.flush([&](auto &, auto &message) { sent.emplace_back(to_string_view(message)); });
+  }
+
+  tools::Outbox outbox;
+  std::vector<std::string> sent;
+};
+}  // namespace
+
+TEST_CASE("proxy_tools_outbox_get_priority", "[fix_proxy_tools_outbox]") {
+  using enum tools::Outbox::Priority;
+  CHECK(tools::Outbox::get_priority(roq::fix::MsgType::HEARTBEAT) == SESSION);
+  CHECK(tools::Outbox::get_priority(roq::fix::MsgType::ORDER_CANCEL_REQUEST) == CANCELS);
+  CHECK(tools::Outbox::get_priority(roq::fix::MsgType::ORDER_MASS_CANCEL_REQUEST) == CANCELS);
+  CHECK(tools::Outbox::get_priority(roq::fix::MsgType::ORDER_CANCEL_REJECT) == CANCELS);
+  CHECK(tools::Outbox::get_priority(roq::fix::MsgType::ORDER_MASS_CANCEL_REPORT) == CANCELS);
+  CHECK(tools::Outbox::get_priority(roq::fix::MsgType::NEW_ORDER_SINGLE) == ORDERS);
+  CHECK(tools::Outbox::get_priority(roq::fix::MsgType::EXECUTION_REPORT) == ORDERS);
+  CHECK(tools::Outbox::get_priority(roq::fix::MsgType::MARKET_DATA_INCREMENTAL_REFRESH) == MARKET_DATA);
+  CHECK(!tools::Outbox::hold(SESSION));
+  CHECK(!tools::Outbox::hold(CANCELS));
+  CHECK(tools::Outbox::hold(ORDERS));
+  CHECK(tools::Outbox::hold(MARKET_DATA));
+  // note! nothing held
+  tools::Outbox outbox;
+  CHECK(outbox.get_priority(OrderCancelRequest{.orig_cl_ord_id = "a"sv, .cl_ord_id = "b"sv}) == CANCELS);
+  CHECK(outbox.get_priority(OrderMassCancelRequest{.cl_ord_id = "c"sv}) == CANCELS);
+  CHECK(outbox.get_priority(NewOrderSingle{.cl_ord_id = "a"sv}) == ORDERS);
+}
+
+TEST_CASE("proxy_tools_outbox_flush", "[fix_proxy_tools_outbox]") {
+  Sender sender;
+  CHECK(sender.outbox.empty());
+  sender(MarketDataIncrementalRefresh{}, "35=X\x01"
+                                         "262=1\x01"sv);
+  sender(ExecutionReport{.cl_ord_id = "a"sv, .orig_cl_ord_id = {}}, "35=8\x01"
+                                                                    "11=a\x01"sv);
+  sender(MarketDataIncrementalRefresh{}, "35=X\x01"
+                                         "262=2\x01"sv);
+  sender(ExecutionReport{.cl_ord_id = "b"sv, .orig_cl_ord_id = {}}, "35=8\x01"
+                                                                    "11=b\x01"sv);
+  CHECK(!sender.outbox.empty());
+  CHECK(std::empty(sender.sent));
+  sender.flush();
+  // note! priority first, then arrival order
+  REQUIRE(std::size(sender.sent) == 4);
+  CHECK(sender.sent[0] == create_message("35=8\x01"
+                                         "11=a\x01"sv));
+  CHECK(sender.sent[1] == create_message("35=8\x01"
+                                         "11=b\x01"sv));
+  CHECK(sender.sent[2] == create_message("35=X\x01"
+                                         "262=1\x01"sv));
+  CHECK(sender.sent[3] == create_message("35=X\x01"
+                                         "262=2\x01"sv));
+  CHECK(sender.outbox.empty());
+  sender.sent.clear();
+  sender.flush();
+  CHECK(std::empty(sender.sent));
+  // note! reusable
+  sender(MarketDataIncrementalRefresh{}, "35=X\x01"
+                                         "262=2\x01"sv);
+  sender.flush();
+  REQUIRE(std::size(sender.sent) == 1);
+  CHECK(sender.sent[0] == create_message("35=X\x01"
+                                         "262=2\x01"sv));
+}
+
+TEST_CASE("proxy_tools_outbox_reframe", "[fix_proxy_tools_outbox]") {
+  tools::Outbox outbox;
+  // note! as encoded without comp ids, msg_seq_num or sending time
+  auto encoded = create_message("35=D\x01"
+                                "49=\x01"
+                                "56=\x01"
+                                "34=0\x01"
+                                "52=19700101-00:00:00.000\x01"
+                                "11=a\x01"sv);
+  outbox.push(tools::Outbox::Priority::ORDERS, to_span(encoded), NewOrderSingle{.cl_ord_id = "a"sv});
+  auto comp_ids = tools::Splice::create_comp_ids("proxy"sv, "bridge"sv);
+  std::vector<std::string> sent;
+  outbox.flush([&](auto &buffer, auto &message) {
+    auto header = tools::Splice::Header{
+        .comp_ids = comp_ids,
+        .msg_seq_num = 42,
+        .sending_time = "20240101-00:00:00.123"sv,
+    };
+    auto message_2 = tools::Splice::reframe(buffer, message, header);
+    sent.emplace_back(to_string_view(message_2));
+  });
+  REQUIRE(std::size(sent) == 1);
+  CHECK(
+      sent[0] == create_message("35=D\x01"
+                                "49=proxy\x01"
+                                "56=bridge\x01"
+                                "34=42\x01"
+                                "52=20240101-00:00:00.123\x01"
+                                "11=a\x01"sv));
+}
+
+TEST_CASE("proxy_tools_outbox_new_then_cancel", "[fix_proxy_tools_outbox]") {
+  Sender sender;
+  // note! all received in the same batch
+  sender(MarketDataIncrementalRefresh{}, "35=X\x01"
+                                         "262=1\x01"sv);
+  sender(NewOrderSingle{.cl_ord_id = "a"sv}, "35=D\x01"
+                                             "11=a\x01"sv);
+  sender(OrderCancelRequest{.orig_cl_ord_id = "x"sv, .cl_ord_id = "y"sv}, "35=F\x01"
+                                                                          "11=y\x01"
+                                                                          "41=x\x01"sv);
+  sender(OrderCancelRequest{.orig_cl_ord_id = "a"sv, .cl_ord_id = "b"sv}, "35=F\x01"
+                                                                          "11=b\x01"
+                                                                          "41=a\x01"sv);
+  // note! the cancel for an order not held is sent immediately (ahead of everything held)
+  REQUIRE(std::size(sender.sent) == 1);
+  CHECK(sender.sent[0] == create_message("35=F\x01"
+                                         "11=y\x01"
+                                         "41=x\x01"sv));
+  sender.flush();
+  // note! the cancel never overtakes the order it refers to
+  REQUIRE(std::size(sender.sent) == 4);
+  CHECK(sender.sent[1] == create_message("35=D\x01"
+                                         "11=a\x01"sv));
+  CHECK(sender.sent[2] == create_message("35=F\x01"
+                                         "11=b\x01"
+                                         "41=a\x01"sv));
+  CHECK(sender.sent[3] == create_message("35=X\x01"
+                                         "262=1\x01"sv));
+  // note! nothing is held once flushed
+  CHECK(
+      sender.outbox.get_priority(OrderCancelRequest{.orig_cl_ord_id = "a"sv, .cl_ord_id = "c"sv}) ==
+      tools::Outbox::Priority::CANCELS);
+}
+
+TEST_CASE("proxy_tools_outbox_execution_report_then_cancel_reject", "[fix_proxy_tools_outbox]") {
+  using enum tools::Outbox::Priority;
+  Sender sender;
+  sender(ExecutionReport{.cl_ord_id = "b"sv, .orig_cl_ord_id = "a"sv}, "35=8\x01"
+                                                                       "11=b\x01"
+                                                                       "41=a\x01"sv);
+  // note! refers to the replaced order
+  CHECK(sender.outbox.get_priority(OrderCancelReject{.cl_ord_id = "c"sv, .orig_cl_ord_id = "b"sv}) == ORDERS);
+  CHECK(sender.outbox.get_priority(OrderCancelReject{.cl_ord_id = "c"sv, .orig_cl_ord_id = "a"sv}) == ORDERS);
+  CHECK(sender.outbox.get_priority(OrderCancelReject{.cl_ord_id = "c"sv, .orig_cl_ord_id = "d"sv}) == CANCELS);
+  // note! a mass cancel is held if any order is held
+  CHECK(sender.outbox.get_priority(OrderMassCancelRequest{.cl_ord_id = "e"sv}) == ORDERS);
+  sender.outbox.clear();
+  CHECK(sender.outbox.get_priority(OrderMassCancelRequest{.cl_ord_id = "e"sv}) == CANCELS);
+}
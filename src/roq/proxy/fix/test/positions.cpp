@@ -0,0 +1,165 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <vector>
+
+#include "roq/proxy/fix/positions.hpp"
+
+using namespace std::literals;
+
+using namespace roq::proxy::fix;
+
+namespace {
+auto const ACCOUNT = "A1"sv;
+
+auto create_item(roq::fix::PosType pos_type, double long_qty, double short_qty) {
+  auto result = roq::codec::fix::Position{};
+  result.pos_type = pos_type;
+  result.long_qty = {long_qty, {}};
+  result.short_qty = {short_qty, {}};
+  return result;
+}
+
+auto create_position_report(std::string_view const &symbol, std::span<roq::codec::fix::Position const> const &items) {
+  auto result = roq::codec::fix::PositionReport{};
+  result.pos_req_result = roq::fix::PosReqResult::VALID;
+  result.account = ACCOUNT;
+  result.symbol = symbol;
+  result.security_exchange = "deribit"sv;
+  result.no_positions = items;
+  return result;
+}
+
+auto create_fill(std::string_view const &symbol, roq::fix::Side side, double quantity) {
+  auto result = roq::codec::fix::ExecutionReport{};
+  result.exec_type = roq::fix::ExecType::TRADE;
+  result.account = ACCOUNT;
+  result.symbol = symbol;
+  result.security_exchange = "deribit"sv;
+  result.side = side;
+  result.last_qty = {quantity, {}};
+  return result;
+}
+
+auto find(Positions const &positions, std::string_view const &symbol, roq::fix::PosType pos_type) {
+  Positions::Position result;
+  positions.get(ACCOUNT, [&](auto &position) {
+    if (position.symbol == symbol && position.pos_type == pos_type)
+      result = position;
+  });
+  return result;
+}
+}  // namespace
+
+TEST_CASE("proxy_positions_snapshot", "[fix_proxy_positions]") {
+  Positions positions;
+  CHECK(!positions.is_complete(ACCOUNT));
+  positions.begin_snapshot(ACCOUNT, 2);
+  CHECK(!positions.is_complete(ACCOUNT));
+  auto count = size_t{};
+  auto callback = [&]([[maybe_unused]] auto &account, [[maybe_unused]] auto &position) { ++count; };
+  auto item_1 = create_item(roq::fix::PosType::TRANSACTION_QUANTITY, 1.0, 0.0);
+  positions(create_position_report("BTC-PERPETUAL"sv, {&item_1, 1}), callback);
+  CHECK(!positions.is_complete(ACCOUNT));
+  auto item_2 = create_item(roq::fix::PosType::TRANSACTION_QUANTITY, 0.0, 2.0);
+  positions(create_position_report("ETH-PERPETUAL"sv, {&item_2, 1}), callback);
+  CHECK(positions.is_complete(ACCOUNT));
+  CHECK(count == 2);
+  CHECK(positions.size(ACCOUNT) == 2);
+  // note! a refresh is not complete until all reports have been received
+  positions.begin_snapshot(ACCOUNT, 1);
+  CHECK(!positions.is_complete(ACCOUNT));
+  CHECK(positions.size(ACCOUNT) == 0);
+  positions(create_position_report("BTC-PERPETUAL"sv, {&item_1, 1}), callback);
+  CHECK(positions.is_complete(ACCOUNT));
+  CHECK(positions.size(ACCOUNT) == 1);
+  // note! empty snapshot
+  positions.begin_snapshot(ACCOUNT, 0);
+  CHECK(positions.is_complete(ACCOUNT));
+  CHECK(positions.size(ACCOUNT) == 0);
+}
+
+TEST_CASE("proxy_positions_pos_type", "[fix_proxy_positions]") {
+  Positions positions;
+  positions.begin_snapshot(ACCOUNT, 1);
+  std::vector<roq::codec::fix::Position> items{
+      create_item(roq::fix::PosType::TRANSACTION_QUANTITY, 3.0, 0.0),
+      create_item(roq::fix::PosType::START_OF_DAY_QTY, 1.0, 0.0),
+  };
+  auto count = size_t{};
+  positions(create_position_report("BTC-PERPETUAL"sv, items), [&](auto &, auto &) { ++count; });
+  CHECK(count == 2);
+  CHECK(positions.size(ACCOUNT) == 2);
+  // note! never combined
+  CHECK(find(positions, "BTC-PERPETUAL"sv, roq::fix::PosType::TRANSACTION_QUANTITY).long_qty.value == 3.0);
+  CHECK(find(positions, "BTC-PERPETUAL"sv, roq::fix::PosType::START_OF_DAY_QTY).long_qty.value == 1.0);
+  // note! fills only update transaction quantity
+  positions(create_fill("BTC-PERPETUAL"sv, roq::fix::Side::SELL, 5.0), [](auto &, auto &) {}, [](auto &, auto &) {});
+  auto position = find(positions, "BTC-PERPETUAL"sv, roq::fix::PosType::TRANSACTION_QUANTITY);
+  CHECK(position.long_qty.value == 0.0);
+  CHECK(position.short_qty.value == 2.0);
+  CHECK(find(positions, "BTC-PERPETUAL"sv, roq::fix::PosType::START_OF_DAY_QTY).long_qty.value == 1.0);
+}
+
+TEST_CASE("proxy_positions_fill_before_complete", "[fix_proxy_positions]") {
+  Positions positions;
+  positions.begin_snapshot(ACCOUNT, 1);
+  auto count = size_t{};
+  // note! the snapshot will include this fill
+  positions(
+      create_fill("BTC-PERPETUAL"sv, roq::fix::Side::BUY, 1.0),
+      [&](auto &, auto &) { ++count; },
+      [](auto &, auto &) {});
+  CHECK(count == 0);
+  CHECK(positions.size(ACCOUNT) == 0);
+}
+
+TEST_CASE("proxy_positions_fill_invalidates", "[fix_proxy_positions]") {
+  Positions positions;
+  positions.begin_snapshot(ACCOUNT, 1);
+  auto item = create_item(roq::fix::PosType::START_OF_DAY_QTY, 1.0, 0.0);
+  positions(create_position_report("BTC-PERPETUAL"sv, {&item, 1}), [](auto &, auto &) {});
+  CHECK(positions.is_complete(ACCOUNT));
+  positions.subscribe(ACCOUNT, "sub-1"sv);
+  // note! transaction quantity is not reported by the fix-bridge, a fill can't be applied
+  auto count = size_t{};
+  std::vector<std::string> dropped;
+  positions(
+      create_fill("BTC-PERPETUAL"sv, roq::fix::Side::BUY, 1.0),
+      [&](auto &, auto &) { ++count; },
+      [&](auto &account, auto &request_id) {
+        CHECK(account == ACCOUNT);
+        dropped.emplace_back(request_id);
+      });
+  CHECK(count == 0);
+  CHECK(!positions.is_complete(ACCOUNT));
+  CHECK(positions.size(ACCOUNT) == 0);
+  REQUIRE(std::size(dropped) == 1);
+  CHECK(dropped[0] == "sub-1"sv);
+  CHECK(!positions.is_subscription("sub-1"sv));
+}
+
+TEST_CASE("proxy_positions_clear", "[fix_proxy_positions]") {
+  Positions positions;
+  positions.begin_snapshot(ACCOUNT, 1);
+  auto item = create_item(roq::fix::PosType::TRANSACTION_QUANTITY, 0.0, 0.0);
+  positions(create_position_report("BTC-PERPETUAL"sv, {&item, 1}), [](auto &, auto &) {});
+  CHECK(positions.is_complete(ACCOUNT));
+  positions(create_fill("ETH-PERPETUAL"sv, roq::fix::Side::BUY, 1.0), [](auto &, auto &) {}, [](auto &, auto &) {});
+  CHECK(positions.size(ACCOUNT) == 2);
+  positions.subscribe(ACCOUNT, "sub-1"sv);
+  positions.subscribe("A2"sv, "sub-2"sv);
+  std::vector<std::string> dropped;
+  positions.clear([&](auto &, auto &request_id) { dropped.emplace_back(request_id); });
+  CHECK(!positions.is_complete(ACCOUNT));
+  CHECK(positions.size(ACCOUNT) == 0);
+  // note! subscribers must never be attached to a cache being rebuilt
+  CHECK(std::size(dropped) == 2);
+  CHECK(!positions.is_subscription("sub-1"sv));
+  CHECK(!positions.is_subscription("sub-2"sv));
+  auto count = size_t{};
+  positions.get_subscriptions(ACCOUNT, [&](auto &) { ++count; });
+  CHECK(count == 0);
+}
@@ -0,0 +1,127 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <fmt/format.h>
+
+#include <limits>
+
+#include "roq/proxy/fix/risk.hpp"
+
+using namespace std::literals;
+
+using namespace roq::proxy::fix;
+
+namespace {
+auto const CONFIG = R"(
+symbols = [ ".*" ]
+
+[users.c1]
+username = "c1"
+password = "secret"
+
+[accounts.A1]
+max_order_qty = 10.0
+max_open_orders = 2
+
+[accounts.A2]
+max_notional = 1000.0
+price_band = 0.1
+)"sv;
+
+auto create_new_order_single(std::string_view const &account, double quantity, double price) {
+  auto result = roq::codec::fix::NewOrderSingle{};
+  result.account = account;
+  result.symbol = "BTC-PERPETUAL"sv;
+  result.security_exchange = "deribit"sv;
+  result.order_qty = {quantity, {}};
+  result.price = {price, {}};
+  return result;
+}
+
+auto create_trade(double price) {
+  auto body = fmt::format(
+      "35=X\x01"
+      "55=BTC-PERPETUAL\x01"
+      "207=deribit\x01"
+      "268=1\x01"
+      "269=2\x01"
+      "270={}\x01"sv,
+      price);
+  return fmt::format("8=FIX.4.4\x01"
+                     "9={}\x01"
+                     "{}10=000\x01"sv,
+                     std::size(body),
+                     body);
+}
+
+auto to_span(auto &value) {
+  return std::span{reinterpret_cast<std::byte const *>(std::data(value)), std::size(value)};
+}
+}  // namespace
+
+TEST_CASE("proxy_risk_open_orders", "[fix_proxy_risk]") {
+  auto config = Config::parse_text(CONFIG);
+  Risk risk{config};
+  auto account_id = risk.find("A1"sv);
+  REQUIRE(account_id != Risk::UNDEFINED);
+  CHECK(risk.find("A3"sv) == Risk::UNDEFINED);
+  auto new_order_single = create_new_order_single("A1"sv, 1.0, 100.0);
+  CHECK(std::empty(risk.check(account_id, new_order_single)));
+  risk.add(account_id, "1"sv);
+  risk.add(account_id, "1"sv);  // note! idempotent
+  CHECK(risk.get_open_orders(account_id) == 1);
+  risk.add(account_id, "2"sv);
+  CHECK(risk.check(account_id, new_order_single) == "RISK_MAX_OPEN_ORDERS"sv);
+  // note! replace keeps the order open
+  risk.replace("2"sv, "3"sv);
+  CHECK(risk.get_open_orders(account_id) == 2);
+  risk.remove("2"sv);
+  CHECK(risk.get_open_orders(account_id) == 2);
+  risk.remove("3"sv);
+  CHECK(risk.get_open_orders(account_id) == 1);
+  CHECK(std::empty(risk.check(account_id, new_order_single)));
+  risk.remove("3"sv);  // note! idempotent
+  CHECK(risk.get_open_orders(account_id) == 1);
+  // note! e.g. the fix-bridge disconnected
+  risk.add(account_id, "4"sv);
+  risk.clear();
+  CHECK(risk.get_open_orders(account_id) == 0);
+  risk.remove("1"sv);
+  CHECK(risk.get_open_orders(account_id) == 0);
+}
+
+TEST_CASE("proxy_risk_max_order_qty", "[fix_proxy_risk]") {
+  auto config = Config::parse_text(CONFIG);
+  Risk risk{config};
+  auto account_id = risk.find("A1"sv);
+  CHECK(std::empty(risk.check(account_id, create_new_order_single("A1"sv, 10.0, 100.0))));
+  CHECK(risk.check(account_id, create_new_order_single("A1"sv, 10.1, 100.0)) == "RISK_MAX_ORDER_QTY"sv);
+  // note! no limits
+  CHECK(std::empty(risk.check(Risk::UNDEFINED, create_new_order_single("A3"sv, 1000.0, 100.0))));
+}
+
+TEST_CASE("proxy_risk_market_data", "[fix_proxy_risk]") {
+  auto config = Config::parse_text(CONFIG);
+  Risk risk{config};
+  CHECK(risk.requires_market_data());
+  auto account_id = risk.find("A2"sv);
+  REQUIRE(account_id != Risk::UNDEFINED);
+  // note! no reference price means no band, notional uses the limit price
+  CHECK(std::empty(risk.check(account_id, create_new_order_single("A2"sv, 1.0, 500.0))));
+  CHECK(risk.check(account_id, create_new_order_single("A2"sv, 3.0, 500.0)) == "RISK_MAX_NOTIONAL"sv);
+  // note! market order
+  CHECK(
+      risk.check(account_id, create_new_order_single("A2"sv, 1.0, std::numeric_limits<double>::quiet_NaN())) ==
+      "RISK_NO_REFERENCE_PRICE"sv);
+  auto trade = create_trade(100.0);
+  risk(to_span(trade));
+  CHECK(std::empty(risk.check(account_id, create_new_order_single("A2"sv, 1.0, 105.0))));
+  CHECK(risk.check(account_id, create_new_order_single("A2"sv, 1.0, 115.0)) == "RISK_PRICE_BAND"sv);
+  CHECK(risk.check(account_id, create_new_order_single("A2"sv, 1.0, 85.0)) == "RISK_PRICE_BAND"sv);
+  CHECK(
+      std::empty(risk.check(account_id, create_new_order_single("A2"sv, 1.0, std::numeric_limits<double>::quiet_NaN()))));
+  CHECK(
+      risk.check(account_id, create_new_order_single("A2"sv, 11.0, std::numeric_limits<double>::quiet_NaN())) ==
+      "RISK_MAX_NOTIONAL"sv);
+}
@@ -0,0 +1,312 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <fmt/format.h>
+
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "roq/proxy/fix/tools/router.hpp"
+#include "roq/proxy/fix/tools/timer_wheel.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+using namespace roq::proxy::fix;
+
+// note!
+// single-threaded simulation of the controller's req_id routing
+// - the clock is virtual and only advanced explicitly
+// - all randomness is seeded, failures are therefore reproducible
+// - every step is checked against a trivial reference model
+
+namespace {
+auto const REQUEST_TIMEOUT = 5s;
+
+struct Harness final {
+  struct Timeout final {
+    std::string req_id;  // server
+  };
+
+  // client sends a request, returns the server side req_id (empty if rejected as duplicate)
+  std::string request(
+      uint64_t session_id, std::string_view const &req_id, bool keep_alive = false, std::string request_id = {}) {
+    if (std::empty(request_id))
+      request_id = fmt::format("srv-{}"sv, ++counter);
+    if (!router.add(req_id, request_id, session_id, keep_alive))
+      return {};
+    auto route = router.find(request_id);
+    REQUIRE(route != nullptr);
+    (*route).timeout = timeouts.add(now, now + REQUEST_TIMEOUT, Timeout{.req_id = request_id});
+    model.try_emplace(request_id, session_id, std::string{req_id});
+    return request_id;
+  }
+
+  // client sends an order, the server side cl_ord_id is derived from the strategy (shared by all its sessions)
+  std::string order(uint64_t session_id, uint32_t strategy_id, std::string_view const &cl_ord_id) {
+    return request(session_id, cl_ord_id, true, fmt::format("proxy-{}:{}"sv, strategy_id, cl_ord_id));
+  }
+
+  // server responds, returns the client session (0 if unknown)
+  uint64_t response(std::string_view const &request_id) {
+    auto result = uint64_t{};
+    router.remove(request_id, [&](auto &route) {
+      result = route.session_id;
+      timeouts.remove(route.timeout);
+    });
+    model.erase(std::string{request_id});
+    return result;
+  }
+
+  // client disconnects
+  void disconnect(uint64_t session_id) {
+    router.clear(session_id, [&](auto &request_id, auto &route) {
+      timeouts.remove(route.timeout);
+      cleared.emplace_back(request_id);
+    });
+    std::erase_if(model, [&](auto &item) { return item.second.first == session_id; });
+  }
+
+  void advance(std::chrono::nanoseconds delta) {
+    now += delta;
+    timeouts(now, [&](auto &timeout) {
+      auto result = router.remove(timeout.req_id, [&](auto &route) { route.timeout = {}; });
+      CHECK(result == true);
+      expired.emplace_back(timeout.req_id);
+      model.erase(timeout.req_id);
+    });
+  }
+
+  void validate() const {
+    REQUIRE(std::size(router) == std::size(model));
+    REQUIRE(std::size(timeouts) == std::size(model));
+    for (auto &[request_id, item] : model) {
+      auto route = router.find(request_id);
+      REQUIRE(route != nullptr);
+      CHECK((*route).session_id == item.first);
+      CHECK((*route).req_id == item.second);
+      if (!std::empty(item.second))
+        CHECK(router.find(item.first, item.second) == request_id);
+    }
+    auto count = size_t{};
+    router.get_all([&](auto &request_id, auto &route) {
+      CHECK(model.find(request_id) != std::end(model));
+      CHECK(route.session_id != 0);
+      ++count;
+    });
+    CHECK(count == std::size(model));
+    CHECK(router.validate());  // note! every route has exactly one reverse entry
+  }
+
+  std::chrono::nanoseconds now = 1000s;
+  uint64_t counter = {};
+  tools::Router router;
+  tools::TimerWheel<Timeout> timeouts{100ms};
+  // req_id(server) => (session_id, req_id(client))
+  std::map<std::string, std::pair<uint64_t, std::string>> model;
+  std::vector<std::string> cleared;
+  std::vector<std::string> expired;
+};
+}  // namespace
+
+TEST_CASE("proxy_tools_router_simple", "[fix_proxy_tools_router]") {
+  Harness harness;
+  auto request_id = harness.request(1, "abc"sv);
+  CHECK(request_id == "srv-1"sv);
+  CHECK(harness.router.find(1, "abc"sv) == request_id);
+  CHECK(std::empty(harness.router.find(2, "abc"sv)));
+  auto route = harness.router.find(request_id);
+  REQUIRE(route != nullptr);
+  CHECK((*route).session_id == 1);
+  CHECK((*route).req_id == "abc"sv);
+  harness.validate();
+  CHECK(harness.response(request_id) == 1);
+  CHECK(harness.response(request_id) == 0);
+  CHECK(std::empty(harness.router));
+  harness.validate();
+}
+
+TEST_CASE("proxy_tools_router_duplicate_req_id", "[fix_proxy_tools_router]") {
+  Harness harness;
+  auto request_id_1 = harness.request(1, "abc"sv);
+  CHECK(!std::empty(request_id_1));
+  // note! same client req_id from the same session is rejected, first mapping wins
+  CHECK(std::empty(harness.request(1, "abc"sv)));
+  CHECK(harness.router.find(1, "abc"sv) == request_id_1);
+  // note! same client req_id from another session is fine
+  auto request_id_2 = harness.request(2, "abc"sv);
+  CHECK(!std::empty(request_id_2));
+  CHECK(request_id_2 != request_id_1);
+  // note! server req_id is unique
+  CHECK(harness.router.add("xyz"sv, request_id_1, 3, false) == false);
+  CHECK(std::empty(harness.router.find(3, "xyz"sv)));
+  harness.validate();
+  // note! re-use is possible once the first request has completed
+  harness.response(request_id_1);
+  CHECK(!std::empty(harness.request(1, "abc"sv)));
+  harness.validate();
+}
+
+TEST_CASE("proxy_tools_router_shared_cl_ord_id", "[fix_proxy_tools_router]") {
+  Harness harness;
+  // note! two sessions of the same strategy
+  auto request_id_1 = harness.order(1, 123, "X"sv);
+  CHECK(request_id_1 == "proxy-123:X"sv);
+  CHECK(std::empty(harness.order(2, 123, "X"sv)));
+  // note! the first order keeps its route, nothing is indexed for the second session
+  auto route = harness.router.find(request_id_1);
+  REQUIRE(route != nullptr);
+  CHECK((*route).session_id == 1);
+  CHECK(std::empty(harness.router.find(2, "X"sv)));
+  harness.validate();
+  // note! another strategy can use the same cl_ord_id
+  CHECK(!std::empty(harness.order(3, 456, "X"sv)));
+  harness.validate();
+  // note! responses for the first order are never routed to the second session
+  CHECK(harness.response(request_id_1) == 1);
+  CHECK(harness.order(2, 123, "X"sv) == request_id_1);
+  CHECK(harness.response(request_id_1) == 2);
+  harness.validate();
+}
+
+TEST_CASE("proxy_tools_router_optional_req_id", "[fix_proxy_tools_router]") {
+  Harness harness;
+  auto request_id_1 = harness.request(1, {});
+  auto request_id_2 = harness.request(1, {});
+  CHECK(!std::empty(request_id_1));
+  CHECK(!std::empty(request_id_2));
+  CHECK(std::size(harness.router) == 2);
+  CHECK(std::empty(harness.router.find(1, {})));
+  harness.validate();
+  CHECK(harness.response(request_id_1) == 1);
+  harness.validate();
+}
+
+TEST_CASE("proxy_tools_router_disconnect_optional_req_id", "[fix_proxy_tools_router]") {
+  Harness harness;
+  auto request_id_1 = harness.request(1, {});
+  auto request_id_2 = harness.request(1, {});
+  auto request_id_3 = harness.request(1, "abc"sv);
+  auto request_id_4 = harness.request(2, {});
+  harness.validate();
+  harness.disconnect(1);
+  CHECK(std::size(harness.cleared) == 3);
+  CHECK(harness.router.find(request_id_1) == nullptr);
+  CHECK(harness.router.find(request_id_2) == nullptr);
+  CHECK(harness.router.find(request_id_3) == nullptr);
+  CHECK(harness.router.find(request_id_4) != nullptr);
+  harness.validate();
+  // note! a late response must never be routed to a (possibly recycled) session
+  CHECK(harness.response(request_id_1) == 0);
+  CHECK(harness.response(request_id_4) == 2);
+  harness.advance(REQUEST_TIMEOUT);
+  CHECK(std::empty(harness.expired));
+  CHECK(std::empty(harness.router));
+  harness.validate();
+}
+
+TEST_CASE("proxy_tools_router_disconnect_mid_order", "[fix_proxy_tools_router]") {
+  Harness harness;
+  auto request_id_1 = harness.request(1, "order-1"sv, true);
+  auto request_id_2 = harness.request(1, "order-2"sv, true);
+  auto request_id_3 = harness.request(2, "order-1"sv, true);
+  harness.advance(1s);
+  harness.disconnect(1);
+  CHECK(std::size(harness.cleared) == 2);
+  CHECK(harness.router.find(request_id_1) == nullptr);
+  CHECK(harness.router.find(request_id_2) == nullptr);
+  CHECK(harness.router.find(request_id_3) != nullptr);
+  harness.validate();
+  // note! late responses for the disconnected session are dropped
+  CHECK(harness.response(request_id_1) == 0);
+  CHECK(harness.response(request_id_3) == 2);
+  // note! the released timers must never fire
+  harness.advance(REQUEST_TIMEOUT);
+  CHECK(std::empty(harness.expired));
+  harness.disconnect(1);
+  harness.validate();
+  CHECK(std::empty(harness.router));
+}
+
+TEST_CASE("proxy_tools_router_timeout", "[fix_proxy_tools_router]") {
+  Harness harness;
+  auto request_id_1 = harness.request(1, "abc"sv);
+  harness.advance(2s);
+  auto request_id_2 = harness.request(1, "def"sv);
+  harness.advance(REQUEST_TIMEOUT - 2s);
+  CHECK(std::empty(harness.expired));
+  harness.advance(200ms);
+  REQUIRE(std::size(harness.expired) == 1);
+  CHECK(harness.expired[0] == request_id_1);
+  CHECK(std::empty(harness.router.find(1, "abc"sv)));
+  harness.validate();
+  harness.advance(2s);
+  REQUIRE(std::size(harness.expired) == 2);
+  CHECK(harness.expired[1] == request_id_2);
+  harness.validate();
+  CHECK(std::empty(harness.router));
+}
+
+TEST_CASE("proxy_tools_router_storm", "[fix_proxy_tools_router]") {
+  Harness harness;
+  auto const sessions = uint64_t{8};
+  auto const requests = size_t{10000};
+  for (size_t i = 0; i < requests; ++i)
+    harness.request(1 + (i % sessions), fmt::format("req-{}"sv, i / sessions));
+  CHECK(std::size(harness.router) == requests);
+  harness.validate();
+  for (uint64_t session_id = 1; session_id <= sessions; session_id += 2)
+    harness.disconnect(session_id);
+  CHECK(std::size(harness.cleared) == requests / 2);
+  harness.validate();
+  harness.advance(REQUEST_TIMEOUT + 1s);
+  CHECK(std::size(harness.expired) == requests / 2);
+  harness.validate();
+  CHECK(std::empty(harness.router));
+  CHECK(std::empty(harness.timeouts));
+}
+
+TEST_CASE("proxy_tools_router_random", "[fix_proxy_tools_router]") {
+  for (auto seed : {1u, 2u, 3u, 42u, 1234u}) {
+    Harness harness;
+    std::mt19937 generator{seed};
+    std::discrete_distribution<int> operation{60, 25, 3, 12};
+    std::uniform_int_distribution<uint64_t> session{1, 5};
+    std::uniform_int_distribution<int> req_id{0, 49};  // note! small range to force duplicates
+    std::uniform_int_distribution<int> delay{0, 1000};
+    std::vector<std::string> outstanding;
+    for (size_t i = 0; i < 20000; ++i) {
+      switch (operation(generator)) {
+        case 0: {
+          auto request_id = harness.request(session(generator), fmt::format("{}"sv, req_id(generator)));
+          if (!std::empty(request_id))
+            outstanding.emplace_back(std::move(request_id));
+          break;
+        }
+        case 1:
+          if (!std::empty(outstanding)) {
+            // note! might already have been released by disconnect or timeout
+            std::uniform_int_distribution<size_t> index{0, std::size(outstanding) - 1};
+            auto iter = std::begin(outstanding) + index(generator);
+            harness.response(*iter);
+            outstanding.erase(iter);
+          }
+          break;
+        case 2:
+          harness.disconnect(session(generator));
+          break;
+        case 3:
+          harness.advance(std::chrono::milliseconds{delay(generator)});
+          break;
+      }
+      harness.validate();
+    }
+    harness.advance(REQUEST_TIMEOUT + 1s);
+    harness.validate();
+    CHECK(std::empty(harness.router));
+  }
+}
@@ -0,0 +1,30 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+#include "roq/proxy/fix/tools/sending_time.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+using namespace roq::proxy::fix;
+
+TEST_CASE("proxy_tools_sending_time_simple", "[fix_proxy_tools_sending_time]") {
+  tools::SendingTime sending_time;
+  auto now = 1704067200123ms;  // 2024-01-01 00:00:00.123
+  CHECK(sending_time(now) == "20240101-00:00:00.123"sv);
+  CHECK(sending_time(now + 500us) == "20240101-00:00:00.123"sv);
+  CHECK(sending_time(now + 1ms) == "20240101-00:00:00.124"sv);
+  CHECK(sending_time(now + 1s) == "20240101-00:00:01.123"sv);
+  CHECK(sending_time(now + 24h + 12h + 34min + 56s + 666ms) == "20240102-12:34:56.789"sv);
+}
+
+TEST_CASE("proxy_tools_sending_time_backwards", "[fix_proxy_tools_sending_time]") {
+  tools::SendingTime sending_time;
+  auto now = 1704067200123ms;
+  CHECK(sending_time(now) == "20240101-00:00:00.123"sv);
+  CHECK(sending_time(now - 1s) == "20231231-23:59:59.123"sv);
+  CHECK(sending_time(now) == "20240101-00:00:00.123"sv);
+}
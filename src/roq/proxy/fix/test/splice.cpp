@@ -0,0 +1,274 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "roq/proxy/fix/tools/splice.hpp"
+
+#include "roq/proxy/fix/test/message.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+using namespace roq::proxy::fix;
+using namespace roq::proxy::fix::test;
+
+TEST_CASE("proxy_tools_splice_get_message_length", "[fix_proxy_tools_splice]") {
+  auto message = create_message("35=0\x01"
+                                "49=abc\x01"
+                                "56=def\x01"
+                                "34=1\x01"
+                                "52=20240101-00:00:00.000\x01"sv);
+  auto buffer = message + "8=FIX.4.4\x01"s;
+  CHECK(tools::Splice::get_message_length(to_span(buffer)) == std::size(message));
+  auto partial = message.substr(0, std::size(message) - 1);
+  CHECK(tools::Splice::get_message_length(to_span(partial)) == 0);
+  CHECK(tools::Splice::get_message_length({}) == 0);
+}
+
+TEST_CASE("proxy_tools_splice_encode", "[fix_proxy_tools_splice]") {
+  auto message = create_message("35=8\x01"
+                                "49=bridge\x01"
+                                "56=proxy\x01"
+                                "34=123\x01"
+                                "52=20240101-00:00:00.000\x01"
+                                "37=order-1\x01"
+                                "11=proxy-client:abc\x01"
+                                "41=proxy-client:xyz\x01"
+                                "453=1\x01"
+                                "448=client\x01"
+                                "447=D\x01"
+                                "452=3\x01"
+                                "17=exec-1\x01"
+                                "150=F\x01"
+                                "39=2\x01"
+                                "55=BTC-PERPETUAL\x01"
+                                "54=1\x01"
+                                "32=1\x01"
+                                "31=100\x01"sv);
+  auto comp_ids = tools::Splice::create_comp_ids("proxy"sv, "client"sv);
+  auto header = tools::Splice::Header{
+      .comp_ids = comp_ids,
+      .msg_seq_num = 42,
+      .sending_time = "20240101-00:00:00.123"sv,
+  };
+  std::array<tools::Splice::Replacement, 2> replacements{{
+      {11, "abc"sv},
+      {41, {}},  // note! removed
+  }};
+  std::vector<std::byte> buffer(4096);
+  auto result = tools::Splice::encode(buffer, to_span(message), header, replacements);
+  auto expected = create_message("35=8\x01"
+                                 "49=proxy\x01"
+                                 "56=client\x01"
+                                 "34=42\x01"
+                                 "52=20240101-00:00:00.123\x01"
+                                 "37=order-1\x01"
+                                 "11=abc\x01"
+                                 "17=exec-1\x01"
+                                 "150=F\x01"
+                                 "39=2\x01"
+                                 "55=BTC-PERPETUAL\x01"
+                                 "54=1\x01"
+                                 "32=1\x01"
+                                 "31=100\x01"sv);
+  CHECK(to_string_view(result) == expected);
+  CHECK(tools::Splice::get_message_length(result) == std::size(result));
+}
+
+TEST_CASE("proxy_tools_splice_encode_keep_party_ids", "[fix_proxy_tools_splice]") {
+  auto message = create_message("35=8\x01"
+                                "49=bridge\x01"
+                                "56=proxy\x01"
+                                "34=123\x01"
+                                "52=20240101-00:00:00.000\x01"
+                                "11=abc\x01"
+                                "453=1\x01"
+                                "448=client\x01"
+                                "447=D\x01"
+                                "452=3\x01"
+                                "39=0\x01"sv);
+  auto comp_ids = tools::Splice::create_comp_ids("bridge"sv, "proxy"sv);
+  auto header = tools::Splice::Header{
+      .comp_ids = comp_ids,
+      .msg_seq_num = 1,
+      .sending_time = "20240101-00:00:01.000"sv,
+  };
+  std::vector<std::byte> buffer(4096);
+  auto result = tools::Splice::encode(buffer, to_span(message), header, {}, false);
+  auto expected = create_message("35=8\x01"
+                                 "49=bridge\x01"
+                                 "56=proxy\x01"
+                                 "34=1\x01"
+                                 "52=20240101-00:00:01.000\x01"
+                                 "11=abc\x01"
+                                 "453=1\x01"
+                                 "448=client\x01"
+                                 "447=D\x01"
+                                 "452=3\x01"
+                                 "39=0\x01"sv);
+  CHECK(to_string_view(result) == expected);
+}
+
+TEST_CASE("proxy_tools_splice_encode_party_sub_ids", "[fix_proxy_tools_splice]") {
+  auto message = create_message("35=8\x01"
+                                "49=bridge\x01"
+                                "56=proxy\x01"
+                                "34=123\x01"
+                                "52=20240101-00:00:00.000\x01"
+                                "11=abc\x01"
+                                "453=2\x01"
+                                "448=client\x01"
+                                "447=D\x01"
+                                "452=3\x01"
+                                "802=1\x01"
+                                "523=desk-1\x01"
+                                "803=9\x01"
+                                "448=trader\x01"
+                                "447=D\x01"
+                                "452=11\x01"
+                                "39=0\x01"sv);
+  auto comp_ids = tools::Splice::create_comp_ids("proxy"sv, "client"sv);
+  auto header = tools::Splice::Header{
+      .comp_ids = comp_ids,
+      .msg_seq_num = 1,
+      .sending_time = "20240101-00:00:01.000"sv,
+  };
+  std::vector<std::byte> buffer(4096);
+  auto result = tools::Splice::encode(buffer, to_span(message), header, {});
+  auto expected = create_message("35=8\x01"
+                                 "49=proxy\x01"
+                                 "56=client\x01"
+                                 "34=1\x01"
+                                 "52=20240101-00:00:01.000\x01"
+                                 "11=abc\x01"
+                                 "39=0\x01"sv);
+  CHECK(to_string_view(result) == expected);
+}
+
+TEST_CASE("proxy_tools_splice_encode_session_header", "[fix_proxy_tools_splice]") {
+  // note! possdup/resend and routing fields must never leak to another counterparty
+  auto message = create_message("35=8\x01"
+                                "49=bridge\x01"
+                                "56=proxy\x01"
+                                "34=123\x01"
+                                "43=Y\x01"
+                                "97=Y\x01"
+                                "50=bridge-sub\x01"
+                                "57=proxy-sub\x01"
+                                "115=other\x01"
+                                "128=elsewhere\x01"
+                                "52=20240101-00:00:00.000\x01"
+                                "122=20231231-23:59:59.000\x01"
+                                "11=abc\x01"
+                                "39=0\x01"sv);
+  auto comp_ids = tools::Splice::create_comp_ids("proxy"sv, "client"sv);
+  auto header = tools::Splice::Header{
+      .comp_ids = comp_ids,
+      .msg_seq_num = 7,
+      .sending_time = "20240101-00:00:01.000"sv,
+  };
+  std::vector<std::byte> buffer(4096);
+  auto result = tools::Splice::encode(buffer, to_span(message), header, {});
+  auto expected = create_message("35=8\x01"
+                                 "49=proxy\x01"
+                                 "56=client\x01"
+                                 "34=7\x01"
+                                 "52=20240101-00:00:01.000\x01"
+                                 "11=abc\x01"
+                                 "39=0\x01"sv);
+  CHECK(to_string_view(result) == expected);
+}
+
+TEST_CASE("proxy_tools_splice_reframe", "[fix_proxy_tools_splice]") {
+  // note! as encoded without comp ids, msg_seq_num or sending time
+  auto message = create_message("35=8\x01"
+                                "49=\x01"
+                                "56=\x01"
+                                "34=0\x01"
+                                "52=19700101-00:00:00.000\x01"
+                                "11=abc\x01"
+                                "39=0\x01"sv);
+  std::vector<std::byte> buffer(tools::Splice::HEADROOM + std::size(message));
+  auto tmp = to_span(message);
+  std::copy(std::begin(tmp), std::end(tmp), std::begin(buffer) + tools::Splice::HEADROOM);
+  auto encoded = std::span<std::byte const>{buffer}.subspan(tools::Splice::HEADROOM);
+  auto comp_ids = tools::Splice::create_comp_ids("proxy"sv, "client"sv);
+  auto header = tools::Splice::Header{
+      .comp_ids = comp_ids,
+      .msg_seq_num = 42,
+      .sending_time = "20240101-00:00:00.123"sv,
+  };
+  auto result = tools::Splice::reframe(buffer, encoded, header);
+  auto expected = create_message("35=8\x01"
+                                 "49=proxy\x01"
+                                 "56=client\x01"
+                                 "34=42\x01"
+                                 "52=20240101-00:00:00.123\x01"
+                                 "11=abc\x01"
+                                 "39=0\x01"sv);
+  CHECK(to_string_view(result) == expected);
+  // note! no headroom
+  std::vector<std::byte> buffer_2(std::begin(tmp), std::end(tmp));
+  CHECK_THROWS_AS(tools::Splice::reframe(buffer_2, buffer_2, header), std::length_error);
+}
+
+TEST_CASE("proxy_tools_splice_find", "[fix_proxy_tools_splice]") {
+  auto message = create_message("35=X\x01"
+                                "49=bridge\x01"
+                                "56=proxy\x01"
+                                "34=1\x01"
+                                "52=20240101-00:00:00.000\x01"
+                                "262=proxy-123\x01"
+                                "268=1\x01"
+                                "279=0\x01"
+                                "269=0\x01"
+                                "270=100\x01"sv);
+  CHECK(tools::Splice::find(to_span(message), 262) == "proxy-123"sv);
+  CHECK(tools::Splice::find(to_span(message), 270) == "100"sv);
+  CHECK(std::empty(tools::Splice::find(to_span(message), 11)));
+}
+
+TEST_CASE("proxy_tools_splice_for_each", "[fix_proxy_tools_splice]") {
+  auto message = create_message("35=X\x01"
+                                "49=bridge\x01"
+                                "56=proxy\x01"
+                                "34=1\x01"
+                                "52=20240101-00:00:00.000\x01"
+                                "268=2\x01"
+                                "279=0\x01"
+                                "269=2\x01"
+                                "270=100\x01"
+                                "279=0\x01"
+                                "269=2\x01"
+                                "270=101\x01"sv);
+  std::vector<std::pair<uint32_t, std::string>> result;
+  tools::Splice::for_each(to_span(message), [&](auto tag, auto &value) { result.emplace_back(tag, value); });
+  REQUIRE(std::size(result) == 14);
+  CHECK(result[0].first == 8);
+  CHECK(result[1].first == 9);
+  CHECK(result[2] == std::pair<uint32_t, std::string>{35, "X"});
+  CHECK(result[10] == std::pair<uint32_t, std::string>{270, "100"});
+  CHECK(result[13] == std::pair<uint32_t, std::string>{270, "101"});
+}
+
+TEST_CASE("proxy_tools_splice_buffer_too_small", "[fix_proxy_tools_splice]") {
+  auto message = create_message("35=0\x01"
+                                "49=abc\x01"
+                                "56=def\x01"
+                                "34=1\x01"
+                                "52=20240101-00:00:00.000\x01"sv);
+  auto comp_ids = tools::Splice::create_comp_ids("proxy"sv, "client"sv);
+  auto header = tools::Splice::Header{
+      .comp_ids = comp_ids,
+      .msg_seq_num = 1,
+      .sending_time = "20240101-00:00:00.000"sv,
+  };
+  std::vector<std::byte> buffer(40);
+  CHECK_THROWS(tools::Splice::encode(buffer, to_span(message), header, {}));
+}
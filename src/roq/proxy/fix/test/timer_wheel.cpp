@@ -0,0 +1,99 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <vector>
+
+#include "roq/proxy/fix/tools/timer_wheel.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+using namespace roq::proxy::fix;
+
+TEST_CASE("proxy_tools_timer_wheel_simple", "[fix_proxy_tools_timer_wheel]") {
+  tools::TimerWheel<int> timer_wheel{10ms};
+  auto now = 1000s;
+  std::vector<int> result;
+  auto callback = [&](auto value) { result.emplace_back(value); };
+  timer_wheel.add(now, now + 50ms, 1);
+  timer_wheel.add(now, now + 20ms, 2);
+  timer_wheel.add(now, now + 2s, 3);
+  timer_wheel.add(now, now + 1h, 4);
+  CHECK(std::size(timer_wheel) == 4);
+  timer_wheel(now + 10ms, callback);
+  CHECK(std::empty(result));
+  timer_wheel(now + 60ms, callback);
+  REQUIRE(std::size(result) == 2);
+  CHECK(result[0] == 2);
+  CHECK(result[1] == 1);
+  timer_wheel(now + 2s, callback);
+  CHECK(std::size(result) == 2);
+  timer_wheel(now + 2010ms, callback);
+  REQUIRE(std::size(result) == 3);
+  CHECK(result[2] == 3);
+  timer_wheel(now + 1h, callback);
+  CHECK(std::size(result) == 3);
+  timer_wheel(now + 1h + 10ms, callback);
+  REQUIRE(std::size(result) == 4);
+  CHECK(result[3] == 4);
+  CHECK(std::empty(timer_wheel));
+}
+
+TEST_CASE("proxy_tools_timer_wheel_remove", "[fix_proxy_tools_timer_wheel]") {
+  tools::TimerWheel<int> timer_wheel{10ms};
+  auto now = 1000s;
+  std::vector<int> result;
+  auto callback = [&](auto value) { result.emplace_back(value); };
+  auto handle_1 = timer_wheel.add(now, now + 100ms, 1);
+  auto handle_2 = timer_wheel.add(now, now + 100ms, 2);
+  CHECK(timer_wheel.remove(handle_1) == true);
+  CHECK(timer_wheel.remove(handle_1) == false);
+  // note! re-uses the released node
+  auto handle_3 = timer_wheel.add(now, now + 200ms, 3);
+  CHECK(handle_3 != handle_1);
+  CHECK(timer_wheel.remove(handle_1) == false);
+  timer_wheel(now + 110ms, callback);
+  REQUIRE(std::size(result) == 1);
+  CHECK(result[0] == 2);
+  CHECK(timer_wheel.remove(handle_2) == false);
+  CHECK(timer_wheel.remove(handle_3) == true);
+  timer_wheel(now + 1s, callback);
+  CHECK(std::size(result) == 1);
+  CHECK(std::empty(timer_wheel));
+}
+
+TEST_CASE("proxy_tools_timer_wheel_reentrant", "[fix_proxy_tools_timer_wheel]") {
+  tools::TimerWheel<int> timer_wheel{10ms};
+  auto now = 1000s;
+  std::vector<int> result;
+  timer_wheel.add(now, now + 10ms, 1);
+  auto callback = [&](auto value) {
+    result.emplace_back(value);
+    if (value < 3)
+      timer_wheel.add(now, now + 100ms, value + 1);
+  };
+  timer_wheel(now + 1s, callback);
+  REQUIRE(std::size(result) == 3);
+  CHECK(result[2] == 3);
+}
+
+TEST_CASE("proxy_tools_timer_wheel_reentrant_current_tick", "[fix_proxy_tools_timer_wheel]") {
+  tools::TimerWheel<int> timer_wheel{10ms};
+  auto now = 1000s;
+  std::vector<int> result;
+  timer_wheel.add(now, now + 10ms, 1);
+  // note! always re-arms with an expiry which has already passed
+  auto callback = [&](auto value) {
+    result.emplace_back(value);
+    timer_wheel.add(now, now, value + 1);
+  };
+  timer_wheel(now + 20ms, callback);
+  REQUIRE(std::size(result) == 1);
+  CHECK(result[0] == 1);
+  CHECK(std::size(timer_wheel) == 1);
+  timer_wheel(now + 30ms, callback);
+  REQUIRE(std::size(result) == 2);
+  CHECK(result[1] == 2);
+  CHECK(std::size(timer_wheel) == 1);
+}
@@ -0,0 +1,58 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "roq/proxy/fix/tools/token_bucket.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+using namespace roq::proxy::fix;
+
+TEST_CASE("proxy_tools_token_bucket_unlimited", "[fix_proxy_tools_token_bucket]") {
+  tools::TokenBucket token_bucket;
+  CHECK(token_bucket.unlimited());
+  auto now = 1000s;
+  for (size_t i = 0; i < 1000; ++i)
+    CHECK(token_bucket(now));
+}
+
+TEST_CASE("proxy_tools_token_bucket_burst", "[fix_proxy_tools_token_bucket]") {
+  tools::TokenBucket token_bucket{10, 5};
+  CHECK(!token_bucket.unlimited());
+  auto now = 1000s;
+  // note! starts full
+  for (size_t i = 0; i < 5; ++i)
+    CHECK(token_bucket(now));
+  CHECK(!token_bucket(now));
+  // note! one token per 100ms
+  CHECK(!token_bucket(now + 99ms));
+  CHECK(token_bucket(now + 100ms));
+  CHECK(!token_bucket(now + 100ms));
+  // note! never more than burst
+  now += 1h;
+  for (size_t i = 0; i < 5; ++i)
+    CHECK(token_bucket(now));
+  CHECK(!token_bucket(now));
+}
+
+TEST_CASE("proxy_tools_token_bucket_rate", "[fix_proxy_tools_token_bucket]") {
+  tools::TokenBucket token_bucket{1000, 0};  // note! burst defaults to rate
+  auto now = 1000s;
+  auto count = size_t{};
+  // note! offered 10 per millisecond for one second
+  for (size_t i = 0; i < 10000; ++i)
+    if (token_bucket(now + std::chrono::microseconds{i * 100}))
+      ++count;
+  CHECK(count >= 1999);  // burst + rate
+  CHECK(count <= 2000);
+}
+
+TEST_CASE("proxy_tools_token_bucket_clock_going_backwards", "[fix_proxy_tools_token_bucket]") {
+  tools::TokenBucket token_bucket{1, 1};
+  auto now = 1000s;
+  CHECK(token_bucket(now));
+  CHECK(!token_bucket(now - 10s));
+  CHECK(!token_bucket(now + 999ms));
+  CHECK(token_bucket(now + 1s));
+}
@@ -0,0 +1,144 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/tools/capture.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+using namespace std::literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// === CONSTANTS ===
+
+namespace {
+auto const IDLE_SLEEP = 1ms;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+auto open_file(auto &path, auto mode) {
+  auto result = std::fopen(std::string{path}.c_str(), mode);
+  if (result == nullptr)
+    throw std::system_error{errno, std::generic_category(), std::string{path}};
+  return result;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Capture::Capture(std::string_view const &path, size_t buffer_size)
+    : file_{open_file(path, "wb")}, buffer_(std::bit_ceil(std::max(buffer_size, size_t{4096}))),
+      mask_{std::size(buffer_) - 1}, thread_{[this]() { run(); }} {
+}
+
+Capture::~Capture() {
+  stop_.store(true, std::memory_order_release);
+  thread_.join();
+  std::fclose(file_);
+}
+
+void Capture::operator()(
+    Direction direction,
+    uint64_t session_id,
+    std::chrono::nanoseconds timestamp,
+    std::span<std::byte const> const &message) {
+  if (error_.load(std::memory_order_relaxed)) [[unlikely]]
+    return;
+  auto header = Header{
+      .length = static_cast<uint32_t>(std::size(message)),
+      .direction = direction,
+      .session_id = session_id,
+      .timestamp = timestamp.count(),
+  };
+  auto length = sizeof(Header) + std::size(message);
+  auto head = head_.load(std::memory_order_relaxed);
+  auto tail = tail_.load(std::memory_order_acquire);
+  if ((head - tail + length) > std::size(buffer_)) [[unlikely]] {
+    ++dropped_;
+    return;
+  }
+  auto copy = [&](auto offset, auto const &data) {
+    auto position = (head + offset) & mask_;
+    auto first = std::min(std::size(data), std::size(buffer_) - position);
+    std::memcpy(&buffer_[position], std::data(data), first);
+    std::memcpy(&buffer_[0], std::data(data) + first, std::size(data) - first);
+  };
+  copy(0, std::span{reinterpret_cast<std::byte const *>(&header), sizeof(Header)});
+  copy(sizeof(Header), message);
+  head_.store(head + length, std::memory_order_release);
+}
+
+void Capture::flush() {
+  while (tail_.load(std::memory_order_acquire) != head_.load(std::memory_order_relaxed) && !error())
+    std::this_thread::sleep_for(IDLE_SLEEP);
+}
+
+void Capture::write(std::span<std::byte const> const &data) {
+  if (std::fwrite(std::data(data), 1, std::size(data), file_) != std::size(data))
+    throw std::system_error{errno, std::generic_category(), "fwrite"};
+}
+
+// note! background thread
+
+// note! an exception must never escape the thread (std::terminate)
+void Capture::run() {
+  try {
+    while (!stop_.load(std::memory_order_acquire))
+      if (!drain())
+        std::this_thread::sleep_for(IDLE_SLEEP);
+    drain();
+  } catch (std::system_error &e) {
+    auto error = e.code().value();
+    error_.store(error ? error : EIO, std::memory_order_release);
+  }
+}
+
+bool Capture::drain() {
+  auto head = head_.load(std::memory_order_acquire);
+  auto tail = tail_.load(std::memory_order_relaxed);
+  if (head == tail)
+    return false;
+  auto position = tail & mask_;
+  auto length = head - tail;
+  auto first = std::min(length, std::size(buffer_) - position);
+  auto data = std::span<std::byte const>{buffer_};
+  write(data.subspan(position, first));
+  write(data.subspan(0, length - first));
+  if (std::fflush(file_) != 0)
+    throw std::system_error{errno, std::generic_category(), "fflush"};
+  tail_.store(head, std::memory_order_release);
+  return true;
+}
+
+// reader
+
+Capture::Reader::Reader(std::string_view const &path) : file_{open_file(path, "rb")} {
+}
+
+Capture::Reader::~Reader() {
+  std::fclose(file_);
+}
+
+bool Capture::Reader::operator()(Header &header, std::span<std::byte const> &message) {
+  if (std::fread(&header, sizeof(Header), 1, file_) != 1)
+    return false;
+  buffer_.resize(header.length);
+  if (std::fread(std::data(buffer_), 1, header.length, file_) != header.length)
+    return false;  // note! truncated
+  message = buffer_;
+  return true;
+}
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
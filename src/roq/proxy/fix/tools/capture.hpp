@@ -0,0 +1,101 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// note!
+// binary capture of raw fix messages
+// the event loop copies each message into a single-producer/single-consumer ring buffer
+// a background thread drains the ring to file, the event loop never blocks on i/o
+// messages are dropped (and counted) if the ring buffer is full
+// capturing stops if the background thread fails to write (the error is reported, see error())
+// file format: sequence of (Header, raw message bytes)
+
+struct Capture final {
+  enum class Direction : uint8_t {
+    UNDEFINED,
+    CLIENT_INBOUND,
+    CLIENT_OUTBOUND,
+    SERVER_INBOUND,
+    SERVER_OUTBOUND,
+  };
+
+  struct Header final {
+    uint32_t length = {};  // note! excluding header
+    Direction direction = {};
+    uint8_t padding[3] = {};
+    uint64_t session_id = {};
+    int64_t timestamp = {};  // note! nanoseconds since epoch
+  };
+
+  static_assert(sizeof(Header) == 24);
+
+  // note! buffer_size is rounded up to the next power of two
+  Capture(std::string_view const &path, size_t buffer_size);
+
+  Capture(Capture &&) = delete;
+  Capture(Capture const &) = delete;
+
+  ~Capture();
+
+  void operator()(
+      Direction, uint64_t session_id, std::chrono::nanoseconds timestamp, std::span<std::byte const> const &message);
+
+  uint64_t dropped() const { return dropped_; }
+
+  // note! errno of the write failure (zero if capturing)
+  int error() const { return error_.load(std::memory_order_acquire); }
+
+  // note! flushes everything captured so far (blocking, intended for shutdown and testing)
+  void flush();
+
+  struct Reader final {
+    explicit Reader(std::string_view const &path);
+
+    Reader(Reader &&) = delete;
+    Reader(Reader const &) = delete;
+
+    ~Reader();
+
+    // note! message is only valid until the next call
+    bool operator()(Header &, std::span<std::byte const> &message);
+
+   private:
+    std::FILE *file_ = nullptr;
+    std::vector<std::byte> buffer_;
+  };
+
+ protected:
+  void write(std::span<std::byte const> const &);
+  void run();
+  bool drain();
+
+ private:
+  std::FILE *const file_;
+  std::vector<std::byte> buffer_;
+  uint64_t const mask_;
+  alignas(64) std::atomic<uint64_t> head_ = {};  // note! producer
+  alignas(64) std::atomic<uint64_t> tail_ = {};  // note! consumer
+  uint64_t dropped_ = {};
+  std::atomic<bool> stop_ = {};
+  std::atomic<int> error_ = {};
+  std::thread thread_;
+};
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
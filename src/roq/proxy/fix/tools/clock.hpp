@@ -0,0 +1,46 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+
+#include "roq/clock.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// note!
+// coarse clock, sampled once per io callback and then read by everything dispatched from that callback
+// realtime is derived from the monotonic clock using an offset which is re-calibrated periodically
+// exact timestamps (latency tracing) should still use TraceInfo or roq::clock directly
+
+struct Clock final {
+  Clock() { calibrate(); }
+
+  Clock(Clock &&) = delete;
+  Clock(Clock const &) = delete;
+
+  std::chrono::nanoseconds update() {
+    system_ = clock::get_system();
+    return system_;
+  }
+
+  void calibrate() {
+    system_ = clock::get_system();
+    offset_ = clock::get_realtime() - system_;
+  }
+
+  std::chrono::nanoseconds get_system() const { return system_; }
+  std::chrono::nanoseconds get_realtime() const { return system_ + offset_; }
+
+ private:
+  std::chrono::nanoseconds system_ = {};
+  std::chrono::nanoseconds offset_ = {};
+};
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -47,12 +47,7 @@ bool Crypto::validate(
     case UNDEFINED:
       return password == secret;
     case HMAC_SHA256: {
-      MAC mac{secret};  // alloc
-      // mac.clear();
-      mac.update(raw_data);
-      auto digest = mac.final(digest_);
-      std::string signature;
-      utils::codec::Base64::encode(signature, digest, false, false);  // alloc
+      auto signature = sign(secret, raw_data);
       auto result = signature == password;
       log::warn(R"(DEBUG computed="{}, received="{}")"sv, signature, password);
       return result;
@@ -71,12 +66,7 @@ bool Crypto::validate(
         log::warn("DEBUG now={}, sending_time_utc={}"sv, now, sending_time_utc);
         return false;
       }
-      MAC mac{secret};  // alloc
-      // mac.clear();
-      mac.update(raw_data);
-      auto digest = mac.final(digest_);
-      std::string signature;
-      utils::codec::Base64::encode(signature, digest, false, false);  // alloc
+      auto signature = sign(secret, raw_data);
       if (signature != password) {
         log::warn(R"(DEBUG computed="{}", password="{}")"sv, signature, password);
         return false;
@@ -87,6 +77,16 @@ bool Crypto::validate(
   log::fatal("Unexpected"sv);
 }
 
+std::string Crypto::sign(std::string_view const &secret, std::string_view const &raw_data) {
+  MAC mac{secret};  // alloc
+  // mac.clear();
+  mac.update(raw_data);
+  auto digest = mac.final(digest_);
+  std::string result;
+  utils::codec::Base64::encode(result, digest, false, false);  // alloc
+  return result;
+}
+
 }  // namespace tools
 }  // namespace fix
 }  // namespace proxy
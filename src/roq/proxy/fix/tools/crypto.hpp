@@ -3,6 +3,7 @@
 #pragma once
 
 #include <chrono>
+#include <string>
 #include <string_view>
 
 #include "roq/utils/hash/sha256.hpp"
@@ -25,12 +26,17 @@ struct Crypto final {
 
   bool validate(std::string_view const &password, std::string_view const &secret, std::string_view const &raw_data);
 
+  // note! base64 encoded signature of raw_data (what a client would send as password)
+  std::string sign(std::string_view const &secret, std::string_view const &raw_data);
+
   enum class Method {
     UNDEFINED,
     HMAC_SHA256,
     HMAC_SHA256_TS,
   };
 
+  Method method() const { return method_; }
+
  private:
   Method const method_;
   std::chrono::nanoseconds const timestamp_tolerance_;
@@ -0,0 +1,81 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "roq/utils/container.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// note!
+// username => accounts
+// - accounts are mapped to a dense id so each user's entitlements is a bitset
+// - users without accounts are not restricted
+// - an empty account is left to the fix-bridge
+
+struct Entitlements final {
+  static constexpr size_t const MAX_ACCOUNTS = 1024;
+
+  // returns false if there are too many accounts
+  template <typename T>
+  bool add(std::string_view const &username, T const &accounts) {
+    if (std::empty(accounts))
+      return true;
+    std::bitset<MAX_ACCOUNTS> entitlements;
+    for (auto &account : accounts) {
+      auto iter = account_to_id_.find(account);
+      if (iter == std::end(account_to_id_)) {
+        if (std::size(account_to_id_) >= MAX_ACCOUNTS)
+          return false;
+        iter = account_to_id_.try_emplace(std::string{account}, static_cast<uint32_t>(std::size(account_to_id_))).first;
+      }
+      entitlements.set((*iter).second);
+    }
+    auto iter = username_to_entitlements_.find(username);
+    if (iter == std::end(username_to_entitlements_))
+      iter = username_to_entitlements_.try_emplace(std::string{username}).first;
+    (*iter).second |= entitlements;
+    return true;
+  }
+
+  bool operator()(std::string_view const &username, std::string_view const &account) const {
+    if (std::empty(account))
+      return true;
+    auto iter_1 = username_to_entitlements_.find(username);
+    if (iter_1 == std::end(username_to_entitlements_))
+      return true;
+    auto iter_2 = account_to_id_.find(account);
+    if (iter_2 == std::end(account_to_id_))
+      return false;
+    return (*iter_1).second.test((*iter_2).second);
+  }
+
+  // note! only true if the account has been configured for the user (users without accounts are never explicit)
+  bool is_explicit(std::string_view const &username, std::string_view const &account) const {
+    auto iter_1 = username_to_entitlements_.find(username);
+    if (iter_1 == std::end(username_to_entitlements_))
+      return false;
+    auto iter_2 = account_to_id_.find(account);
+    if (iter_2 == std::end(account_to_id_))
+      return false;
+    return (*iter_1).second.test((*iter_2).second);
+  }
+
+ private:
+  // account => account_id (dense)
+  utils::unordered_map<std::string, uint32_t> account_to_id_;
+  // username => account_id's
+  utils::unordered_map<std::string, std::bitset<MAX_ACCOUNTS>> username_to_entitlements_;
+};
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
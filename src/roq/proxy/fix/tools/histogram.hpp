@@ -0,0 +1,73 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// note!
+// exact latency distribution (all samples are kept)
+// intended for offline tools (replay, load generation), not for the proxy itself
+
+struct Histogram final {
+  bool empty() const { return std::empty(samples_); }
+  size_t size() const { return std::size(samples_); }
+
+  void operator()(std::chrono::nanoseconds value) {
+    samples_.emplace_back(value);
+    sorted_ = false;
+  }
+
+  // note! keeps the allocated memory
+  void clear() {
+    samples_.clear();
+    sorted_ = true;
+  }
+
+  // note! percentile in the range [0, 100]
+  std::chrono::nanoseconds percentile(double value) {
+    assert(value >= 0.0 && value <= 100.0);
+    if (std::empty(samples_))
+      return {};
+    sort();
+    auto index = static_cast<size_t>(std::ceil(value / 100.0 * static_cast<double>(std::size(samples_))));
+    return samples_[std::clamp<size_t>(index, 1, std::size(samples_)) - 1];
+  }
+
+  std::chrono::nanoseconds min() { return percentile(0.0); }
+  std::chrono::nanoseconds max() { return percentile(100.0); }
+
+  std::chrono::nanoseconds mean() const {
+    if (std::empty(samples_))
+      return {};
+    std::chrono::nanoseconds sum = {};
+    for (auto &item : samples_)
+      sum += item;
+    return sum / std::size(samples_);
+  }
+
+ protected:
+  void sort() {
+    if (sorted_)
+      return;
+    std::sort(std::begin(samples_), std::end(samples_));
+    sorted_ = true;
+  }
+
+ private:
+  std::vector<std::chrono::nanoseconds> samples_;
+  bool sorted_ = true;
+};
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
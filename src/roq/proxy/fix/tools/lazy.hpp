@@ -0,0 +1,67 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "roq/fix/message.hpp"
+
+#include "roq/proxy/fix/tools/splice.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// note!
+// defers decoding of a fix message until the body is actually needed
+// routing fields can be looked up directly from the raw message
+// only valid for the duration of the callback (references the parser's message and decode buffer)
+
+template <typename T>
+struct Lazy final {
+  using value_type = T;
+
+  Lazy(
+      roq::fix::Message const &message, std::span<std::byte const> const &raw, std::vector<std::byte> &decode_buffer)
+      : message_{message}, raw_{raw}, decode_buffer_{decode_buffer} {}
+
+  Lazy(Lazy &&) = delete;
+  Lazy(Lazy const &) = delete;
+
+  std::span<std::byte const> raw() const { return raw_; }
+
+  std::string_view find(uint32_t tag) const { return Splice::find(raw_, tag); }
+
+  T const &get() const {
+    if (!value_)
+      value_.emplace(T::create(message_, decode_buffer_));
+    return *value_;
+  }
+
+ private:
+  roq::fix::Message const &message_;
+  std::span<std::byte const> const raw_;
+  std::vector<std::byte> &decode_buffer_;
+  mutable std::optional<T> value_;
+};
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
+
+template <typename T>
+struct fmt::formatter<roq::proxy::fix::tools::Lazy<T>> {
+  constexpr auto parse(format_parse_context &context) { return std::begin(context); }
+  auto format(roq::proxy::fix::tools::Lazy<T> const &value, format_context &context) const {
+    using namespace std::literals;
+    return fmt::format_to(context.out(), "{}"sv, value.get());
+  }
+};
@@ -0,0 +1,154 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/utils/container.hpp"
+
+#include "roq/fix/msg_type.hpp"
+
+#include "roq/proxy/fix/tools/splice.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// note!
+// priority outbox
+// - messages are held while an inbound batch is being processed and flushed in priority order when the batch ends
+// - a batch is one read from the socket, messages are never held across batches (or until the socket is writable)
+// - session messages and cancels are never held (they are already ahead of anything pending)
+// - a cancel (or a cancel reject) is held behind the order (or execution report) it refers to, if that is still held
+// - a mass cancel (or a mass cancel report) is held if any order (or execution report) is still held
+// - messages are held encoded with headroom, the owner must reframe when flushing (see Splice::reframe)
+// - ordering is only preserved within a priority
+
+struct Outbox final {
+  enum class Priority : uint8_t {
+    SESSION,
+    CANCELS,
+    ORDERS,  // note! also execution reports and everything not classified
+    MARKET_DATA,
+  };
+
+  static constexpr Priority get_priority(roq::fix::MsgType msg_type) {
+    switch (msg_type) {
+      using enum roq::fix::MsgType;
+      case HEARTBEAT:
+      case TEST_REQUEST:
+      case RESEND_REQUEST:
+      case REJECT:
+      case LOGON:
+      case LOGOUT:
+        return Priority::SESSION;
+      case ORDER_CANCEL_REQUEST:
+      case ORDER_MASS_CANCEL_REQUEST:
+      case ORDER_CANCEL_REJECT:
+      case ORDER_MASS_CANCEL_REPORT:
+        return Priority::CANCELS;
+      case SECURITY_LIST_REQUEST:
+      case SECURITY_LIST:
+      case SECURITY_DEFINITION_REQUEST:
+      case SECURITY_DEFINITION:
+      case SECURITY_STATUS_REQUEST:
+      case SECURITY_STATUS:
+      case MARKET_DATA_REQUEST:
+      case MARKET_DATA_REQUEST_REJECT:
+      case MARKET_DATA_SNAPSHOT_FULL_REFRESH:
+      case MARKET_DATA_INCREMENTAL_REFRESH:
+        return Priority::MARKET_DATA;
+      default:
+        return Priority::ORDERS;
+    }
+  }
+
+  // note! a cancel is demoted if the order it refers to is still held
+  template <typename T>
+  Priority get_priority(T const &value) const {
+    auto priority = get_priority(T::MSG_TYPE);
+    if (priority != Priority::CANCELS)
+      return priority;
+    if constexpr (requires { value.orig_cl_ord_id; }) {
+      if (pending_.find(value.orig_cl_ord_id) != std::end(pending_))
+        return Priority::ORDERS;
+    } else {
+      if (!std::empty(pending_))
+        return Priority::ORDERS;
+    }
+    return priority;
+  }
+
+  // returns true if a message must be held (only while a batch is being processed)
+  static constexpr bool hold(Priority priority) { return priority > Priority::CANCELS; }
+
+  bool empty() const { return empty_; }
+
+  void clear() {
+    for (auto &buffer : buffers_)
+      buffer.clear();
+    pending_.clear();
+    empty_ = true;
+  }
+
+  // note! message is copied after Splice::HEADROOM reserved bytes so it can later be reframed in-place
+  template <typename T>
+  void push(Priority priority, std::span<std::byte const> const &message, [[maybe_unused]] T const &value) {
+    assert(hold(priority));
+    auto &buffer = buffers_[static_cast<size_t>(priority)];
+    buffer.resize(std::size(buffer) + Splice::HEADROOM);
+    buffer.insert(std::end(buffer), std::begin(message), std::end(message));
+    if (priority == Priority::ORDERS) {
+      if constexpr (requires { value.cl_ord_id; }) {
+        if (!std::empty(value.cl_ord_id))
+          pending_.emplace(value.cl_ord_id);
+      }
+      if constexpr (requires { value.orig_cl_ord_id; }) {
+        if (!std::empty(value.orig_cl_ord_id))
+          pending_.emplace(value.orig_cl_ord_id);
+      }
+    }
+    empty_ = false;
+  }
+
+  // callback(buffer, message) is invoked for each message, highest priority first
+  // note! buffer is the writable range (headroom and message) to be passed to Splice::reframe
+  template <typename Callback>
+  void flush(Callback callback) {
+    if (empty_)
+      return;
+    for (auto &buffer : buffers_) {
+      std::span<std::byte> remaining{buffer};
+      while (!std::empty(remaining)) {
+        assert(std::size(remaining) > Splice::HEADROOM);
+        auto length = Splice::get_message_length(remaining.subspan(Splice::HEADROOM));
+        assert(length > 0);
+        auto buffer_2 = remaining.subspan(0, Splice::HEADROOM + length);
+        std::span<std::byte const> message = buffer_2.subspan(Splice::HEADROOM);
+        callback(buffer_2, message);
+        remaining = remaining.subspan(std::size(buffer_2));
+      }
+      buffer.clear();  // note! keeps capacity
+    }
+    pending_.clear();
+    empty_ = true;
+  }
+
+ private:
+  std::array<std::vector<std::byte>, 4> buffers_;
+  // note! cl_ord_id's (and orig_cl_ord_id's) held with priority ORDERS
+  utils::unordered_set<std::string> pending_;
+  bool empty_ = true;
+};
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,180 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "roq/utils/container.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// note!
+// bi-directional req_id routing table
+// - server side req_ids are unique (generated by the proxy)
+// - client side req_ids are only unique per session (and optional, routes without are indexed by session only)
+// the maps are always kept consistent: every route has exactly one reverse entry (needed to clear a session)
+
+struct Router final {
+  struct Route final {
+    uint64_t session_id = {};
+    std::string req_id;  // client
+    bool keep_alive = {};
+    uint32_t remaining = {};  // note! outstanding reports, only used by pos_req_id
+    uint64_t timeout = {};    // note! timer handle, cancelled by the first response
+  };
+
+  bool empty() const { return std::empty(server_to_client_); }
+  size_t size() const { return std::size(server_to_client_); }
+
+  // note! returns false (and does nothing) if either req_id is already in use
+  bool add(
+      std::string_view const &req_id_client,
+      std::string_view const &req_id_server,
+      uint64_t session_id,
+      bool keep_alive) {
+    if (server_to_client_.find(req_id_server) != std::end(server_to_client_))
+      return false;
+    if (std::empty(req_id_client)) {
+      session_to_server_[session_id].emplace(req_id_server);
+    } else {
+      auto &tmp = client_to_server_[session_id];
+      if (!tmp.emplace(req_id_client, req_id_server).second)
+        return false;
+    }
+    server_to_client_.emplace(
+        req_id_server,
+        Route{
+            .session_id = session_id,
+            .req_id = std::string{req_id_client},
+            .keep_alive = keep_alive,
+        });
+    return true;
+  }
+
+  Route *find(std::string_view const &req_id_server) {
+    auto iter = server_to_client_.find(req_id_server);
+    if (iter == std::end(server_to_client_))
+      return nullptr;
+    return &(*iter).second;
+  }
+
+  Route const *find(std::string_view const &req_id_server) const {
+    auto iter = server_to_client_.find(req_id_server);
+    if (iter == std::end(server_to_client_))
+      return nullptr;
+    return &(*iter).second;
+  }
+
+  // returns the server side req_id (empty if not found)
+  std::string_view find(uint64_t session_id, std::string_view const &req_id_client) const {
+    auto iter_1 = client_to_server_.find(session_id);
+    if (iter_1 == std::end(client_to_server_))
+      return {};
+    auto iter_2 = (*iter_1).second.find(req_id_client);
+    if (iter_2 == std::end((*iter_1).second))
+      return {};
+    return (*iter_2).second;
+  }
+
+  // note! callback(route) is invoked before the route is released
+  template <typename Callback>
+  bool remove(std::string_view const &req_id_server, Callback callback) {
+    auto iter_1 = server_to_client_.find(req_id_server);
+    if (iter_1 == std::end(server_to_client_))
+      return false;
+    auto &route = (*iter_1).second;
+    callback(route);
+    if (std::empty(route.req_id)) {
+      erase(session_to_server_, route.session_id, (*iter_1).first);
+    } else {
+      erase(client_to_server_, route.session_id, route.req_id);
+    }
+    server_to_client_.erase(iter_1);
+    return true;
+  }
+
+  // note! callback(req_id_server, route) is invoked before each route is released
+  template <typename Callback>
+  void clear(uint64_t session_id, Callback callback) {
+    auto release = [&](auto &req_id) {
+      auto iter = server_to_client_.find(req_id);
+      if (iter == std::end(server_to_client_))
+        return;
+      callback(req_id, (*iter).second);
+      server_to_client_.erase(iter);
+    };
+    auto iter_1 = client_to_server_.find(session_id);
+    if (iter_1 != std::end(client_to_server_)) {
+      for (auto &[_, req_id] : (*iter_1).second)
+        release(req_id);
+      client_to_server_.erase(iter_1);
+    }
+    auto iter_2 = session_to_server_.find(session_id);
+    if (iter_2 != std::end(session_to_server_)) {
+      for (auto &req_id : (*iter_2).second)
+        release(req_id);
+      session_to_server_.erase(iter_2);
+    }
+  }
+
+  // note! callback(req_id_server, route) must not add or remove routes
+  template <typename Callback>
+  void get_all(Callback callback) const {
+    for (auto &[req_id_server, route] : server_to_client_)
+      callback(req_id_server, route);
+  }
+
+  // returns false if the reverse indices are not consistent with the routes
+  bool validate() const {
+    auto count = size_t{};
+    for (auto &[session_id, tmp] : client_to_server_) {
+      if (std::empty(tmp))
+        return false;  // note! stale session
+      for (auto &[req_id_client, req_id_server] : tmp) {
+        auto route = find(req_id_server);
+        if (route == nullptr || (*route).session_id != session_id || (*route).req_id != req_id_client)
+          return false;
+        ++count;
+      }
+    }
+    for (auto &[session_id, tmp] : session_to_server_) {
+      if (std::empty(tmp))
+        return false;  // note! stale session
+      for (auto &req_id_server : tmp) {
+        auto route = find(req_id_server);
+        if (route == nullptr || (*route).session_id != session_id || !std::empty((*route).req_id))
+          return false;
+        ++count;
+      }
+    }
+    return count == std::size(server_to_client_);  // note! every route has exactly one reverse entry
+  }
+
+ protected:
+  static void erase(auto &index, uint64_t session_id, std::string const &key) {
+    auto iter = index.find(session_id);
+    if (iter == std::end(index))
+      return;
+    (*iter).second.erase(key);
+    if (std::empty((*iter).second))
+      index.erase(iter);
+  }
+
+ private:
+  // req_id(server) => route
+  utils::unordered_map<std::string, Route> server_to_client_;
+  // session_id => req_id(client) => req_id(server)
+  utils::unordered_map<uint64_t, utils::unordered_map<std::string, std::string>> client_to_server_;
+  // session_id => req_id(server) (note! only routes without a client req_id)
+  utils::unordered_map<uint64_t, utils::unordered_set<std::string>> session_to_server_;
+};
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,53 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/tools/sending_time.hpp"
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// === HELPERS ===
+
+namespace {
+void format_digits(char *result, int64_t value, size_t width) {
+  for (size_t i = width; i > 0; --i) {
+    result[i - 1] = static_cast<char>('0' + (value % 10));
+    value /= 10;
+  }
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+std::string_view SendingTime::operator()(std::chrono::nanoseconds timestamp) {
+  auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(timestamp).count();
+  if (milliseconds != milliseconds_) {
+    milliseconds_ = milliseconds;
+    auto seconds = milliseconds / 1000;
+    if (seconds != seconds_) {
+      seconds_ = seconds;
+      auto time_point = std::chrono::sys_seconds{std::chrono::seconds{seconds}};
+      auto days = std::chrono::floor<std::chrono::days>(time_point);
+      auto ymd = std::chrono::year_month_day{days};
+      auto hms = std::chrono::hh_mm_ss{time_point - days};
+      format_digits(&buffer_[0], static_cast<int>(ymd.year()), 4);
+      format_digits(&buffer_[4], static_cast<unsigned>(ymd.month()), 2);
+      format_digits(&buffer_[6], static_cast<unsigned>(ymd.day()), 2);
+      buffer_[8] = '-';
+      format_digits(&buffer_[9], hms.hours().count(), 2);
+      buffer_[11] = ':';
+      format_digits(&buffer_[12], hms.minutes().count(), 2);
+      buffer_[14] = ':';
+      format_digits(&buffer_[15], hms.seconds().count(), 2);
+      buffer_[17] = '.';
+    }
+    format_digits(&buffer_[18], milliseconds % 1000, 3);
+  }
+  return {std::data(buffer_), std::size(buffer_)};
+}
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
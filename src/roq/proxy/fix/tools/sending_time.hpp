@@ -0,0 +1,39 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// note!
+// formats UTCTimestamp with millisecond precision, e.g. "20240101-12:34:56.789"
+// the result is cached: same millisecond returns the previous result, same second only rewrites the milliseconds
+
+struct SendingTime final {
+  static constexpr size_t const LENGTH = 21;
+
+  SendingTime() = default;
+
+  SendingTime(SendingTime &&) = delete;
+  SendingTime(SendingTime const &) = delete;
+
+  // note! the result is only valid until the next call
+  std::string_view operator()(std::chrono::nanoseconds timestamp);
+
+ private:
+  int64_t milliseconds_ = -1;
+  int64_t seconds_ = -1;
+  std::array<char, LENGTH> buffer_ = {};
+};
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,351 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/proxy/fix/tools/splice.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// === CONSTANTS ===
+
+namespace {
+auto const SOH = std::byte{0x1};
+
+// note! room for "8=FIX.x.y|9=nnnnnn|"
+auto const MAX_PREFIX_LENGTH = size_t{32};
+
+// note! "10=nnn|"
+auto const CHECKSUM_LENGTH = size_t{7};
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+struct Field final {
+  uint32_t tag = {};
+  std::string_view value;
+};
+
+struct Reader final {
+  explicit Reader(std::span<std::byte const> const &buffer)
+      : buffer_{reinterpret_cast<char const *>(std::data(buffer)), std::size(buffer)} {}
+
+  bool operator()(Field &field) {
+    if (offset_ >= std::size(buffer_))
+      return false;
+    auto tag = uint32_t{};
+    auto begin = std::data(buffer_) + offset_;
+    auto end = std::data(buffer_) + std::size(buffer_);
+    auto [ptr, ec] = std::from_chars(begin, end, tag);
+    if (ec != std::errc{} || ptr == end || *ptr != '=')
+      return false;
+    ++ptr;
+    auto soh = std::find(ptr, end, '\x01');
+    if (soh == end)
+      return false;
+    field.tag = tag;
+    field.value = {ptr, static_cast<size_t>(soh - ptr)};
+    offset_ = static_cast<size_t>(soh - std::data(buffer_)) + 1;
+    return true;
+  }
+
+  size_t offset() const { return offset_; }
+
+ private:
+  std::string_view const buffer_;
+  size_t offset_ = {};
+};
+
+struct Writer final {
+  explicit Writer(std::span<std::byte> const &buffer) : buffer_{buffer} {}
+
+  void operator()(uint32_t tag, std::string_view const &value) {
+    append_number(tag);
+    append('=');
+    append(value);
+    append(SOH);
+  }
+
+  void operator()(uint32_t tag, uint64_t value) {
+    append_number(tag);
+    append('=');
+    append_number(value);
+    append(SOH);
+  }
+
+  void append(char value) { append(static_cast<std::byte>(value)); }
+
+  void append(std::byte value) {
+    if (offset_ >= std::size(buffer_))
+      throw std::length_error{"buffer too small"};
+    buffer_[offset_++] = value;
+  }
+
+  void append(std::string_view const &value) {
+    if ((offset_ + std::size(value)) > std::size(buffer_))
+      throw std::length_error{"buffer too small"};
+    std::memcpy(&buffer_[offset_], std::data(value), std::size(value));
+    offset_ += std::size(value);
+  }
+
+  void append_number(uint64_t value) {
+    std::array<char, 20> tmp;
+    auto [ptr, ec] = std::to_chars(std::data(tmp), std::data(tmp) + std::size(tmp), value);
+    assert(ec == std::errc{});
+    append(std::string_view{std::data(tmp), static_cast<size_t>(ptr - std::data(tmp))});
+  }
+
+  size_t offset() const { return offset_; }
+  void seek(size_t offset) { offset_ = offset; }
+
+ private:
+  std::span<std::byte> const buffer_;
+  size_t offset_ = {};
+};
+
+bool is_party_ids(uint32_t tag) {
+  switch (tag) {
+    case 453:  // NoPartyIDs
+    case 448:  // PartyID
+    case 447:  // PartyIDSource
+    case 452:  // PartyRole
+    case 802:  // NoPartySubIDs
+    case 523:  // PartySubID
+    case 803:  // PartySubIDType
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool is_session_header(uint32_t tag) {
+  switch (tag) {
+    case 8:   // BeginString
+    case 9:   // BodyLength
+    case 35:  // MsgType
+    case 49:  // SenderCompID
+    case 56:  // TargetCompID
+    case 34:  // MsgSeqNum
+    case 52:  // SendingTime
+    case 10:  // CheckSum
+      return true;
+    // note! only meaningful to the original counterparty
+    case 43:   // PossDupFlag
+    case 97:   // PossResend
+    case 122:  // OrigSendingTime
+    case 50:   // SenderSubID
+    case 57:   // TargetSubID
+    case 115:  // OnBehalfOfCompID
+    case 116:  // OnBehalfOfSubID
+    case 128:  // DeliverToCompID
+    case 129:  // DeliverToSubID
+    case 142:  // SenderLocationID
+    case 143:  // TargetLocationID
+    case 144:  // OnBehalfOfLocationID
+    case 145:  // DeliverToLocationID
+    case 369:  // LastMsgSeqNumProcessed
+      return true;
+    default:
+      return false;
+  }
+}
+
+auto find_replacement(auto &replacements, uint32_t tag) -> Splice::Replacement const * {
+  for (auto &item : replacements)
+    if (item.first == tag)
+      return &item;
+  return nullptr;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+size_t Splice::get_message_length(std::span<std::byte const> const &buffer) {
+  Reader reader{buffer};
+  Field field;
+  if (!reader(field) || field.tag != 8)
+    return 0;
+  if (!reader(field) || field.tag != 9)
+    return 0;
+  auto body_length = size_t{};
+  auto [ptr, ec] = std::from_chars(std::data(field.value), std::data(field.value) + std::size(field.value), body_length);
+  if (ec != std::errc{})
+    return 0;
+  auto result = reader.offset() + body_length + CHECKSUM_LENGTH;
+  if (result > std::size(buffer))
+    return 0;
+  return result;
+}
+
+std::string Splice::create_comp_ids(std::string_view const &sender_comp_id, std::string_view const &target_comp_id) {
+  std::string result;
+  result.reserve(std::size(sender_comp_id) + std::size(target_comp_id) + 8);
+  result.append("49="sv).append(sender_comp_id).push_back('\x01');
+  result.append("56="sv).append(target_comp_id).push_back('\x01');
+  return result;
+}
+
+std::string_view Splice::find(std::span<std::byte const> const &message, uint32_t tag) {
+  Reader reader{message};
+  Field field;
+  while (reader(field)) {
+    if (field.tag == tag)
+      return field.value;
+    if (field.tag == 10)
+      break;
+  }
+  return {};
+}
+
+bool Splice::next(
+    std::span<std::byte const> const &message, size_t &offset, uint32_t &tag, std::string_view &value) {
+  if (offset >= std::size(message))
+    return false;
+  Reader reader{message.subspan(offset)};
+  Field field;
+  if (!reader(field))
+    return false;
+  tag = field.tag;
+  value = field.value;
+  offset += reader.offset();
+  return true;
+}
+
+std::span<std::byte const> Splice::encode(
+    std::span<std::byte> const &buffer,
+    std::span<std::byte const> const &message,
+    Header const &header,
+    std::span<Replacement const> const &replacements,
+    bool strip_party_ids) {
+  Reader reader{message};
+  Field field;
+  if (!reader(field) || field.tag != 8)
+    throw std::invalid_argument{"expected BeginString"};
+  auto begin_string = field.value;
+  if (!reader(field) || field.tag != 9)
+    throw std::invalid_argument{"expected BodyLength"};
+  if (!reader(field) || field.tag != 35)
+    throw std::invalid_argument{"expected MsgType"};
+  auto msg_type = field.value;
+  // body
+  Writer writer{buffer};
+  writer.seek(MAX_PREFIX_LENGTH);
+  writer(35, msg_type);
+  writer.append(header.comp_ids);
+  writer(34, header.msg_seq_num);
+  writer(52, header.sending_time);
+  while (reader(field)) {
+    if (field.tag == 10)
+      break;
+    if (is_session_header(field.tag) || (strip_party_ids && is_party_ids(field.tag)))
+      continue;
+    auto replacement = find_replacement(replacements, field.tag);
+    if (replacement == nullptr) {
+      writer(field.tag, field.value);
+    } else if (!std::empty((*replacement).second)) {
+      writer(field.tag, (*replacement).second);
+    }
+  }
+  if (field.tag != 10)
+    throw std::invalid_argument{"expected CheckSum"};
+  auto body_end = writer.offset();
+  auto body_length = body_end - MAX_PREFIX_LENGTH;
+  // prefix
+  std::array<std::byte, MAX_PREFIX_LENGTH> prefix;
+  Writer writer_2{prefix};
+  writer_2(8, begin_string);
+  writer_2(9, static_cast<uint64_t>(body_length));
+  auto prefix_length = writer_2.offset();
+  auto begin = MAX_PREFIX_LENGTH - prefix_length;
+  std::memcpy(&buffer[begin], std::data(prefix), prefix_length);
+  // checksum
+  uint32_t checksum = {};
+  for (auto i = begin; i < body_end; ++i)
+    checksum += static_cast<uint8_t>(buffer[i]);
+  checksum %= 256;
+  writer.append("10="sv);
+  std::array<char, 3> tmp{
+      static_cast<char>('0' + checksum / 100),
+      static_cast<char>('0' + (checksum / 10) % 10),
+      static_cast<char>('0' + checksum % 10),
+  };
+  writer.append(std::string_view{std::data(tmp), std::size(tmp)});
+  writer.append(SOH);
+  return buffer.subspan(begin, writer.offset() - begin);
+}
+
+std::span<std::byte const> Splice::reframe(
+    std::span<std::byte> const &buffer, std::span<std::byte const> const &message, Header const &header) {
+  assert(std::data(message) >= std::data(buffer));
+  auto offset = static_cast<size_t>(std::data(message) - std::data(buffer));
+  assert((offset + std::size(message)) <= std::size(buffer));
+  Reader reader{message};
+  Field field;
+  if (!reader(field) || field.tag != 8)
+    throw std::invalid_argument{"expected BeginString"};
+  auto begin_string = field.value;
+  if (!reader(field) || field.tag != 9)
+    throw std::invalid_argument{"expected BodyLength"};
+  if (!reader(field) || field.tag != 35)
+    throw std::invalid_argument{"expected MsgType"};
+  auto msg_type = field.value;
+  auto body_begin = reader.offset();
+  while (reader(field) && field.tag != 10 && is_session_header(field.tag))
+    body_begin = reader.offset();
+  if (std::size(message) < (body_begin + CHECKSUM_LENGTH))
+    throw std::invalid_argument{"expected CheckSum"};
+  auto body_end = std::size(message) - CHECKSUM_LENGTH;
+  // checksum (of the body only)
+  auto checksum_field = std::string_view{
+      reinterpret_cast<char const *>(std::data(message)) + body_end, CHECKSUM_LENGTH};
+  if (!checksum_field.starts_with("10="sv))
+    throw std::invalid_argument{"expected CheckSum"};
+  auto checksum = uint32_t{};
+  auto [ptr, ec] = std::from_chars(std::data(checksum_field) + 3, std::data(checksum_field) + 6, checksum);
+  if (ec != std::errc{})
+    throw std::invalid_argument{"expected CheckSum"};
+  for (size_t i = 0; i < body_begin; ++i)
+    checksum += 256 - static_cast<uint8_t>(message[i]);
+  // header (note! string views are referencing the original header, must be consumed before it's overwritten)
+  std::array<std::byte, HEADROOM> inner;
+  Writer writer{inner};
+  writer(35, msg_type);
+  writer.append(header.comp_ids);
+  writer(34, header.msg_seq_num);
+  writer(52, header.sending_time);
+  auto inner_length = writer.offset();
+  std::array<std::byte, MAX_PREFIX_LENGTH> prefix;
+  Writer writer_2{prefix};
+  writer_2(8, begin_string);
+  writer_2(9, static_cast<uint64_t>(inner_length + (body_end - body_begin)));
+  auto prefix_length = writer_2.offset();
+  auto header_length = prefix_length + inner_length;
+  if (header_length > (offset + body_begin))
+    throw std::length_error{"insufficient headroom"};
+  auto begin = offset + body_begin - header_length;
+  std::memcpy(&buffer[begin], std::data(prefix), prefix_length);
+  std::memcpy(&buffer[begin + prefix_length], std::data(inner), inner_length);
+  for (size_t i = 0; i < header_length; ++i)
+    checksum += static_cast<uint8_t>(buffer[begin + i]);
+  checksum %= 256;
+  auto end = offset + std::size(message);
+  buffer[end - 4] = static_cast<std::byte>('0' + checksum / 100);
+  buffer[end - 3] = static_cast<std::byte>('0' + (checksum / 10) % 10);
+  buffer[end - 2] = static_cast<std::byte>('0' + checksum % 10);
+  return buffer.subspan(begin, end - begin);
+}
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,76 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// note!
+// re-frames a raw fix message without decoding it
+// - session header (49, 56, 34, 52) is replaced (49 and 56 are copied from a pre-serialized prefix)
+// - other session header fields (e.g. 43, 97, 122, 50, 57, 115, 128) are dropped
+// - tags found in the replacement list have their value replaced (or dropped, if the new value is empty)
+// - party ids (453, 448, 447, 452, including sub-ids 802, 523, 803) are stripped (unless requested otherwise)
+// - body length (9) and checksum (10) are recomputed
+// all other fields are copied as-is and in the original order
+// reframe only replaces the session header, in-place, of a message which was encoded with headroom
+
+struct Splice final {
+  // note! room reserved in front of an encoded message (see reframe)
+  static constexpr size_t const HEADROOM = 256;
+
+  struct Header final {
+    std::string_view comp_ids;  // note! see create_comp_ids
+    uint64_t msg_seq_num = {};
+    std::string_view sending_time;  // note! see SendingTime
+  };
+
+  // returns "49=sender_comp_id|56=target_comp_id|", intended to be created once per session
+  static std::string create_comp_ids(std::string_view const &sender_comp_id, std::string_view const &target_comp_id);
+
+  using Replacement = std::pair<uint32_t, std::string_view>;
+
+  // returns the length of the first complete message (0 if incomplete)
+  static size_t get_message_length(std::span<std::byte const> const &buffer);
+
+  // returns the value of the first occurrence of tag (empty if not found)
+  static std::string_view find(std::span<std::byte const> const &message, uint32_t tag);
+
+  // reads the field at offset and advances offset (returns false when there are no more fields)
+  static bool next(std::span<std::byte const> const &message, size_t &offset, uint32_t &tag, std::string_view &value);
+
+  // callback(tag, value) is invoked for each field up to (but not including) the checksum
+  template <typename Callback>
+  static void for_each(std::span<std::byte const> const &message, Callback callback) {
+    auto offset = size_t{};
+    auto tag = uint32_t{};
+    std::string_view value;
+    while (next(message, offset, tag, value) && tag != 10)
+      callback(tag, value);
+  }
+
+  static std::span<std::byte const> encode(
+      std::span<std::byte> const &buffer,
+      std::span<std::byte const> const &message,
+      Header const &,
+      std::span<Replacement const> const &replacements,
+      bool strip_party_ids = true);
+
+  // note! message must be located within buffer, at an offset of at least HEADROOM
+  // the body is not copied and the checksum is adjusted (only the header is scanned)
+  static std::span<std::byte const> reframe(
+      std::span<std::byte> const &buffer, std::span<std::byte const> const &message, Header const &);
+};
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,220 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// note!
+// hierarchical timer wheel (4 levels of 64 slots)
+// nodes are allocated from a slab and linked into intrusive lists
+// add, remove and expiry are O(1), advancing is O(1) per tick (amortized for cascading)
+// handles are generation counted so a stale handle can never remove a re-used node
+// timers never fire early: expiry is rounded up to the next tick
+// timers added from a callback never fire before the next tick (the current slot is being drained)
+
+template <typename T>
+struct TimerWheel final {
+  using Handle = uint64_t;  // note! 0 is never a valid handle
+
+  static constexpr size_t const LEVELS = 4;
+  static constexpr size_t const SLOT_BITS = 6;
+  static constexpr size_t const SLOTS = size_t{1} << SLOT_BITS;
+  static constexpr uint64_t const SLOT_MASK = SLOTS - 1;
+  static constexpr uint64_t const MAX_TICKS = (uint64_t{1} << (LEVELS * SLOT_BITS)) - 1;
+
+  explicit TimerWheel(std::chrono::nanoseconds resolution) : resolution_{resolution} {
+    assert(resolution_.count() > 0);
+    for (auto &level : levels_)
+      level.fill(NIL);
+  }
+
+  TimerWheel(TimerWheel &&) = delete;
+  TimerWheel(TimerWheel const &) = delete;
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  // note! now is only used to start the wheel
+  Handle add(std::chrono::nanoseconds now, std::chrono::nanoseconds expiry, T &&value) {
+    start(now);
+    auto index = allocate();
+    auto &node = nodes_[index];
+    node.value = std::move(value);
+    node.expiry = std::max(to_ticks(expiry) + 1, current_ + (draining_ ? 1 : 0));
+    insert(index);
+    ++size_;
+    return create_handle(index, node.generation);
+  }
+
+  bool remove(Handle handle) {
+    auto index = find(handle);
+    if (index == NIL)
+      return false;
+    unlink(index);
+    release(index);
+    --size_;
+    return true;
+  }
+
+  // note! callback may add or remove timers
+  template <typename Callback>
+  void operator()(std::chrono::nanoseconds now, Callback callback) {
+    if (start(now))
+      return;
+    auto target = to_ticks(now);
+    while (current_ <= target) {
+      if (size_ == 0) {
+        current_ = target + 1;  // note! nothing can fire, skip ahead
+        break;
+      }
+      cascade();
+      auto &head = levels_[0][current_ & SLOT_MASK];
+      draining_ = true;
+      while (head != NIL) {
+        auto index = head;
+        unlink(index);
+        auto value = std::move(nodes_[index].value);
+        release(index);
+        --size_;
+        callback(value);
+      }
+      draining_ = false;
+      ++current_;
+    }
+  }
+
+ protected:
+  static constexpr uint32_t const NIL = std::numeric_limits<uint32_t>::max();
+
+  struct Node final {
+    T value = {};
+    uint64_t expiry = {};
+    uint32_t generation = {};
+    uint32_t prev = NIL;
+    uint32_t next = NIL;
+    uint32_t *slot = nullptr;  // note! nullptr when free
+  };
+
+  bool start(std::chrono::nanoseconds now) {
+    if (initialized_)
+      return false;
+    initialized_ = true;
+    current_ = to_ticks(now);
+    return true;
+  }
+
+  uint64_t to_ticks(std::chrono::nanoseconds value) const {
+    return static_cast<uint64_t>(value.count() / resolution_.count());
+  }
+
+  static Handle create_handle(uint32_t index, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | (static_cast<uint64_t>(index) + 1);
+  }
+
+  uint32_t find(Handle handle) const {
+    if (handle == 0)
+      return NIL;
+    auto index = static_cast<uint32_t>((handle & 0xFFFFFFFF) - 1);
+    auto generation = static_cast<uint32_t>(handle >> 32);
+    if (index >= std::size(nodes_))
+      return NIL;
+    auto &node = nodes_[index];
+    if (node.slot == nullptr || node.generation != generation)
+      return NIL;
+    return index;
+  }
+
+  uint32_t allocate() {
+    if (free_ != NIL) {
+      auto index = free_;
+      free_ = nodes_[index].next;
+      nodes_[index].next = NIL;
+      return index;
+    }
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(std::size(nodes_) - 1);
+  }
+
+  void release(uint32_t index) {
+    auto &node = nodes_[index];
+    node.value = {};
+    ++node.generation;
+    node.slot = nullptr;
+    node.prev = NIL;
+    node.next = free_;
+    free_ = index;
+  }
+
+  void insert(uint32_t index) {
+    auto &node = nodes_[index];
+    auto delta = std::min(node.expiry - current_, MAX_TICKS);
+    auto expiry = current_ + delta;
+    size_t level = 0;
+    while (level < (LEVELS - 1) && delta >= (uint64_t{1} << ((level + 1) * SLOT_BITS)))
+      ++level;
+    auto &head = levels_[level][(expiry >> (level * SLOT_BITS)) & SLOT_MASK];
+    node.slot = &head;
+    node.prev = NIL;
+    node.next = head;
+    if (head != NIL)
+      nodes_[head].prev = index;
+    head = index;
+  }
+
+  void unlink(uint32_t index) {
+    auto &node = nodes_[index];
+    assert(node.slot != nullptr);
+    if (node.prev != NIL) {
+      nodes_[node.prev].next = node.next;
+    } else {
+      *node.slot = node.next;
+    }
+    if (node.next != NIL)
+      nodes_[node.next].prev = node.prev;
+    node.prev = NIL;
+    node.next = NIL;
+  }
+
+  // move timers from higher levels when the lower levels wrap around
+  void cascade() {
+    for (size_t level = 1; level < LEVELS; ++level) {
+      if ((current_ & ((uint64_t{1} << (level * SLOT_BITS)) - 1)) != 0)
+        break;
+      auto &head = levels_[level][(current_ >> (level * SLOT_BITS)) & SLOT_MASK];
+      auto index = head;
+      head = NIL;
+      while (index != NIL) {
+        auto next = nodes_[index].next;
+        insert(index);
+        index = next;
+      }
+    }
+  }
+
+ private:
+  std::chrono::nanoseconds const resolution_;
+  std::vector<Node> nodes_;
+  uint32_t free_ = NIL;
+  std::array<std::array<uint32_t, SLOTS>, LEVELS> levels_;
+  uint64_t current_ = {};
+  bool initialized_ = {};
+  bool draining_ = {};
+  size_t size_ = {};
+};
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq
@@ -0,0 +1,58 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace roq {
+namespace proxy {
+namespace fix {
+namespace tools {
+
+// note!
+// token bucket rate limiter
+// - rate is tokens per second, burst is the bucket size (defaults to rate)
+// - credit is kept in nanoseconds so refill is exact integer arithmetic
+// - the bucket starts full
+// - a default constructed bucket never limits
+
+struct TokenBucket final {
+  TokenBucket() = default;
+
+  TokenBucket(uint32_t rate, uint32_t burst)
+      : interval_{rate ? std::chrono::nanoseconds{std::chrono::seconds{1}} / rate : std::chrono::nanoseconds{}},
+        capacity_{interval_ * (burst ? burst : rate)} {}
+
+  bool unlimited() const { return interval_.count() == 0; }
+
+  // returns true if a token was available (and consumed)
+  bool operator()(std::chrono::nanoseconds now) {
+    if (unlimited())
+      return true;
+    if (!started_) {
+      started_ = true;
+      credit_ = capacity_;
+    } else if (now > last_) {
+      credit_ = std::min(capacity_, credit_ + (now - last_));
+    }
+    last_ = std::max(now, last_);
+    if (credit_ < interval_)
+      return false;
+    credit_ -= interval_;
+    return true;
+  }
+
+ private:
+  std::chrono::nanoseconds interval_ = {};  // note! cost of one token
+  std::chrono::nanoseconds capacity_ = {};
+  std::chrono::nanoseconds credit_ = {};
+  std::chrono::nanoseconds last_ = {};
+  bool started_ = {};
+};
+
+}  // namespace tools
+}  // namespace fix
+}  // namespace proxy
+}  // namespace roq